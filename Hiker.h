@@ -10,7 +10,7 @@
 #include <string>
 #include <vector>
 #include "shader.h"
-#include "terrain.h"
+#include "heightField.h"
 
 /**
  * @class Hiker
@@ -26,17 +26,17 @@ public:
 
     /**
      * @brief Loads hiker path data from a file and aligns it with the terrain.
-     * @param terrain Reference to the Terrain object for height alignment.
+     * @param terrain Ground the path is aligned to (single heightmap or tiled world).
      * @return True if successful, false otherwise.
      */
-    bool loadPathData(const Terrain& terrain);
+    bool loadPathData(const HeightField& terrain);
 
     /**
      * @brief Updates the hiker's position along the path based on deltaTime.
      * @param deltaTime Time elapsed since the last frame.
-     * @param terrain Reference to the Terrain object for height alignment.
+     * @param terrain Ground used for height alignment.
      */
-    void updatePosition(float deltaTime, const Terrain& terrain);
+    void updatePosition(float deltaTime, const HeightField& terrain);
 
     /**
      * @brief Renders the hiker's path as a red line.
@@ -56,6 +56,13 @@ public:
      * @return Current position as a glm::vec3.
      */
     glm::vec3 getPosition() const;
+
+    /**
+     * @brief Predicts where the hiker will be if it keeps walking along the path.
+     * @param seconds Look-ahead time.
+     * @return Predicted position (path height, not re-sampled from the terrain).
+     */
+    glm::vec3 getPositionAhead(float seconds) const;
     void setScales(float scale);
     /**
      * @brief Sets the horizontal and vertical scaling factors.
@@ -67,7 +74,7 @@ public:
          * @brief Sets the terrain reference for the hiker.
          * @param terrain Pointer to the terrain object.
     */
-    void setTerrain(const Terrain* terrain);
+    void setTerrain(const HeightField* terrain);
     /**
          * @brief Gets the path points.
          * @return Reference to the vector of path points.
@@ -78,7 +85,7 @@ public:
        * @param newSpeed The new speed value.
        */
     void setSpeed(float newSpeed);
-    void validatePath(const Terrain& terrain);
+    void validatePath(const HeightField& terrain);
     /**
          * @brief Moves the hiker forward along the path.
          * @param deltaTime Time elapsed since the last update.
@@ -94,7 +101,7 @@ public:
 private:
     bool movingForward;   
     // References
-    const Terrain* terrainRef;    ///< Pointer to the terrain object.
+    const HeightField* terrainRef; ///< Pointer to the terrain object.
 
     std::string pathFile;               ///< Path to the hiker's path data file.
     std::vector<glm::vec3> pathPoints;  ///< Vector of path points.
@@ -2,11 +2,124 @@
 
 #include "Skybox.h"
 #include "stb_image.h"
+#include "threadPool.h"
+#include "mappedFile.h"
+#include "assetManager.h"
+#include "bakeCache.h"
 #include <iostream>
+#include <fstream>
 #include <vector>
+#include <future>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <array>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+namespace {
+const char kCubemapTag[4] = { 'C', 'U', 'B', 'E' };
+const uint32_t kCubemapVersion = 2;
+const uint32_t kRawFaces = 0;   // Container format of uncompressed faces, else a BlockFormat
+
+/**
+ * @brief Layout of a baked cubemap, followed by every level of face +X, then of -X,
+ *        +Y, -Y, +Z and -Z.
+ */
+struct CubemapHeader {
+    char tag[4];
+    uint32_t version;
+    uint32_t format;     ///< kRawFaces or a BlockFormat.
+    uint32_t size;       ///< Side of level 0.
+    uint32_t channels;   ///< Bytes per texel of raw faces.
+    uint32_t levels;
+    uint64_t sourceKey;  ///< hashFaces() of the faces it was baked from.
+};
+
+struct FaceImage {
+    unsigned char* data = nullptr;
+    int width = 0, height = 0, channels = 0;
+    std::string failure;   ///< Why decoding failed, copied on the decoding thread.
+};
+
+/**
+ * @brief Starts decoding every face on the thread pool. Faces are decoded unflipped
+ *        whatever the global stb_image setting, and stb_image keeps its failure
+ *        reason per thread, so each worker copies its own reason into the result.
+ */
+std::vector<std::future<FaceImage>> decodeFaces(const std::vector<std::string>& faces) {
+    stbi_set_flip_vertically_on_load(false); // Ensure correct orientation
+    std::vector<std::future<FaceImage>> decoded;
+    for (const auto& path : faces) {
+        decoded.push_back(ThreadPool::getInstance().submit([path]() {
+            // Pin the orientation for this thread so other loaders changing the global flag cannot race
+            stbi_set_flip_vertically_on_load_thread(0);
+            FaceImage face;
+            AssetData encoded = AssetManager::getInstance().readFile(path);
+            face.data = !encoded ? nullptr
+                : stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size), &face.width, &face.height, &face.channels, 0);
+            if (!face.data) {
+                face.failure = encoded ? stbi_failure_reason() : "can't read file";
+            }
+            return face;
+        }));
+    }
+    return decoded;
+}
+
+GLenum pixelFormat(int channels) {
+    if (channels == 1)
+        return GL_RED;
+    if (channels == 3)
+        return GL_RGB;
+    if (channels == 4)
+        return GL_RGBA;
+    return 0;
+}
+
+size_t faceLevelBytes(const CubemapHeader& header, int level) {
+    int size = std::max(1, static_cast<int>(header.size) >> level);
+    if (header.format == kRawFaces) {
+        return static_cast<size_t>(size) * size * header.channels;
+    }
+    return TextureCompressor::levelBytes(static_cast<BlockFormat>(header.format), size, size);
+}
+
+/**
+ * @brief Key of the six encoded face files, or 0 if one cannot be read. A container
+ *        stores it to detect when any face changes.
+ */
+uint64_t hashFaces(const std::vector<std::string>& faces) {
+    std::array<uint64_t, 6> keys = {};
+    for (size_t i = 0; i < faces.size() && i < keys.size(); i++) {
+        AssetData encoded = AssetManager::getInstance().readFile(faces[i]);
+        if (!encoded) {
+            return 0;
+        }
+        keys[i] = hashBakeBytes(encoded.data, encoded.size, {});
+    }
+    return hashBakeBytes(reinterpret_cast<const unsigned char*>(keys.data()), sizeof(keys), {});
+}
+
+/**
+ * @brief Reads the header of a container on disk, whatever its version.
+ */
+bool readCubemapHeader(const std::string& containerFile, CubemapHeader& header) {
+    std::ifstream file(containerFile, std::ios::binary);
+    return file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+           std::memcmp(header.tag, kCubemapTag, sizeof(header.tag)) == 0;
+}
+
+std::string withSeparator(const std::string& directory) {
+    // Validate and fix the directory path, relative to the asset root
+    std::string resolved = AssetManager::getInstance().resolve(directory);
+    if (resolved.empty() || resolved.back() == '/' || resolved.back() == '\\') {
+        return resolved;
+    }
+    return resolved + '/';
+}
+}
+
 // Initialize the static instance to nullptr
 Skybox* Skybox::instance = nullptr;
 
@@ -23,7 +136,7 @@ Skybox& Skybox::getInstance() {
 // Constructor
 Skybox::Skybox()
     : VAO(0), VBO(0), cubemapTexture(0), cubemapLoaded(false),
-    skyboxShader("/Users/sumaia/Desktop/triangle/triangle/shaders/skyboxVert.glsl", "/Users/sumaia/Desktop/triangle/triangle/shaders/skyboxFrag.glsl") {}
+    skyboxShader(AssetManager::getInstance().loadShader("shaders/skyboxVert.glsl", "shaders/skyboxFrag.glsl")) {}
 
 // Destructor
 Skybox::~Skybox() {
@@ -41,21 +154,8 @@ bool Skybox::initialize(const std::string& directory) {
 
     std::cout << "INFO: Initializing Skybox VAO, VBO, and cubemap textures." << std::endl;
 
-    // Validate and fix the directory path
-    std::string correctedDirectory = directory;
-    if (directory.back() != '/' && directory.back() != '\\') {
-        correctedDirectory += '/';
-    }
-
     // Define the cubemap faces in the correct order
-    std::vector<std::string> faces = {
-        correctedDirectory + "right.png", // Right
-        correctedDirectory + "left.png", // Left
-        correctedDirectory + "top.png", // Top
-        correctedDirectory + "bottom.png", // Bottom
-        correctedDirectory + "front.png", // Front
-        correctedDirectory + "back.png"  // Back
-    };
+    std::vector<std::string> faces = faceFiles(directory);
 
     // Debugging: Print paths to verify correctness
     std::cout << "INFO: Constructed cubemap faces paths:" << std::endl;
@@ -63,8 +163,32 @@ bool Skybox::initialize(const std::string& directory) {
         std::cout << face << std::endl;
     }
 
-    // Load the cubemap textures
-    cubemapTexture = loadCubemap(faces);
+    // Faces that are already uploaded are shared rather than loaded again
+    std::string container = containerFile(directory);
+    uint64_t sourceKey = hashFaces(faces);
+    if (std::shared_ptr<Texture> live = sourceKey != 0 ? AssetManager::getInstance().findTexture(sourceKey) : nullptr) {
+        sharedCubemap = live;
+        cubemapTexture = live->getID();
+    }
+    else {
+        // A container baked from other faces, or by an older version, is rebaked in its own format
+        CubemapHeader baked;
+        if (sourceKey != 0 && readCubemapHeader(container, baked) &&
+            (baked.version != kCubemapVersion || baked.sourceKey != sourceKey) &&
+            (baked.format == kRawFaces || TextureCompressor::isValidFormat(baked.format))) {
+            std::cout << "INFO: Skybox faces changed since " << container << " was baked, rebaking" << std::endl;
+            bakeCubemap(directory, baked.format != kRawFaces, static_cast<BlockFormat>(baked.format));
+        }
+
+        // Load the cubemap textures, with one read if they were baked
+        cubemapTexture = loadCubemapContainer(container, sourceKey);
+        if (cubemapTexture == 0) {
+            cubemapTexture = loadCubemap(faces);
+        }
+        if (cubemapTexture != 0) {
+            sharedCubemap = AssetManager::getInstance().shareTexture(sourceKey, cubemapTexture);
+        }
+    }
     if (cubemapTexture == 0) {
         std::cerr << "ERROR: Failed to load cubemap textures. Skybox initialization aborted." << std::endl;
         return false;
@@ -143,14 +267,14 @@ bool Skybox::initialize(const std::string& directory) {
     glBindVertexArray(0);
 
     // Verify if shader is loaded
-    if (!skyboxShader.isLoaded()) {
+    if (!skyboxShader->isLoaded()) {
         std::cerr << "ERROR: Skybox shader failed to load." << std::endl;
         return false;
     }
 
     // Set the texture unit for the skybox shader
-    skyboxShader.use();
-    skyboxShader.setInt("skybox", 0);
+    skyboxShader->use();
+    skyboxShader->setInt("skybox", 0);
 
     cubemapLoaded = true;
     std::cout << "INFO: Skybox initialized successfully." << std::endl;
@@ -168,9 +292,9 @@ void Skybox::render(const glm::mat4& view, const glm::mat4& projection) {
 
     glDepthFunc(GL_LEQUAL); // Change depth function so depth test passes when values are equal to depth buffer's content
 
-    skyboxShader.use();
-    skyboxShader.setMat4("view", view);
-    skyboxShader.setMat4("projection", projection);
+    skyboxShader->use();
+    skyboxShader->setMat4("view", view);
+    skyboxShader->setMat4("projection", projection);
 
     // Render skybox cube
     glBindVertexArray(VAO);
@@ -194,52 +318,219 @@ void Skybox::cleanup() {
         glDeleteBuffers(1, &VBO);
         VBO = 0;
     }
-    if (cubemapTexture) {
-        glDeleteTextures(1, &cubemapTexture);
-        cubemapTexture = 0;
-    }
+    // The cubemap is deleted with its last holder
+    sharedCubemap.reset();
+    cubemapTexture = 0;
     std::cout << "INFO: Skybox resources cleaned up." << std::endl;
 }
 
 /**
- * @brief Helper function to load cubemap textures.
+ * @brief Paths of the six cubemap faces in +X, -X, +Y, -Y, +Z, -Z order.
  */
-GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
+std::vector<std::string> Skybox::faceFiles(const std::string& directory) {
+    std::string correctedDirectory = withSeparator(directory);
+    return {
+        correctedDirectory + "right.png", // Right
+        correctedDirectory + "left.png", // Left
+        correctedDirectory + "top.png", // Top
+        correctedDirectory + "bottom.png", // Bottom
+        correctedDirectory + "front.png", // Front
+        correctedDirectory + "back.png"  // Back
+    };
+}
+
+/**
+ * @brief Path of the baked cubemap container in a directory.
+ */
+std::string Skybox::containerFile(const std::string& directory) {
+    return withSeparator(directory) + "skybox.cube";
+}
+
+/**
+ * @brief Bakes the six faces and their mips into one cubemap container.
+ */
+bool Skybox::bakeCubemap(const std::string& directory, bool compress, BlockFormat format) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> faces = faceFiles(directory);
+    std::vector<std::future<FaceImage>> decoded = decodeFaces(faces);
+    std::vector<FaceImage> images;
+    for (auto& face : decoded) {
+        images.push_back(face.get());
+    }
+
+    bool valid = true;
+    for (size_t i = 0; i < images.size(); i++) {
+        if (!images[i].data) {
+            std::cerr << "ERROR: Cubemap texture failed to load at path: " << faces[i]
+                << " with reason: " << images[i].failure << std::endl;
+            valid = false;
+        }
+        else if (images[i].width != images[i].height || images[i].width != images[0].width ||
+                 images[i].channels != images[0].channels || pixelFormat(images[i].channels) == 0) {
+            std::cerr << "ERROR: Cubemap faces must be square with one size and channel count: " << faces[i] << std::endl;
+            valid = false;
+        }
+    }
+
+    // The sky is uploaded unadjusted, so the pipeline only builds the mips
+    ImagePipeline pipeline;
+    std::vector<MipChain> chains(images.size());
+    std::vector<CompressedTexture> compressed(images.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        if (valid) {
+            pipeline.process(images[i].data, images[i].width, images[i].height, images[i].channels, false, chains[i]);
+            if (compress) {
+                TextureCompressor::encode(chains[i], format, compressed[i]);
+            }
+        }
+        stbi_image_free(images[i].data);
+    }
+    if (!valid) {
+        return false;
+    }
+
+    CubemapHeader header;
+    std::memcpy(header.tag, kCubemapTag, sizeof(header.tag));
+    header.version = kCubemapVersion;
+    header.format = compress ? static_cast<uint32_t>(format) : kRawFaces;
+    header.size = static_cast<uint32_t>(images[0].width);
+    header.channels = static_cast<uint32_t>(images[0].channels);
+    header.levels = static_cast<uint32_t>(chains[0].getLevels());
+    header.sourceKey = hashFaces(faces);
+
+    std::string path = containerFile(directory);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < images.size(); i++) {
+        const std::vector<unsigned char>& data = compress ? compressed[i].data : chains[i].texels;
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+    if (!file) {
+        std::cerr << "ERROR: Failed to write cubemap container: " << path << std::endl;
+        return false;
+    }
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Baked " << path << " (" << header.levels << " levels" << (compress ? ", compressed" : "")
+        << ") in " << bakeMs << " ms" << std::endl;
+    return true;
+}
+
+/**
+ * @brief Uploads a baked cubemap container from one memory mapping.
+ */
+GLuint Skybox::loadCubemapContainer(const std::string& containerFile, uint64_t sourceKey) {
+    // Read in place from the asset archive when packed, else from a mapping of the file
+    AssetData archived;
+    MappedFile file;
+    if (!AssetManager::getInstance().findArchived(containerFile, archived) && !file.open(containerFile)) {
+        return 0;
+    }
+    const unsigned char* bytes = file.isOpen() ? file.data() : archived.data;
+    size_t byteCount = file.isOpen() ? file.size() : archived.size;
+    CubemapHeader header;
+    if (byteCount < sizeof(header)) {
+        return 0;
+    }
+    std::memcpy(&header, bytes, sizeof(header));
+    bool raw = header.format == kRawFaces;
+    if (std::memcmp(header.tag, kCubemapTag, sizeof(header.tag)) != 0 || header.version != kCubemapVersion ||
+        header.size == 0 || header.levels == 0 || header.levels > 32 ||
+        (raw ? pixelFormat(header.channels) == 0 : !TextureCompressor::isValidFormat(header.format))) {
+        std::cerr << "ERROR: Invalid cubemap container: " << containerFile << std::endl;
+        return 0;
+    }
+    if (sourceKey == 0 || header.sourceKey != sourceKey) {
+        std::cout << "INFO: Cubemap container is older than its faces, decoding faces" << std::endl;
+        return 0;
+    }
+    size_t expected = sizeof(header);
+    for (uint32_t level = 0; level < header.levels; level++) {
+        expected += 6 * faceLevelBytes(header, level);
+    }
+    if (byteCount != expected) {
+        std::cerr << "ERROR: Truncated cubemap container: " << containerFile << std::endl;
+        return 0;
+    }
+    if (!raw && !TextureCompressor::isSupported(static_cast<BlockFormat>(header.format))) {
+        std::cout << "INFO: Cubemap container format is not supported by this context, decoding faces" << std::endl;
+        return 0;
+    }
+    if (file.isOpen()) {
+        file.adviseSequential();
+    }
+
     GLuint textureID;
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    stbi_set_flip_vertically_on_load(false); // Ensure correct orientation
-    for (GLuint i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        if (data) {
-            GLenum format;
-            if (nrChannels == 1)
-                format = GL_RED;
-            else if (nrChannels == 3)
-                format = GL_RGB;
-            else if (nrChannels == 4)
-                format = GL_RGBA;
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const unsigned char* data = bytes + sizeof(header);
+    for (GLuint i = 0; i < 6; i++) {
+        for (uint32_t level = 0; level < header.levels; level++) {
+            GLsizei size = std::max(1, static_cast<int>(header.size) >> level);
+            GLsizei levelBytes = static_cast<GLsizei>(faceLevelBytes(header, level));
+            if (raw) {
+                GLenum format = pixelFormat(header.channels);
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level, format, size, size, 0, format, GL_UNSIGNED_BYTE, data);
+            }
             else {
-                std::cerr << "ERROR: Unknown number of channels in texture: " << faces[i] << std::endl;
-                stbi_image_free(data);
-                glDeleteTextures(1, &textureID);
-                return 0;
+                glCompressedTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, level,
+                    TextureCompressor::internalFormat(static_cast<BlockFormat>(header.format)), size, size, 0, levelBytes, data);
             }
+            data += levelBytes;
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
-                0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    // Set texture parameters; the baked mips keep the sky from shimmering when minified
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, header.levels - 1);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, header.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            stbi_image_free(data);
-        }
-        else {
+    // Prevent seams
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    std::cout << "INFO: Cubemap loaded from " << containerFile << std::endl;
+    return textureID;
+}
+
+/**
+ * @brief Helper function to load cubemap textures.
+ */
+GLuint Skybox::loadCubemap(const std::vector<std::string>& faces) {
+    // Decode every face concurrently and upload them in order as they finish
+    std::vector<std::future<FaceImage>> decoded = decodeFaces(faces);
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    bool failed = false;
+    for (GLuint i = 0; i < decoded.size(); i++) {
+        FaceImage face = decoded[i].get();
+        GLenum format = pixelFormat(face.channels);
+        if (!face.data) {
             std::cerr << "ERROR: Cubemap texture failed to load at path: " << faces[i]
-                << " with reason: " << stbi_failure_reason() << std::endl;
-            stbi_image_free(data);
-            glDeleteTextures(1, &textureID); // Clean up partially loaded texture
-            return 0;
+                << " with reason: " << face.failure << std::endl;
+            failed = true;
+        }
+        else if (format == 0) {
+            std::cerr << "ERROR: Unknown number of channels in texture: " << faces[i] << std::endl;
+            failed = true;
         }
+        else if (!failed) {
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
+                0, format, face.width, face.height, 0, format, GL_UNSIGNED_BYTE, face.data);
+        }
+        // Faces still decoding after a failure are drained so none of them leak
+        stbi_image_free(face.data);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (failed) {
+        glDeleteTextures(1, &textureID); // Clean up partially loaded texture
+        return 0;
     }
 
     // Set texture parameters
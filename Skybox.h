@@ -5,8 +5,11 @@
 
 #include <string>
 #include <vector>
+#include <memory>
 #include <glm/glm.hpp>
 #include "shader.h"
+#include "textureCompression.h"
+#include "texture.h"
 #include <GL/glew.h>
 
 /**
@@ -40,6 +43,17 @@ public:
      */
     void cleanup();
 
+    /**
+     * @brief Bakes the six faces and their mips into one cubemap container in the
+     *        directory, which initialize() loads with a single read in place of the
+     *        images. initialize() rebakes it when the faces change.
+     * @param directory Path to the skybox textures directory.
+     * @param compress True to block-compress the faces, false to store raw texels.
+     * @param format Block format when compressing.
+     * @return True if successful, false otherwise.
+     */
+    static bool bakeCubemap(const std::string& directory, bool compress, BlockFormat format = BlockFormat::BC1);
+
 private:
     // Private Constructor and Destructor for Singleton
     Skybox();
@@ -52,17 +66,37 @@ private:
     // Member Variables
     GLuint VAO, VBO;              ///< Vertex Array Object and Vertex Buffer Object.
     GLuint cubemapTexture;        ///< Cubemap Texture ID.
+    std::shared_ptr<Texture> sharedCubemap;   ///< Holds cubemapTexture, shared with loads of the same faces.
     bool cubemapLoaded;           ///< Flag indicating if the cubemap was loaded successfully.
-    Shader skyboxShader;          ///< Shader program for the Skybox.
+    std::shared_ptr<Shader> skyboxShader;   ///< Shader program for the Skybox.
 
     static Skybox* instance;      ///< Singleton instance.
 
+    /**
+     * @brief Paths of the six cubemap faces in +X, -X, +Y, -Y, +Z, -Z order.
+     */
+    static std::vector<std::string> faceFiles(const std::string& directory);
+
+    /**
+     * @brief Path of the baked cubemap container in a directory.
+     */
+    static std::string containerFile(const std::string& directory);
+
     /**
      * @brief Helper function to load cubemap textures.
      * @param faces Vector containing paths to the cubemap faces.
      * @return Cubemap texture ID.
      */
     GLuint loadCubemap(const std::vector<std::string>& faces);
+
+    /**
+     * @brief Uploads a baked cubemap container from one memory mapping.
+     * @param containerFile Container written by bakeCubemap().
+     * @param sourceKey Expected key of the faces it was baked from.
+     * @return Cubemap texture ID, or 0 if the container is missing, invalid, baked
+     *         from other faces or in a format the context does not support.
+     */
+    GLuint loadCubemapContainer(const std::string& containerFile, uint64_t sourceKey);
 };
 
 #endif // SKYBOX_H
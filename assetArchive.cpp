@@ -0,0 +1,328 @@
+#include "assetArchive.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+const char kArchiveTag[4] = { 'P', 'A', 'C', 'K' };
+const uint32_t kArchiveVersion = 1;
+const uint32_t kCompressedFlag = 1;
+const uint32_t kPageAlignment = 4096;   // Raw binaries start on a page of the mapping
+
+// LZ4 block format limits: matches are at least 4 bytes and 64 KB back, the last
+// match starts 12 bytes before the end and the last 5 bytes are literals
+const size_t kMinMatch = 4;
+const size_t kMaxOffset = 65535;
+const size_t kMatchStartLimit = 12;
+const size_t kLastLiterals = 5;
+const uint64_t kMaxExpansion = 255;   // A length byte extends a match by at most 255 bytes
+const int kHashBits = 16;
+
+struct ArchiveHeader {
+    char tag[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset;
+    uint64_t tocSize;
+};
+
+/// Table of contents record, followed by nameLength bytes of name.
+struct TocRecord {
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    uint32_t flags;
+    uint32_t nameLength;
+};
+
+uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+void writeLength(std::vector<unsigned char>& out, size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<unsigned char>(length));
+}
+
+/// Appends one sequence; a match length of 0 ends the block with literals only.
+void emitSequence(std::vector<unsigned char>& out, const unsigned char* literals, size_t literalCount,
+                  size_t offset, size_t matchLength) {
+    size_t matchCode = matchLength ? matchLength - kMinMatch : 0;
+    out.push_back(static_cast<unsigned char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15) {
+        writeLength(out, literalCount - 15);
+    }
+    out.insert(out.end(), literals, literals + literalCount);
+    if (matchLength) {
+        out.push_back(static_cast<unsigned char>(offset & 0xFF));
+        out.push_back(static_cast<unsigned char>(offset >> 8));
+        if (matchCode >= 15) {
+            writeLength(out, matchCode - 15);
+        }
+    }
+}
+
+/**
+ * @brief Greedy LZ4 block compressor with a single-entry hash table.
+ */
+std::vector<unsigned char> compressLZ4(const unsigned char* data, size_t size) {
+    std::vector<unsigned char> out;
+    out.reserve(size / 2 + 16);
+    std::vector<uint32_t> table(size_t(1) << kHashBits, UINT32_MAX);
+    size_t anchor = 0, i = 0;
+    while (size >= kMatchStartLimit + 1 && i + kMatchStartLimit <= size) {
+        uint32_t sequence = read32(data + i);
+        uint32_t hash = (sequence * 2654435761u) >> (32 - kHashBits);
+        size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(i);
+        if (candidate == UINT32_MAX || i - candidate > kMaxOffset || read32(data + candidate) != sequence) {
+            ++i;
+            continue;
+        }
+        size_t length = kMinMatch;
+        while (i + length < size - kLastLiterals && data[candidate + length] == data[i + length]) {
+            ++length;
+        }
+        emitSequence(out, data + anchor, i - anchor, i - candidate, length);
+        i += length;
+        anchor = i;
+    }
+    emitSequence(out, data + anchor, size - anchor, 0, 0);
+    return out;
+}
+
+bool readLength(const unsigned char*& in, const unsigned char* end, size_t& length) {
+    unsigned char byte;
+    do {
+        if (in >= end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool decompressLZ4(const unsigned char* in, size_t inSize, unsigned char* out, size_t outSize) {
+    const unsigned char* end = in + inSize;
+    size_t written = 0;
+    while (in < end) {
+        unsigned char token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(in, end, literals)) return false;
+        if (literals > static_cast<size_t>(end - in) || literals > outSize - written) return false;
+        std::memcpy(out + written, in, literals);
+        in += literals;
+        written += literals;
+        if (in == end) break;   // Last sequence has no match
+
+        if (end - in < 2) return false;
+        size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(in, end, length)) return false;
+        length += kMinMatch;
+        if (offset == 0 || offset > written || length > outSize - written) return false;
+        // Byte by byte, since a match may overlap the bytes it produces
+        for (size_t k = 0; k < length; ++k, ++written) {
+            out[written] = out[written - offset];
+        }
+    }
+    return written == outSize;
+}
+
+void padTo(std::ofstream& out, uint64_t& position, uint32_t alignment) {
+    static const char zeros[kPageAlignment] = {};
+    uint64_t padding = (alignment - position % alignment) % alignment;
+    out.write(zeros, static_cast<std::streamsize>(padding));
+    position += padding;
+}
+
+/**
+ * @brief True for files the app writes next to its assets: bake caches (.ao, .eroded,
+ *        .mips), compressed textures (.bct), the baked skybox, page files and archives.
+ */
+bool isBakeOutput(const std::string& filename, const std::string& extension) {
+    return extension == ".ao" || extension == ".eroded" || extension == ".bct" || extension == ".mips" ||
+           extension == ".pages" || extension == ".pack" || filename == "skybox.cube";
+}
+}
+
+bool AssetArchive::pack(const std::vector<ArchiveSource>& sources, const std::string& archiveFile) {
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream out(archiveFile, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "ERROR::ASSET_ARCHIVE::FAILED_TO_WRITE: " << archiveFile << std::endl;
+        return false;
+    }
+    ArchiveHeader header = {};
+    std::memcpy(header.tag, kArchiveTag, sizeof(header.tag));
+    header.version = kArchiveVersion;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t position = sizeof(header);
+
+    std::vector<unsigned char> toc;
+    uint64_t totalSize = 0;
+    for (const auto& source : sources) {
+        std::ifstream in(source.file, std::ios::binary);
+        if (!in) {
+            std::cerr << "ERROR::ASSET_ARCHIVE::FAILED_TO_READ: " << source.file << std::endl;
+            return false;
+        }
+        std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::vector<unsigned char> compressed;
+        if (source.compress) {
+            compressed = compressLZ4(bytes.data(), bytes.size());
+        }
+        bool storeCompressed = source.compress && compressed.size() < bytes.size();
+        const std::vector<unsigned char>& stored = storeCompressed ? compressed : bytes;
+
+        uint32_t alignment = std::clamp<uint32_t>(source.alignment, 1, kPageAlignment);
+        if ((alignment & (alignment - 1)) != 0) {
+            alignment = 16;
+        }
+        padTo(out, position, alignment);
+        TocRecord record = { position, stored.size(), bytes.size(), storeCompressed ? kCompressedFlag : 0,
+                             static_cast<uint32_t>(source.name.size()) };
+        out.write(reinterpret_cast<const char*>(stored.data()), static_cast<std::streamsize>(stored.size()));
+        position += stored.size();
+        totalSize += bytes.size();
+
+        const unsigned char* recordBytes = reinterpret_cast<const unsigned char*>(&record);
+        toc.insert(toc.end(), recordBytes, recordBytes + sizeof(record));
+        toc.insert(toc.end(), source.name.begin(), source.name.end());
+    }
+
+    padTo(out, position, 8);
+    header.entryCount = static_cast<uint32_t>(sources.size());
+    header.tocOffset = position;
+    header.tocSize = toc.size();
+    out.write(reinterpret_cast<const char*>(toc.data()), static_cast<std::streamsize>(toc.size()));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out) {
+        std::cerr << "ERROR::ASSET_ARCHIVE::FAILED_TO_WRITE: " << archiveFile << std::endl;
+        return false;
+    }
+    double packMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Packed " << sources.size() << " files (" << totalSize / 1024 << " KB) into " << archiveFile
+              << " (" << (position + toc.size()) / 1024 << " KB) in " << packMs << " ms" << std::endl;
+    return true;
+}
+
+bool AssetArchive::packDirectories(const std::string& root, const std::vector<std::string>& directories,
+                                   const std::string& archiveFile) {
+    namespace fs = std::filesystem;
+    std::vector<ArchiveSource> sources;
+    std::error_code error;
+    for (const auto& directory : directories) {
+        for (fs::recursive_directory_iterator it(fs::path(root) / directory, error), end; !error && it != end; it.increment(error)) {
+            if (!it->is_regular_file()) continue;
+            std::string extension = it->path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            // Bake caches are rewritten in place and page files are mapped on their own
+            if (isBakeOutput(it->path().filename().string(), extension)) continue;
+
+            ArchiveSource source;
+            source.name = it->path().lexically_relative(root).generic_string();
+            source.file = it->path().string();
+            bool text = extension == ".glsl" || extension == ".txt" || extension == ".gpx";
+            bool encodedImage = extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+            source.compress = text;
+            source.alignment = text || encodedImage ? 16 : kPageAlignment;
+            sources.push_back(source);
+        }
+        if (error) {
+            std::cerr << "ERROR::ASSET_ARCHIVE::FAILED_TO_LIST: " << directory << " (" << error.message() << ")" << std::endl;
+            return false;
+        }
+    }
+    // A stable order keeps repacks of unchanged assets byte-identical
+    std::sort(sources.begin(), sources.end(),
+              [](const ArchiveSource& a, const ArchiveSource& b) { return a.name < b.name; });
+    return pack(sources, archiveFile);
+}
+
+bool AssetArchive::open(const std::string& archiveFile) {
+    close();
+    if (!file.open(archiveFile)) {
+        return false;
+    }
+    ArchiveHeader header;
+    bool valid = file.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, file.data(), sizeof(header));
+        valid = std::memcmp(header.tag, kArchiveTag, sizeof(header.tag)) == 0 && header.version == kArchiveVersion &&
+                header.tocOffset <= file.size() && header.tocSize <= file.size() - header.tocOffset;
+    }
+    const unsigned char* toc = valid ? file.data() + header.tocOffset : nullptr;
+    size_t cursor = 0;
+    for (uint32_t i = 0; valid && i < header.entryCount; ++i) {
+        TocRecord record;
+        if (header.tocSize - cursor < sizeof(record)) {
+            valid = false;
+            break;
+        }
+        std::memcpy(&record, toc + cursor, sizeof(record));
+        cursor += sizeof(record);
+        if (header.tocSize - cursor < record.nameLength || record.offset > header.tocOffset ||
+            record.storedSize > header.tocOffset - record.offset) {
+            valid = false;
+            break;
+        }
+        ArchiveEntry entry;
+        entry.offset = record.offset;
+        entry.storedSize = record.storedSize;
+        entry.size = record.size;
+        entry.compressed = (record.flags & kCompressedFlag) != 0;
+        if (entry.compressed ? entry.size / kMaxExpansion > entry.storedSize : entry.size != entry.storedSize) {
+            valid = false;
+            break;
+        }
+        entries[std::string(reinterpret_cast<const char*>(toc + cursor), record.nameLength)] = entry;
+        cursor += record.nameLength;
+    }
+    if (!valid) {
+        std::cerr << "ERROR::ASSET_ARCHIVE::INVALID_ARCHIVE: " << archiveFile << std::endl;
+        close();
+        return false;
+    }
+    // Entries are read in place at scattered offsets
+    file.adviseRandom();
+    return true;
+}
+
+void AssetArchive::close() {
+    entries.clear();
+    file.close();
+}
+
+bool AssetArchive::isOpen() const {
+    return file.isOpen();
+}
+
+const ArchiveEntry* AssetArchive::find(const std::string& name) const {
+    auto it = entries.find(name);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+const unsigned char* AssetArchive::storedData(const ArchiveEntry& entry) const {
+    return file.data() + entry.offset;
+}
+
+bool AssetArchive::decompress(const ArchiveEntry& entry, std::vector<unsigned char>& out) const {
+    out.resize(entry.size);
+    return decompressLZ4(storedData(entry), entry.storedSize, out.data(), out.size());
+}
+
+size_t AssetArchive::getEntryCount() const {
+    return entries.size();
+}
@@ -0,0 +1,97 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+#include "mappedFile.h"
+
+/**
+ * @brief A file to store in an archive.
+ */
+struct ArchiveSource {
+    std::string name;          ///< Asset path inside the archive, relative to the asset root.
+    std::string file;          ///< File to read.
+    bool compress = false;     ///< Store LZ4-compressed if that is smaller.
+    uint32_t alignment = 16;   ///< Power-of-two alignment of the stored bytes in the archive.
+};
+
+/**
+ * @brief Table of contents record of a stored file.
+ */
+struct ArchiveEntry {
+    uint64_t offset = 0;       ///< Start of the stored bytes in the archive.
+    uint64_t storedSize = 0;   ///< Bytes in the archive.
+    uint64_t size = 0;         ///< Bytes of the original file.
+    bool compressed = false;   ///< Stored as an LZ4 block.
+};
+
+/**
+ * @class AssetArchive
+ * @brief Many asset files packed into one memory-mapped file.
+ *
+ * The archive is a small header, the stored files and a table of contents at the end.
+ * Every file starts at its own alignment, so files stored uncompressed (raw heights,
+ * compressed textures, baked cubemaps) are read in place from the mapping without a
+ * copy. Text such as shaders and paths is stored as LZ4 blocks and decompressed on
+ * read. Startup then opens one file instead of dozens.
+ */
+class AssetArchive {
+public:
+    /**
+     * @brief Writes an archive, replacing any existing file.
+     * @param sources Files to store, in order.
+     * @param archiveFile Archive to write.
+     * @return True if successful, false otherwise.
+     */
+    static bool pack(const std::vector<ArchiveSource>& sources, const std::string& archiveFile);
+
+    /**
+     * @brief Packs every file under directories of the asset root. Text is compressed,
+     *        encoded images are stored as they are and raw binaries are page aligned.
+     *        Bake caches, compressed textures, the baked skybox, virtual texture page
+     *        files and archives are skipped, since the app rewrites them in place.
+     * @param root Asset root the entry names are relative to.
+     * @param directories Directories below the root to pack.
+     * @param archiveFile Archive to write.
+     * @return True if successful, false otherwise.
+     */
+    static bool packDirectories(const std::string& root, const std::vector<std::string>& directories,
+                                const std::string& archiveFile);
+
+    /**
+     * @brief Maps an archive and reads its table of contents.
+     * @return True if the archive is valid.
+     */
+    bool open(const std::string& archiveFile);
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief Entry of an asset path, or nullptr if the archive does not hold it.
+     */
+    const ArchiveEntry* find(const std::string& name) const;
+
+    /**
+     * @brief Stored bytes of an entry, inside the mapping.
+     */
+    const unsigned char* storedData(const ArchiveEntry& entry) const;
+
+    /**
+     * @brief Decompresses an entry stored as LZ4.
+     * @param entry Compressed entry.
+     * @param out Receives the original bytes.
+     * @return False if the stored block is corrupt.
+     */
+    bool decompress(const ArchiveEntry& entry, std::vector<unsigned char>& out) const;
+
+    size_t getEntryCount() const;
+
+private:
+    MappedFile file;
+    std::unordered_map<std::string, ArchiveEntry> entries;   ///< Entries by asset path.
+};
+
+#endif // ASSET_ARCHIVE_H
@@ -0,0 +1,218 @@
+#include "assetManager.h"
+#include "bakeCache.h"
+#include "threadPool.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+// Assets are found under the working directory unless the build sets ASSET_ROOT
+// (e.g. -DASSET_ROOT=\"/path/to/project/\") or --assets points elsewhere
+#ifdef ASSET_ROOT
+const char* kDefaultRoot = ASSET_ROOT;
+#else
+const char* kDefaultRoot = "./";
+#endif
+
+AssetBytes readWholeFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    return std::make_shared<const std::vector<unsigned char>>(std::istreambuf_iterator<char>(file),
+                                                              std::istreambuf_iterator<char>());
+}
+}
+
+AssetManager& AssetManager::getInstance() {
+    static AssetManager instance;
+    return instance;
+}
+
+AssetManager::AssetManager() {
+    setRoot(kDefaultRoot);
+}
+
+void AssetManager::setRoot(const std::string& newRoot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    root = newRoot;
+    if (!root.empty() && root.back() != '/' && root.back() != '\\') {
+        root += '/';
+    }
+}
+
+std::string AssetManager::getRoot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return root;
+}
+
+std::string AssetManager::resolve(const std::string& path) const {
+    if (path.empty() || path[0] == '/' || path[0] == '\\') {
+        return path;
+    }
+    return getRoot() + path;
+}
+
+bool AssetManager::exists(const std::string& path) const {
+    std::string resolved = resolve(path);
+    return findEntry(resolved) != nullptr || static_cast<bool>(std::ifstream(resolved, std::ios::binary));
+}
+
+bool AssetManager::mountArchive(const std::string& archiveFile) {
+    if (!archive.open(archiveFile)) {
+        return false;
+    }
+    std::cout << "INFO: Mounted " << archiveFile << " with " << archive.getEntryCount() << " assets" << std::endl;
+    return true;
+}
+
+const ArchiveEntry* AssetManager::findEntry(const std::string& resolved) const {
+    std::string prefix = getRoot();
+    if (!archive.isOpen() || resolved.compare(0, prefix.size(), prefix) != 0) {
+        return nullptr;
+    }
+    return archive.find(resolved.substr(prefix.size()));
+}
+
+void AssetManager::preload(const std::vector<std::string>& paths) {
+    std::vector<std::string> resolvedPaths;
+    for (const auto& path : paths) {
+        std::string resolved = resolve(path);
+        // Archived assets are already in memory
+        if (!findEntry(resolved)) {
+            resolvedPaths.push_back(resolved);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& resolved : resolvedPaths) {
+        auto live = files.find(resolved);
+        if (pending.count(resolved) || (live != files.end() && !live->second.expired())) {
+            continue;
+        }
+        pending[resolved] = ThreadPool::getInstance().submit([resolved]() { return readWholeFile(resolved); }).share();
+    }
+}
+
+AssetData AssetManager::readFile(const std::string& path) {
+    AssetData asset;
+    if (findArchived(path, asset)) {
+        return asset;
+    }
+    asset.owner = readBytes(resolve(path));
+    if (asset.owner) {
+        asset.data = asset.owner->data();
+        asset.size = asset.owner->size();
+    }
+    return asset;
+}
+
+bool AssetManager::findArchived(const std::string& path, AssetData& asset) {
+    std::string resolved = resolve(path);
+    const ArchiveEntry* entry = findEntry(resolved);
+    if (!entry) {
+        return false;
+    }
+    if (!entry->compressed) {
+        asset.data = archive.storedData(*entry);
+        asset.size = entry->size;
+        asset.owner = nullptr;
+        return true;
+    }
+    // Decompressed copies are shared like files read from disk
+    AssetBytes bytes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto live = files.find(resolved);
+        if (live != files.end()) {
+            bytes = live->second.lock();
+        }
+    }
+    if (!bytes) {
+        auto decompressed = std::make_shared<std::vector<unsigned char>>();
+        if (!archive.decompress(*entry, *decompressed)) {
+            std::cerr << "ERROR::ASSET_MANAGER::CORRUPT_ARCHIVE_ENTRY: " << resolved << std::endl;
+            return false;
+        }
+        bytes = decompressed;
+        std::lock_guard<std::mutex> lock(mutex);
+        files[resolved] = bytes;
+    }
+    asset.owner = bytes;
+    asset.data = bytes->data();
+    asset.size = bytes->size();
+    return true;
+}
+
+AssetBytes AssetManager::readBytes(const std::string& resolved) {
+    std::shared_future<AssetBytes> preloaded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto live = files.find(resolved);
+        if (live != files.end()) {
+            if (AssetBytes bytes = live->second.lock()) {
+                return bytes;
+            }
+        }
+        auto running = pending.find(resolved);
+        if (running != pending.end()) {
+            preloaded = running->second;
+        }
+    }
+
+    // Off the pool the preload is waited for, so the file is read once; a worker could
+    // be the thread the preload is queued on, so it only takes a finished one
+    bool usePreload = preloaded.valid() &&
+        (!ThreadPool::getInstance().isWorkerThread() ||
+         preloaded.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    AssetBytes bytes = usePreload ? preloaded.get() : readWholeFile(resolved);
+    std::lock_guard<std::mutex> lock(mutex);
+    // The preload is consumed, or superseded by the direct read and left to finish on its own
+    pending.erase(resolved);
+    if (!bytes) {
+        std::cerr << "ERROR::ASSET_MANAGER::FAILED_TO_READ: " << resolved << std::endl;
+        return nullptr;
+    }
+    files[resolved] = bytes;
+    return bytes;
+}
+
+std::shared_ptr<Shader> AssetManager::loadShader(const std::string& vertexPath, const std::string& fragmentPath) {
+    ShaderSource source;
+    AssetData vertex = readFile(vertexPath), fragment = readFile(fragmentPath);
+    source.vertex.assign(vertex.data, vertex.data + vertex.size);
+    source.fragment.assign(fragment.data, fragment.data + fragment.size);
+    // Both stages in one buffer, separated so moving text between them changes the key
+    std::string combined = source.vertex + '\0' + source.fragment;
+    uint64_t key = hashBakeBytes(reinterpret_cast<const unsigned char*>(combined.data()), combined.size(), {});
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto live = shaders.find(key);
+        if (live != shaders.end()) {
+            if (std::shared_ptr<Shader> shader = live->second.lock()) {
+                std::cout << "INFO: Sharing compiled shader for " << vertexPath << " and " << fragmentPath << std::endl;
+                return shader;
+            }
+        }
+    }
+    auto shader = std::make_shared<Shader>(source);
+    if (shader->isLoaded()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shaders[key] = shader;
+    }
+    return shader;
+}
+
+std::shared_ptr<Texture> AssetManager::findTexture(uint64_t key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto live = textures.find(key);
+    return live != textures.end() ? live->second.lock() : nullptr;
+}
+
+std::shared_ptr<Texture> AssetManager::shareTexture(uint64_t key, GLuint textureID) {
+    auto texture = std::make_shared<Texture>(textureID);
+    std::lock_guard<std::mutex> lock(mutex);
+    textures[key] = texture;
+    return texture;
+}
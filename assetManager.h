@@ -0,0 +1,146 @@
+#ifndef ASSET_MANAGER_H
+#define ASSET_MANAGER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+#include "shader.h"
+#include "texture.h"
+#include "assetArchive.h"
+
+/// Bytes of a loaded file, shared by everything that loaded it.
+using AssetBytes = std::shared_ptr<const std::vector<unsigned char>>;
+
+/**
+ * @brief A loaded asset. Files stored uncompressed in the mounted archive point straight
+ *        into its mapping and stay valid while it is mounted; anything else is held by owner.
+ */
+struct AssetData {
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    AssetBytes owner;   ///< Holds file or decompressed bytes; empty for archive views.
+
+    explicit operator bool() const { return data != nullptr || owner != nullptr; }
+};
+
+/**
+ * @class AssetManager
+ * @brief Resolves asset paths against one root and shares loaded assets.
+ *
+ * A file is read once for as long as anyone holds its bytes, and files can be read
+ * ahead on the thread pool while the window and context are created. Files are shared
+ * by resolved path, not by content, so identical files under two paths are read twice. With a packed
+ * archive mounted, the assets it holds are read from its mapping instead. Shader programs
+ * are keyed by a hash of their sources, so a shader requested from several places is
+ * compiled once; its program is deleted when the last holder releases it. Textures are
+ * shared the same way, keyed by a hash of the images and settings they are built from.
+ */
+class AssetManager {
+public:
+    /**
+     * @brief Retrieves the singleton instance of the AssetManager.
+     * @return Reference to the AssetManager instance.
+     */
+    static AssetManager& getInstance();
+
+    /**
+     * @brief Sets the directory relative asset paths are resolved against.
+     */
+    void setRoot(const std::string& root);
+    std::string getRoot() const;
+
+    /**
+     * @brief Joins a relative path to the root; absolute paths are returned unchanged.
+     */
+    std::string resolve(const std::string& path) const;
+
+    /**
+     * @brief Returns true if the mounted archive holds the file or it can be opened.
+     * @param path Asset path, relative to the root or absolute.
+     */
+    bool exists(const std::string& path) const;
+
+    /**
+     * @brief Mounts a packed archive whose entries take the place of the files under
+     *        the root. Mount before loading anything, while only one thread runs.
+     * @param archiveFile Archive written by AssetArchive::pack().
+     * @return True if the archive was opened.
+     */
+    bool mountArchive(const std::string& archiveFile);
+
+    /**
+     * @brief Starts reading files on the thread pool so later loads find them in memory.
+     * @param paths Asset paths, relative to the root or absolute.
+     */
+    void preload(const std::vector<std::string>& paths);
+
+    /**
+     * @brief Reads a whole file, sharing the bytes with every other holder of it.
+     *
+     * A preload that is still running is waited for, except on a pool worker, which
+     * could be the one it is queued on; a worker reads the file directly instead.
+     * @param path Asset path, relative to the root or absolute.
+     * @return The bytes; false if the file could not be read.
+     */
+    AssetData readFile(const std::string& path);
+
+    /**
+     * @brief Looks a file up in the mounted archive only, so loaders that map loose
+     *        files themselves can still use archived ones without a copy.
+     * @param path Asset path, relative to the root or absolute.
+     * @param asset Receives the bytes.
+     * @return True if the archive holds the file.
+     */
+    bool findArchived(const std::string& path, AssetData& asset);
+
+    /**
+     * @brief Compiles a shader program, or returns the live one built from the same sources.
+     * @param vertexPath Vertex shader asset path.
+     * @param fragmentPath Fragment shader asset path.
+     * @return The shader; check isLoaded() for read and compile errors.
+     */
+    std::shared_ptr<Shader> loadShader(const std::string& vertexPath, const std::string& fragmentPath);
+
+    /**
+     * @brief Returns the live texture built from the same content, if any.
+     * @param key Hash of everything the texture is built from, e.g. the encoded images
+     *        and the adjustments applied to them.
+     * @return The texture, or null if none is held.
+     */
+    std::shared_ptr<Texture> findTexture(uint64_t key);
+
+    /**
+     * @brief Takes ownership of a new texture and shares it under its key until the
+     *        last holder releases it.
+     * @param key Key as for findTexture().
+     * @param textureID Texture name, deleted with the last holder.
+     * @return The texture.
+     */
+    std::shared_ptr<Texture> shareTexture(uint64_t key, GLuint textureID);
+
+private:
+    // Private Constructor and Destructor for Singleton
+    AssetManager();
+    ~AssetManager() = default;
+
+    // Delete copy constructor and assignment operator
+    AssetManager(const AssetManager&) = delete;
+    AssetManager& operator=(const AssetManager&) = delete;
+
+    const ArchiveEntry* findEntry(const std::string& resolved) const;
+    AssetBytes readBytes(const std::string& resolved);
+
+    std::string root;                                                            ///< Ends with a separator.
+    AssetArchive archive;                                                        ///< Mounted archive, if any.
+    std::unordered_map<std::string, std::shared_future<AssetBytes>> pending;    ///< Unread preloads by resolved path.
+    std::unordered_map<std::string, std::weak_ptr<const std::vector<unsigned char>>> files;   ///< Held files by resolved path.
+    std::unordered_map<uint64_t, std::weak_ptr<Shader>> shaders;                ///< Live programs by source hash.
+    std::unordered_map<uint64_t, std::weak_ptr<Texture>> textures;              ///< Live textures by content hash.
+    mutable std::mutex mutex;                                                    ///< Guards the maps and the root.
+};
+
+#endif // ASSET_MANAGER_H
@@ -0,0 +1,69 @@
+#include "bakeCache.h"
+#include <cstring>
+#include <fstream>
+
+namespace {
+const uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+    char tag[4];
+    uint32_t version;
+    uint64_t bytes;
+    uint64_t key;
+};
+}
+
+uint64_t hashBakeInputs(const float* data, size_t count, std::initializer_list<float> settings) {
+    // FNV-1a over 32-bit words
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](float value) {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    };
+    for (size_t i = 0; i < count; ++i) {
+        mix(data[i]);
+    }
+    for (float value : settings) {
+        mix(value);
+    }
+    return hash;
+}
+
+uint64_t hashBakeBytes(const unsigned char* data, size_t count, std::initializer_list<float> settings) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < count; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    for (float value : settings) {
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool readBakeCache(const std::string& path, const char* tag, uint64_t key, void* data, size_t bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.tag, tag, sizeof(header.tag)) != 0 || header.version != kCacheVersion ||
+        header.bytes != bytes || header.key != key) {
+        return false;
+    }
+    return static_cast<bool>(file.read(static_cast<char*>(data), static_cast<std::streamsize>(bytes)));
+}
+
+bool writeBakeCache(const std::string& path, const char* tag, uint64_t key, const void* data, size_t bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    CacheHeader header;
+    std::memcpy(header.tag, tag, sizeof(header.tag));
+    header.version = kCacheVersion;
+    header.bytes = bytes;
+    header.key = key;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    return static_cast<bool>(file);
+}
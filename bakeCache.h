@@ -0,0 +1,44 @@
+#ifndef BAKE_CACHE_H
+#define BAKE_CACHE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+
+/**
+ * @brief FNV-1a hash of a bake's inputs, used as its cache key.
+ * @param data Input samples, e.g. heights.
+ * @param count Number of samples.
+ * @param settings Sizes and parameters that change the result.
+ * @return 64-bit key.
+ */
+uint64_t hashBakeInputs(const float* data, size_t count, std::initializer_list<float> settings);
+
+/**
+ * @brief FNV-1a hash of raw input bytes, e.g. an encoded image file.
+ * @param data Input bytes.
+ * @param count Number of bytes.
+ * @param settings Parameters that change the result.
+ * @return 64-bit key.
+ */
+uint64_t hashBakeBytes(const unsigned char* data, size_t count, std::initializer_list<float> settings);
+
+/**
+ * @brief Reads a cached bake if its tag, key and size all match.
+ * @param path Cache file.
+ * @param tag Four-character tag of the bake type.
+ * @param key Key from hashBakeInputs.
+ * @param data Receives the cached bytes.
+ * @param bytes Expected size of the bake.
+ * @return True if data was filled from the cache.
+ */
+bool readBakeCache(const std::string& path, const char* tag, uint64_t key, void* data, size_t bytes);
+
+/**
+ * @brief Writes a bake to a cache file, replacing any older one.
+ * @return True if successful, false otherwise.
+ */
+bool writeBakeCache(const std::string& path, const char* tag, uint64_t key, const void* data, size_t bytes);
+
+#endif // BAKE_CACHE_H
@@ -0,0 +1,369 @@
+#include "contourLines.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+const int kTileCells = 64;             // Cells per tile side
+const int kLevelBits = 20;             // Key bits of the level index
+const float kContourLift = 0.2f;       // Lines float this far above the ground
+const size_t kMaxCachedIntervals = 8;
+const float kDefaultInterval = 5.0f;
+const int kDefaultMajorEvery = 5;
+
+/// One marching-squares segment. Ends are keyed by grid edge and level, so the ends
+/// of neighbouring segments (in any tile) have equal keys.
+struct Segment {
+    uint64_t key[2];
+    glm::vec2 point[2];
+    int level;
+};
+
+/// A chain of segments within one tile; points are in sample coordinates.
+struct Piece {
+    uint32_t first, count;   ///< Range in the tile's points.
+    uint64_t key[2];         ///< Keys of the first and last point.
+    int level;
+    bool closed;
+};
+
+struct TileContours {
+    std::vector<glm::vec2> points;
+    std::vector<Piece> pieces;
+};
+
+/**
+ * @brief Partner of every end (element * 2 + end) with the same key, or -1.
+ * @param ends (key, element * 2 + end) pairs; sorted in place.
+ */
+std::vector<int32_t> linkEnds(std::vector<std::pair<uint64_t, int32_t>>& ends, size_t elements) {
+    std::sort(ends.begin(), ends.end());
+    std::vector<int32_t> partner(elements * 2, -1);
+    for (size_t i = 0; i + 1 < ends.size(); ++i) {
+        if (ends[i].first != ends[i + 1].first) continue;
+        partner[ends[i].second] = ends[i + 1].second;
+        partner[ends[i + 1].second] = ends[i].second;
+        ++i;
+    }
+    return partner;
+}
+
+/**
+ * @brief Walks the chains formed by linked elements. Calls visit(element, reversed) for
+ *        each element in chain order, then finish(closed) at the end of each chain.
+ *        Reversed elements are entered through end 1 and left through end 0.
+ */
+template <typename Visit, typename Finish>
+void walkChains(size_t elements, const std::vector<int32_t>& partner, Visit visit, Finish finish) {
+    std::vector<uint8_t> used(elements, 0);
+    for (int32_t seed = 0; seed < static_cast<int32_t>(elements); ++seed) {
+        if (used[seed]) continue;
+        // Back up to the open end of the chain, or around the loop to the seed
+        int32_t current = seed, exitEnd = 0;
+        bool closed = false;
+        while (true) {
+            int32_t link = partner[current * 2 + exitEnd];
+            if (link < 0) break;
+            if ((link >> 1) == seed) {
+                closed = true;
+                break;
+            }
+            current = link >> 1;
+            exitEnd = (link & 1) ^ 1;
+        }
+        int32_t start = closed ? seed : current;
+        int32_t leave = closed ? 1 : exitEnd ^ 1;
+        current = start;
+        while (true) {
+            used[current] = 1;
+            visit(current, leave == 0);
+            int32_t link = partner[current * 2 + leave];
+            if (link < 0 || (link >> 1) == start) break;
+            current = link >> 1;
+            leave = (link & 1) ^ 1;
+        }
+        finish(closed);
+    }
+}
+}
+
+ContourLines::ContourLines()
+    : heights(nullptr), gridWidth(0), gridHeight(0), horizontalScale(1.0f), minHeight(0.0f), maxHeight(0.0f),
+      interval(kDefaultInterval), majorEvery(kDefaultMajorEvery), uploadedInterval(0.0f), bufferCapacity(0),
+      vao(0), vbo(0) {}
+
+ContourLines::~ContourLines() {}
+
+void ContourLines::setHeightGrid(const std::vector<float>* newHeights, int width, int height, float scale) {
+    heights = newHeights;
+    gridWidth = width;
+    gridHeight = height;
+    horizontalScale = scale;
+    cache.clear();
+    cacheOrder.clear();
+    uploadedInterval = 0.0f;
+    if (heights && !heights->empty()) {
+        auto range = std::minmax_element(heights->begin(), heights->end());
+        minHeight = *range.first;
+        maxHeight = *range.second;
+    }
+}
+
+void ContourLines::setInterval(float newInterval) {
+    // Level indices must fit their key bits
+    interval = std::max(newInterval, (maxHeight - minHeight) / static_cast<float>((1 << kLevelBits) - 2));
+    if (!heights || interval <= 0.0f || cache.count(interval)) return;
+
+    auto start = std::chrono::steady_clock::now();
+    generate(interval, cache[interval]);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Contours every " << interval << ": " << cache[interval].vertices.size()
+              << " vertices in " << ms << " ms" << std::endl;
+
+    cacheOrder.push_back(interval);
+    if (cacheOrder.size() > kMaxCachedIntervals) {
+        cache.erase(cacheOrder.front());
+        cacheOrder.erase(cacheOrder.begin());
+    }
+}
+
+float ContourLines::getInterval() const {
+    return interval;
+}
+
+void ContourLines::setMajorEvery(int lines) {
+    majorEvery = std::max(1, lines);
+}
+
+void ContourLines::generate(float lineInterval, ContourSet& result, double* joinMs) const {
+    result = ContourSet();
+    if (!heights || gridWidth < 2 || gridHeight < 2 || lineInterval <= 0.0f) return;
+    const std::vector<float>& grid = *heights;
+    const int width = gridWidth;
+    const int baseLevel = static_cast<int>(std::floor(minHeight / lineInterval));
+    int tilesX = (width - 2) / kTileCells + 1, tilesZ = (gridHeight - 2) / kTileCells + 1;
+    std::vector<TileContours> tiles(static_cast<size_t>(tilesX) * tilesZ);
+
+    // Horizontal edge (x, z)-(x + 1, z) has id 2 * sample, vertical (x, z)-(x, z + 1) 2 * sample + 1
+    auto crossingKey = [&](size_t edge, int level) {
+        return (static_cast<uint64_t>(edge) << kLevelBits) | static_cast<uint64_t>(level - baseLevel);
+    };
+
+    ThreadPool::getInstance().parallelFor(0, static_cast<int>(tiles.size()), [&](int t) {
+        int x0 = (t % tilesX) * kTileCells, z0 = (t / tilesX) * kTileCells;
+        int x1 = std::min(x0 + kTileCells, width - 1), z1 = std::min(z0 + kTileCells, gridHeight - 1);
+        std::vector<Segment> segments;
+
+        for (int z = z0; z < z1; ++z) {
+            for (int x = x0; x < x1; ++x) {
+                size_t sample = static_cast<size_t>(z) * width + x;
+                // Corners counter-clockwise from (x, z); edge i joins corner i and i + 1
+                const float corner[4] = { grid[sample], grid[sample + 1], grid[sample + width + 1], grid[sample + width] };
+                const size_t edge[4] = { 2 * sample, 2 * (sample + 1) + 1, 2 * (sample + width), 2 * sample + 1 };
+                float low = std::min(std::min(corner[0], corner[1]), std::min(corner[2], corner[3]));
+                float high = std::max(std::max(corner[0], corner[1]), std::max(corner[2], corner[3]));
+                int firstLevel = static_cast<int>(std::floor(low / lineInterval)) + 1;
+                int lastLevel = static_cast<int>(std::floor(high / lineInterval));
+
+                for (int level = firstLevel; level <= lastLevel; ++level) {
+                    float value = level * lineInterval;
+                    bool inside[4];
+                    for (int c = 0; c < 4; ++c) inside[c] = corner[c] >= value;
+                    int crossed[4], crossings = 0;
+                    glm::vec2 point[4];
+                    for (int e = 0; e < 4; ++e) {
+                        if (inside[e] == inside[(e + 1) % 4]) continue;
+                        // Interpolate from the edge's lower sample so both cells agree
+                        bool forward = e < 2;
+                        float from = forward ? corner[e] : corner[(e + 1) % 4];
+                        float to = forward ? corner[(e + 1) % 4] : corner[e];
+                        float f = (value - from) / (to - from);
+                        point[crossings] = e == 0 ? glm::vec2(x + f, z) : e == 1 ? glm::vec2(x + 1, z + f)
+                                         : e == 2 ? glm::vec2(x + f, z + 1) : glm::vec2(x, z + f);
+                        crossed[crossings++] = e;
+                    }
+                    auto addSegment = [&](int a, int b) {
+                        Segment segment;
+                        segment.key[0] = crossingKey(edge[crossed[a]], level);
+                        segment.key[1] = crossingKey(edge[crossed[b]], level);
+                        segment.point[0] = point[a];
+                        segment.point[1] = point[b];
+                        segment.level = level;
+                        segments.push_back(segment);
+                    };
+                    if (crossings == 2) {
+                        addSegment(0, 1);
+                    } else if (crossings == 4) {
+                        // Saddle: the centre decides which diagonal corners are joined
+                        bool centreInside = (corner[0] + corner[1] + corner[2] + corner[3]) * 0.25f >= value;
+                        if (centreInside == inside[0]) {
+                            addSegment(0, 1);
+                            addSegment(2, 3);
+                        } else {
+                            addSegment(3, 0);
+                            addSegment(1, 2);
+                        }
+                    }
+                }
+            }
+        }
+
+        // Join the segments of the tile into pieces
+        std::vector<std::pair<uint64_t, int32_t>> ends;
+        ends.reserve(segments.size() * 2);
+        for (size_t s = 0; s < segments.size(); ++s) {
+            ends.emplace_back(segments[s].key[0], static_cast<int32_t>(s * 2));
+            ends.emplace_back(segments[s].key[1], static_cast<int32_t>(s * 2 + 1));
+        }
+        std::vector<int32_t> partner = linkEnds(ends, segments.size());
+        TileContours& tile = tiles[t];
+        Piece piece = {};
+        bool first = true;
+        walkChains(segments.size(), partner,
+            [&](int32_t s, bool reversed) {
+                const Segment& segment = segments[s];
+                int enter = reversed ? 1 : 0;
+                if (first) {
+                    piece.first = static_cast<uint32_t>(tile.points.size());
+                    piece.key[0] = segment.key[enter];
+                    piece.level = segment.level;
+                    tile.points.push_back(segment.point[enter]);
+                    first = false;
+                }
+                tile.points.push_back(segment.point[enter ^ 1]);
+                piece.key[1] = segment.key[enter ^ 1];
+            },
+            [&](bool closed) {
+                piece.count = static_cast<uint32_t>(tile.points.size()) - piece.first;
+                piece.closed = closed;
+                tile.pieces.push_back(piece);
+                first = true;
+            });
+    });
+
+    // Join open pieces across tile borders; closed ones are complete already
+    auto joinStart = std::chrono::steady_clock::now();
+    std::vector<std::pair<const TileContours*, const Piece*>> open;
+    float halfWidth = (gridWidth - 1) * horizontalScale * 0.5f;
+    float halfDepth = (gridHeight - 1) * horizontalScale * 0.5f;
+    int currentLevel = 0;
+    size_t lineStart = 0;
+    auto emit = [&](const glm::vec2& point, float level) {
+        result.vertices.emplace_back(point.x * horizontalScale - halfWidth, level + kContourLift,
+                                     point.y * horizontalScale - halfDepth);
+    };
+    auto finishLine = [&]() {
+        bool major = currentLevel % majorEvery == 0;
+        (major ? result.majorFirst : result.minorFirst).push_back(static_cast<GLint>(lineStart));
+        (major ? result.majorCounts : result.minorCounts).push_back(static_cast<GLsizei>(result.vertices.size() - lineStart));
+        lineStart = result.vertices.size();
+    };
+    for (const TileContours& tile : tiles) {
+        for (const Piece& piece : tile.pieces) {
+            if (!piece.closed) {
+                open.emplace_back(&tile, &piece);
+                continue;
+            }
+            currentLevel = piece.level;
+            for (uint32_t i = 0; i < piece.count; ++i) {
+                emit(tile.points[piece.first + i], piece.level * lineInterval);
+            }
+            finishLine();
+        }
+    }
+
+    std::vector<std::pair<uint64_t, int32_t>> ends;
+    ends.reserve(open.size() * 2);
+    for (size_t p = 0; p < open.size(); ++p) {
+        ends.emplace_back(open[p].second->key[0], static_cast<int32_t>(p * 2));
+        ends.emplace_back(open[p].second->key[1], static_cast<int32_t>(p * 2 + 1));
+    }
+    std::vector<int32_t> partner = linkEnds(ends, open.size());
+    bool first = true;
+    walkChains(open.size(), partner,
+        [&](int32_t p, bool reversed) {
+            const TileContours& tile = *open[p].first;
+            const Piece& piece = *open[p].second;
+            currentLevel = piece.level;
+            // Consecutive pieces share their joining point
+            for (uint32_t i = first ? 0 : 1; i < piece.count; ++i) {
+                uint32_t index = reversed ? piece.count - 1 - i : i;
+                emit(tile.points[piece.first + index], piece.level * lineInterval);
+            }
+            first = false;
+        },
+        [&](bool) {
+            finishLine();
+            first = true;
+        });
+    if (joinMs) {
+        *joinMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - joinStart).count();
+    }
+}
+
+void ContourLines::upload(const ContourSet& lines) {
+    if (vao == 0) {
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (lines.vertices.size() > bufferCapacity) {
+        // Grow with headroom so switching between intervals rarely reallocates
+        bufferCapacity = lines.vertices.size() + lines.vertices.size() / 2;
+        glBufferData(GL_ARRAY_BUFFER, bufferCapacity * sizeof(glm::vec3), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, lines.vertices.size() * sizeof(glm::vec3), lines.vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadedInterval = interval;
+}
+
+void ContourLines::render(const glm::mat4& view, const glm::mat4& projection, Shader& pathShader) {
+    auto found = cache.find(interval);
+    if (found == cache.end() || found->second.vertices.empty() || !pathShader.isLoaded()) return;
+    const ContourSet& lines = found->second;
+    if (uploadedInterval != interval) {
+        upload(lines);
+    }
+
+    pathShader.use();
+    pathShader.setMat4("model", glm::mat4(1.0f));
+    pathShader.setMat4("view", view);
+    pathShader.setMat4("projection", projection);
+    glBindVertexArray(vao);
+    pathShader.setVec3("pathColor", glm::vec3(0.55f, 0.4f, 0.25f));
+    glMultiDrawArrays(GL_LINE_STRIP, lines.minorFirst.data(), lines.minorCounts.data(),
+                      static_cast<GLsizei>(lines.minorCounts.size()));
+    pathShader.setVec3("pathColor", glm::vec3(0.35f, 0.2f, 0.08f));
+    glMultiDrawArrays(GL_LINE_STRIP, lines.majorFirst.data(), lines.majorCounts.data(),
+                      static_cast<GLsizei>(lines.majorCounts.size()));
+    glBindVertexArray(0);
+}
+
+void ContourLines::benchmark() const {
+    for (float lineInterval : { 20.0f, 10.0f, 5.0f, 2.0f, 1.0f }) {
+        ContourSet lines;
+        double joinMs = 0.0;
+        auto start = std::chrono::steady_clock::now();
+        generate(lineInterval, lines, &joinMs);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "INFO: Contours " << gridWidth << " x " << gridHeight << " every " << lineInterval << " ("
+                  << ThreadPool::getInstance().getThreadCount() << " threads): " << ms << " ms, " << joinMs
+                  << " ms of it serial join, " << lines.minorCounts.size() + lines.majorCounts.size() << " lines, "
+                  << lines.vertices.size() << " vertices" << std::endl;
+    }
+}
+
+void ContourLines::cleanup() {
+    if (vao) glDeleteVertexArrays(1, &vao);
+    if (vbo) glDeleteBuffers(1, &vbo);
+    vao = vbo = 0;
+    bufferCapacity = 0;
+    uploadedInterval = 0.0f;
+}
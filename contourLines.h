@@ -0,0 +1,94 @@
+#ifndef CONTOUR_LINES_H
+#define CONTOUR_LINES_H
+
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader.h"
+
+/**
+ * @brief Contour polylines of one interval, ready for glMultiDrawArrays.
+ */
+struct ContourSet {
+    std::vector<glm::vec3> vertices;                ///< All polylines, back to back.
+    std::vector<GLint> minorFirst, majorFirst;      ///< First vertex of each polyline.
+    std::vector<GLsizei> minorCounts, majorCounts;  ///< Vertex count of each polyline.
+};
+
+/**
+ * @class ContourLines
+ * @brief Topographic contour lines of a height grid, drawn with the path shader.
+ *
+ * Marching squares runs per tile on the thread pool. Each tile joins its segments
+ * into pieces by sorting their end points, which are keyed by grid edge and level, so
+ * no hashing is needed; pieces that end on tile borders are then joined the same way
+ * across tiles. Results are cached per interval, and all of them are drawn from one
+ * vertex buffer that is only reallocated when it has to grow.
+ */
+class ContourLines {
+public:
+    ContourLines();
+    ~ContourLines();
+
+    /**
+     * @brief Sets the grid to contour and drops the cache. The heights must outlive
+     *        the contours.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void setHeightGrid(const std::vector<float>* heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Selects the contour interval, generating the lines unless cached.
+     * @param interval Height between neighbouring lines in world units.
+     */
+    void setInterval(float interval);
+    float getInterval() const;
+
+    /**
+     * @brief Sets how many minor lines lie between two major (darker) lines.
+     */
+    void setMajorEvery(int lines);
+
+    /**
+     * @brief Generates the lines of an interval on the calling thread (plus the pool).
+     * @param interval Height between neighbouring lines in world units.
+     * @param result Receives the polylines.
+     * @param joinMs Receives the time of the serial join across tiles, if not null.
+     */
+    void generate(float interval, ContourSet& result, double* joinMs = nullptr) const;
+
+    /**
+     * @brief Draws the lines of the current interval. Must be called on the render thread.
+     */
+    void render(const glm::mat4& view, const glm::mat4& projection, Shader& pathShader);
+
+    /**
+     * @brief Times generation for a few intervals and prints the results, with the
+     *        serial join reported separately from the parallel tile stage.
+     */
+    void benchmark() const;
+
+    void cleanup();
+
+private:
+    const std::vector<float>* heights;
+    int gridWidth, gridHeight;
+    float horizontalScale;
+    float minHeight, maxHeight;
+    float interval;
+    int majorEvery;
+    std::map<float, ContourSet> cache;   ///< Lines per interval.
+    std::vector<float> cacheOrder;       ///< Cached intervals, oldest first.
+    float uploadedInterval;              ///< Interval held by the vertex buffer, or 0.
+    size_t bufferCapacity;               ///< Vertices the buffer can hold.
+    GLuint vao, vbo;
+
+    void upload(const ContourSet& lines);
+};
+
+#endif // CONTOUR_LINES_H
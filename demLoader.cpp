@@ -0,0 +1,164 @@
+#include "demLoader.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <cfloat>
+
+namespace {
+const int16_t kSrtmVoid = -32768;
+const float kMetresPerArcSecond = 30.87f;   // Of latitude
+
+std::string lowercaseExtension(const std::string& path) {
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+}
+
+DEMFile::DEMFile() : bytes(nullptr), byteCount(0), format(DEMFormat::AUTO), width(0), height(0), voidFill(0.0f) {}
+
+bool DEMFile::isDEMFile(const std::string& path) {
+    std::string extension = lowercaseExtension(path);
+    return extension == "hgt" || extension == "r16" || extension == "raw" ||
+           extension == "r32" || extension == "f32";
+}
+
+bool DEMFile::open(const std::string& path, DEMFormat requestedFormat, int columns, int rows) {
+    format = requestedFormat;
+    if (format == DEMFormat::AUTO) {
+        std::string extension = lowercaseExtension(path);
+        if (extension == "hgt") {
+            format = DEMFormat::SRTM_HGT;
+        } else if (extension == "r32" || extension == "f32") {
+            format = DEMFormat::RAW_FLOAT32;
+        } else if (extension == "r16" || extension == "raw") {
+            format = DEMFormat::RAW_UINT16;
+        } else {
+            std::cerr << "ERROR::DEM::UNKNOWN_FORMAT: " << path << std::endl;
+            return false;
+        }
+    }
+    archived = AssetData();
+    file.close();
+    if (AssetManager::getInstance().findArchived(path, archived)) {
+        bytes = archived.data;
+        byteCount = archived.size;
+    } else if (file.open(AssetManager::getInstance().resolve(path))) {
+        bytes = file.data();
+        byteCount = file.size();
+    } else {
+        return false;
+    }
+
+    size_t samples = byteCount / bytesPerSample();
+    bool inferred = columns <= 0 || rows <= 0;
+    if (inferred) {
+        // SRTM tiles and most raw exports are square
+        columns = rows = static_cast<int>(std::lround(std::sqrt(static_cast<double>(samples))));
+    }
+    size_t expected = static_cast<size_t>(columns) * rows * bytesPerSample();
+    if (columns < 2 || rows < 2 || expected > byteCount || (inferred && expected != byteCount)) {
+        std::cerr << "ERROR::DEM::SIZE_MISMATCH: " << path << " (" << byteCount << " bytes for "
+                  << columns << " x " << rows << " samples)" << std::endl;
+        file.close();
+        archived = AssetData();
+        return false;
+    }
+    width = columns;
+    height = rows;
+    voidFill = 0.0f;
+    return true;
+}
+
+size_t DEMFile::bytesPerSample() const {
+    return format == DEMFormat::RAW_FLOAT32 ? 4 : 2;
+}
+
+float DEMFile::decode(size_t index) const {
+    const unsigned char* sample = bytes + index * bytesPerSample();
+    switch (format) {
+    case DEMFormat::RAW_UINT16:
+        return static_cast<float>(static_cast<uint16_t>(sample[0] | (sample[1] << 8)));
+    case DEMFormat::RAW_FLOAT32: {
+        uint32_t bits = static_cast<uint32_t>(sample[0]) | (static_cast<uint32_t>(sample[1]) << 8) |
+                        (static_cast<uint32_t>(sample[2]) << 16) | (static_cast<uint32_t>(sample[3]) << 24);
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    case DEMFormat::SRTM_HGT: {
+        int16_t value = static_cast<int16_t>((sample[0] << 8) | sample[1]);
+        return value == kSrtmVoid ? voidFill : static_cast<float>(value);
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+void DEMFile::computeRange(float& low, float& high) {
+    low = FLT_MAX;
+    high = -FLT_MAX;
+    size_t count = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < count; ++i) {
+        if (format == DEMFormat::SRTM_HGT) {
+            const unsigned char* sample = bytes + i * 2;
+            if (static_cast<int16_t>((sample[0] << 8) | sample[1]) == kSrtmVoid) continue;
+        }
+        float value = decode(i);
+        low = std::min(low, value);
+        high = std::max(high, value);
+    }
+    if (low > high) {
+        low = high = 0.0f;  // All voids
+    }
+    voidFill = low;
+}
+
+float DEMFile::sample(int x, int z) const {
+    x = std::clamp(x, 0, width - 1);
+    z = std::clamp(z, 0, height - 1);
+    return decode(static_cast<size_t>(z) * width + x);
+}
+
+void DEMFile::readWindow(int x0, int z0, int columns, int rows, float* out) const {
+    for (int z = 0; z < rows; ++z) {
+        size_t rowStart = static_cast<size_t>(std::clamp(z0 + z, 0, height - 1)) * width;
+        float* row = out + static_cast<size_t>(z) * columns;
+        for (int x = 0; x < columns; ++x) {
+            row[x] = decode(rowStart + std::clamp(x0 + x, 0, width - 1));
+        }
+    }
+}
+
+void DEMFile::adviseAccess(bool sequential) const {
+    // Archived DEMs share the archive's mapping and keep its advice
+    if (!file.isOpen()) {
+        return;
+    }
+    if (sequential) {
+        file.adviseSequential();
+    } else {
+        file.adviseRandom();
+    }
+}
+
+float DEMFile::getSampleSpacing() const {
+    if (format != DEMFormat::SRTM_HGT) return 0.0f;
+    // A one-degree tile has 3600 / spacing + 1 samples per side
+    if (width == 3601) return kMetresPerArcSecond;
+    if (width == 1201) return 3.0f * kMetresPerArcSecond;
+    return 0.0f;
+}
+
+int DEMFile::getWidth() const {
+    return width;
+}
+
+int DEMFile::getHeight() const {
+    return height;
+}
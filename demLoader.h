@@ -0,0 +1,101 @@
+#ifndef DEM_LOADER_H
+#define DEM_LOADER_H
+
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+#include "assetManager.h"
+
+/**
+ * @brief Sample encodings of raw digital elevation models.
+ */
+enum class DEMFormat {
+    AUTO,            ///< Chosen from the file extension.
+    RAW_UINT16,      ///< Little-endian unsigned 16-bit (.r16, .raw).
+    RAW_FLOAT32,     ///< Little-endian 32-bit float (.r32, .f32).
+    SRTM_HGT         ///< Big-endian signed 16-bit metres, -32768 marks voids (.hgt).
+};
+
+/**
+ * @class DEMFile
+ * @brief Memory-mapped raw DEM whose heights are decoded on access.
+ *
+ * Nothing is read at open time; samples are decoded straight from the mapping, so
+ * only the pages that are actually touched are loaded and there is no decode buffer.
+ * A DEM packed uncompressed in the mounted asset archive is read from the archive's
+ * mapping the same way.
+ */
+class DEMFile {
+public:
+    DEMFile();
+
+    /**
+     * @brief Returns true if the path has a DEM extension handled by DEMFormat::AUTO.
+     * @param path Path to check.
+     */
+    static bool isDEMFile(const std::string& path);
+
+    /**
+     * @brief Maps a DEM file.
+     * @param path Path to the DEM, relative to the asset root like every other asset.
+     * @param format Sample encoding, or AUTO to use the file extension.
+     * @param columns Samples per row, or 0 for a square grid inferred from the file size.
+     * @param rows Number of rows, or 0 for a square grid inferred from the file size.
+     * @return True if successful, false otherwise.
+     */
+    bool open(const std::string& path, DEMFormat format = DEMFormat::AUTO, int columns = 0, int rows = 0);
+
+    /**
+     * @brief Scans the DEM for its lowest and highest valid heights. Voids are
+     *        reported as the lowest height from then on.
+     * @param low Receives the lowest height.
+     * @param high Receives the highest height.
+     */
+    void computeRange(float& low, float& high);
+
+    /**
+     * @brief Height of a sample; coordinates are clamped to the grid.
+     */
+    float sample(int x, int z) const;
+
+    /**
+     * @brief Reads a window of heights; coordinates outside the grid are clamped.
+     * @param x0 First column.
+     * @param z0 First row.
+     * @param columns Window width.
+     * @param rows Window height.
+     * @param out Row-major output of columns x rows heights.
+     */
+    void readWindow(int x0, int z0, int columns, int rows, float* out) const;
+
+    /**
+     * @brief Hints the OS about the access pattern of upcoming reads.
+     * @param sequential True for full front-to-back reads, false for scattered windows.
+     */
+    void adviseAccess(bool sequential) const;
+
+    /**
+     * @brief Ground distance between neighbouring samples in metres, as implied by the
+     *        format: SRTM tiles of 1201 or 3601 samples are 3 or 1 arc-seconds apart
+     *        (north-south; east-west spacing shrinks with latitude). Raw exports carry
+     *        no spacing, so 0 is returned for them.
+     */
+    float getSampleSpacing() const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+private:
+    MappedFile file;
+    AssetData archived;            ///< The DEM when it comes from the asset archive.
+    const unsigned char* bytes;    ///< Samples, in the mapping or the archive.
+    size_t byteCount;
+    DEMFormat format;
+    int width, height;
+    float voidFill;   ///< Height returned for SRTM voids.
+
+    float decode(size_t index) const;
+    size_t bytesPerSample() const;
+};
+
+#endif // DEM_LOADER_H
@@ -0,0 +1,28 @@
+#include "frustum.h"
+
+Frustum::Frustum(const glm::mat4& clipFromWorld) {
+    // glm is column-major: row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+        rows[i] = glm::vec4(clipFromWorld[0][i], clipFromWorld[1][i], clipFromWorld[2][i], clipFromWorld[3][i]);
+    }
+    planes[0] = rows[3] + rows[0];  // Left
+    planes[1] = rows[3] - rows[0];  // Right
+    planes[2] = rows[3] + rows[1];  // Bottom
+    planes[3] = rows[3] - rows[1];  // Top
+    planes[4] = rows[3] + rows[2];  // Near
+    planes[5] = rows[3] - rows[2];  // Far
+}
+
+bool Frustum::intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (const glm::vec4& plane : planes) {
+        // Corner furthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                         plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                         plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (plane.x * corner.x + plane.y * corner.y + plane.z * corner.z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+/**
+ * @class Frustum
+ * @brief View frustum planes for culling bounding boxes.
+ *
+ * The six planes are taken from the rows of a combined projection * view (* model)
+ * matrix, so boxes are tested in the space that matrix transforms from.
+ */
+class Frustum {
+public:
+    /**
+     * @brief Extracts the planes of a clip-space transform.
+     * @param clipFromWorld Projection * view, optionally times a model matrix.
+     */
+    explicit Frustum(const glm::mat4& clipFromWorld);
+
+    /**
+     * @brief Conservative box test: false only if the box is fully outside one plane.
+     * @param boxMin Smallest corner of the axis-aligned box.
+     * @param boxMax Largest corner of the axis-aligned box.
+     */
+    bool intersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+private:
+    glm::vec4 planes[6];  ///< Inward-facing planes (normal, distance); not normalised.
+};
+
+#endif // FRUSTUM_H
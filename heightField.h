@@ -0,0 +1,39 @@
+#ifndef HEIGHT_FIELD_H
+#define HEIGHT_FIELD_H
+
+/**
+ * @class HeightField
+ * @brief Ground surface that can be queried in world coordinates.
+ *
+ * Implemented by the single-heightmap Terrain and the tiled world, so the hiker can
+ * walk on either.
+ */
+class HeightField {
+public:
+    virtual ~HeightField() = default;
+
+    /**
+     * @brief Retrieves the ground height at a world (x, z) position.
+     * @param x X-coordinate.
+     * @param z Z-coordinate.
+     * @return Height value at the given position.
+     */
+    virtual float getHeightAtPosition(float x, float z) const = 0;
+
+    /**
+     * @brief Number of height samples along x.
+     */
+    virtual int getWidth() const = 0;
+
+    /**
+     * @brief Number of height samples along z.
+     */
+    virtual int getHeight() const = 0;
+
+    /**
+     * @brief World distance between neighbouring samples.
+     */
+    virtual float getHorizontalScale() const = 0;
+};
+
+#endif // HEIGHT_FIELD_H
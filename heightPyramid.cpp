@@ -0,0 +1,178 @@
+#include "heightPyramid.h"
+#include <algorithm>
+#include <cmath>
+
+HeightPyramid::HeightPyramid() : gridWidth(0), gridHeight(0) {}
+
+bool HeightPyramid::isBuilt() const {
+    return !levels.empty();
+}
+
+void HeightPyramid::build(const std::vector<float>& heights, int width, int height) {
+    levels.clear();
+    grid.clear();
+    if (width < 2 || height < 2 || heights.size() < static_cast<size_t>(width) * height) return;
+    gridWidth = width;
+    gridHeight = height;
+    grid.assign(heights.begin(), heights.begin() + static_cast<size_t>(width) * height);
+
+    // Level 0: range of the four corners of every cell
+    Level cells;
+    cells.columns = width - 1;
+    cells.rows = height - 1;
+    cells.cellSize = 1;
+    cells.minimum.resize(static_cast<size_t>(cells.columns) * cells.rows);
+    cells.maximum.resize(cells.minimum.size());
+    for (int z = 0; z < cells.rows; ++z) {
+        for (int x = 0; x < cells.columns; ++x) {
+            float h00 = grid[z * width + x], h10 = grid[z * width + x + 1];
+            float h01 = grid[(z + 1) * width + x], h11 = grid[(z + 1) * width + x + 1];
+            cells.minimum[z * cells.columns + x] = std::min({ h00, h10, h01, h11 });
+            cells.maximum[z * cells.columns + x] = std::max({ h00, h10, h01, h11 });
+        }
+    }
+    levels.push_back(std::move(cells));
+
+    // Coarser levels merge 2 x 2 nodes until a single root remains
+    while (levels.back().columns > 1 || levels.back().rows > 1) {
+        const Level& fine = levels.back();
+        Level coarse;
+        coarse.columns = (fine.columns + 1) / 2;
+        coarse.rows = (fine.rows + 1) / 2;
+        coarse.cellSize = fine.cellSize * 2;
+        coarse.minimum.resize(static_cast<size_t>(coarse.columns) * coarse.rows);
+        coarse.maximum.resize(coarse.minimum.size());
+        for (int z = 0; z < coarse.rows; ++z) {
+            for (int x = 0; x < coarse.columns; ++x) {
+                float low = fine.minimum[(2 * z) * fine.columns + 2 * x];
+                float high = fine.maximum[(2 * z) * fine.columns + 2 * x];
+                for (int dz = 0; dz < 2; ++dz) {
+                    for (int dx = 0; dx < 2; ++dx) {
+                        int fx = std::min(2 * x + dx, fine.columns - 1);
+                        int fz = std::min(2 * z + dz, fine.rows - 1);
+                        low = std::min(low, fine.minimum[fz * fine.columns + fx]);
+                        high = std::max(high, fine.maximum[fz * fine.columns + fx]);
+                    }
+                }
+                coarse.minimum[z * coarse.columns + x] = low;
+                coarse.maximum[z * coarse.columns + x] = high;
+            }
+        }
+        levels.push_back(std::move(coarse));
+    }
+}
+
+bool HeightPyramid::intersectCell(int x, int z, const glm::vec3& origin, const glm::vec3& direction,
+                                  float t0, float t1, float& tHit) const {
+    float h00 = grid[z * gridWidth + x], h10 = grid[z * gridWidth + x + 1];
+    float h01 = grid[(z + 1) * gridWidth + x], h11 = grid[(z + 1) * gridWidth + x + 1];
+    float u0 = origin.x - x, v0 = origin.z - z;
+
+    // Height of the ray above the cell surface; the mesh splits cells along u + v = 1
+    auto above = [&](float t, bool upperTriangle) {
+        float u = u0 + direction.x * t;
+        float v = v0 + direction.z * t;
+        float surface = upperTriangle
+            ? h11 + (h01 - h11) * (1.0f - u) + (h10 - h11) * (1.0f - v)
+            : h00 + (h10 - h00) * u + (h01 - h00) * v;
+        return origin.y + direction.y * t - surface;
+    };
+
+    float split = t1;
+    float diagonalRate = direction.x + direction.z;
+    if (diagonalRate != 0.0f) {
+        float tDiagonal = (1.0f - u0 - v0) / diagonalRate;
+        if (tDiagonal > t0 && tDiagonal < t1) split = tDiagonal;
+    }
+
+    float bounds[3] = { t0, split, t1 };
+    for (int part = 0; part < 2; ++part) {
+        float a = bounds[part], b = bounds[part + 1];
+        if (b < a || (part == 1 && split == t1)) continue;
+        float middle = 0.5f * (a + b);
+        bool upperTriangle = (u0 + v0 + diagonalRate * middle) > 1.0f;
+        // Within one triangle the difference is linear in t, so the root is exact
+        float fa = above(a, upperTriangle);
+        float fb = above(b, upperTriangle);
+        if (fa <= 0.0f) {
+            tHit = a;
+            return true;
+        }
+        if (fb <= 0.0f) {
+            tHit = a + (b - a) * fa / (fa - fb);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HeightPyramid::intersect(const glm::vec3& origin, const glm::vec3& direction, float maxT, float& tHit) const {
+    if (!isBuilt()) return false;
+
+    // Clip the ray to the bounding box of the grid. The box is open below: a ray under
+    // the lowest sample is underground and hits where it reaches the grid
+    const Level& root = levels.back();
+    glm::vec3 boxMin(0.0f, -INFINITY, 0.0f);
+    glm::vec3 boxMax(static_cast<float>(gridWidth - 1), root.maximum[0], static_cast<float>(gridHeight - 1));
+    float tEnter = 0.0f, tExit = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (direction[axis] == 0.0f) {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) return false;
+            continue;
+        }
+        float ta = (boxMin[axis] - origin[axis]) / direction[axis];
+        float tb = (boxMax[axis] - origin[axis]) / direction[axis];
+        tEnter = std::max(tEnter, std::min(ta, tb));
+        tExit = std::min(tExit, std::max(ta, tb));
+    }
+    if (tEnter > tExit) return false;
+
+    // Small step that moves the ray off a node boundary into the next node
+    float horizontalRate = std::max(std::fabs(direction.x), std::fabs(direction.z));
+    float nudge = horizontalRate > 0.0f ? 1e-4f / horizontalRate : 0.0f;
+
+    int level = static_cast<int>(levels.size()) - 1;
+    float t = tEnter;
+    while (t <= tExit) {
+        const Level& node = levels[level];
+        glm::vec3 probe = origin + direction * std::min(t + nudge, tExit);
+        int nx = std::clamp(static_cast<int>(std::floor(probe.x / node.cellSize)), 0, node.columns - 1);
+        int nz = std::clamp(static_cast<int>(std::floor(probe.z / node.cellSize)), 0, node.rows - 1);
+
+        // Where the ray leaves this node horizontally
+        float x0 = static_cast<float>(nx * node.cellSize);
+        float z0 = static_cast<float>(nz * node.cellSize);
+        float x1 = std::min(x0 + node.cellSize, static_cast<float>(gridWidth - 1));
+        float z1 = std::min(z0 + node.cellSize, static_cast<float>(gridHeight - 1));
+        float tNodeExit = tExit;
+        if (direction.x > 0.0f) tNodeExit = std::min(tNodeExit, (x1 - origin.x) / direction.x);
+        if (direction.x < 0.0f) tNodeExit = std::min(tNodeExit, (x0 - origin.x) / direction.x);
+        if (direction.z > 0.0f) tNodeExit = std::min(tNodeExit, (z1 - origin.z) / direction.z);
+        if (direction.z < 0.0f) tNodeExit = std::min(tNodeExit, (z0 - origin.z) / direction.z);
+        tNodeExit = std::max(tNodeExit, t);
+
+        float yEnter = origin.y + direction.y * t;
+        float yExit = origin.y + direction.y * tNodeExit;
+        int index = nz * node.columns + nx;
+        if (std::min(yEnter, yExit) > node.maximum[index]) {
+            // Passes above everything in this node: skip it and widen the search again
+            t = std::max(tNodeExit, t + nudge);
+            level = std::min(level + 1, static_cast<int>(levels.size()) - 1);
+            continue;
+        }
+        if (std::max(yEnter, yExit) < node.minimum[index]) {
+            // Entirely below the surface, so the ray started underground
+            tHit = t;
+            return true;
+        }
+        if (level > 0) {
+            level--;
+            continue;
+        }
+        if (intersectCell(nx, nz, origin, direction, t, tNodeExit, tHit)) {
+            return true;
+        }
+        t = std::max(tNodeExit, t + nudge);
+    }
+    return false;
+}
@@ -0,0 +1,66 @@
+#ifndef HEIGHT_PYRAMID_H
+#define HEIGHT_PYRAMID_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @class HeightPyramid
+ * @brief Min/max mip pyramid over a height grid for hierarchical ray casting.
+ *
+ * Level 0 holds the height range of every grid cell; each coarser level merges 2 x 2
+ * nodes. A ray skips any node it passes entirely above, so empty space is crossed in
+ * O(log n) steps and only cells near the surface are tested exactly.
+ */
+class HeightPyramid {
+public:
+    HeightPyramid();
+
+    /**
+     * @brief Builds the pyramid.
+     * @param heights Row-major heights.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     */
+    void build(const std::vector<float>& heights, int width, int height);
+
+    /**
+     * @brief Intersects a ray with the triangulated height grid.
+     *
+     * Works in grid space: x and z are sample coordinates, y is height. Each cell is
+     * split along the same diagonal as the terrain mesh. A ray that is below the
+     * surface where it reaches the grid hits at that point. Safe to call from several
+     * threads at once.
+     * @param origin Ray origin in grid space.
+     * @param direction Ray direction in grid space (need not be normalised).
+     * @param maxT Largest ray parameter to consider.
+     * @param tHit Receives the ray parameter of the first hit.
+     * @return True if the ray hits the surface within maxT.
+     */
+    bool intersect(const glm::vec3& origin, const glm::vec3& direction, float maxT, float& tHit) const;
+
+    /**
+     * @brief Returns true once build has been called on a non-empty grid.
+     */
+    bool isBuilt() const;
+
+private:
+    struct Level {
+        int columns, rows;          ///< Nodes in this level.
+        int cellSize;               ///< Grid cells covered by one node side.
+        std::vector<float> minimum; ///< Lowest height per node.
+        std::vector<float> maximum; ///< Highest height per node.
+    };
+
+    int gridWidth, gridHeight;
+    std::vector<float> grid;        ///< Copy of the heights for exact cell tests.
+    std::vector<Level> levels;      ///< Level 0 = cells, last = single root node.
+
+    /**
+     * @brief Exact intersection with the two triangles of a cell over [t0, t1].
+     */
+    bool intersectCell(int x, int z, const glm::vec3& origin, const glm::vec3& direction,
+                       float t0, float t1, float& tHit) const;
+};
+
+#endif // HEIGHT_PYRAMID_H
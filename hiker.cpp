@@ -1,6 +1,7 @@
 // Hiker.cpp
 
 #include "hiker.h"
+#include "assetManager.h"
 #include <sstream>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,6 +12,11 @@
 #include <algorithm>
 #include <cctype>   // For isdigit
 
+namespace {
+// Walking speed along the path in world units per second
+const float kPathSpeed = 40.0f;
+}
+
 /// Constructor
 Hiker::Hiker(const std::string& pathFile)
     :  terrainRef(nullptr), pathFile(pathFile), pathVAO(0), pathVBO(0), currentPosition(glm::vec3(0.0f)),
@@ -20,12 +26,14 @@ Hiker::Hiker(const std::string& pathFile)
 
 //Load hiker path data from file and align with terrain
 
-bool Hiker::loadPathData(const Terrain& terrain) {
-    std::ifstream file(pathFile);
-    if (!file.is_open()) {
+bool Hiker::loadPathData(const HeightField& terrain) {
+    // Read through the asset manager so a packed path comes from the archive
+    AssetData pathData = AssetManager::getInstance().readFile(pathFile);
+    if (!pathData) {
         std::cerr << "ERROR::HIKER::FAILED_TO_OPEN_PATH_FILE: " << pathFile << std::endl;
         return false;
     }
+    std::istringstream file(std::string(reinterpret_cast<const char*>(pathData.data), pathData.size));
 
     float x, y, z;
     pathPoints.clear();
@@ -34,7 +42,6 @@ bool Hiker::loadPathData(const Terrain& terrain) {
     while (file >> x >> y >> z) {
         pathPoints.emplace_back(x, y, z);
     }
-    file.close();
 
     if (pathPoints.empty()) {
         std::cerr << "ERROR::HIKER::NO_PATH_POINTS_LOADED" << std::endl;
@@ -57,7 +64,7 @@ bool Hiker::loadPathData(const Terrain& terrain) {
     return true;
 }
 
-void Hiker::validatePath(const Terrain& terrain) {
+void Hiker::validatePath(const HeightField& terrain) {
     if (pathPoints.empty()) return;
 
     std::vector<glm::vec3> validatedPath;
@@ -112,15 +119,13 @@ void Hiker::calculateSegmentDistances() {
 }
 
 // Update hiker's position along the path
-void Hiker::updatePosition(float deltaTime, const Terrain& terrain) {
+void Hiker::updatePosition(float deltaTime, const HeightField& terrain) {
     if (currentPathIndex >= pathPoints.size() - 1)
         return;
 
     glm::vec3 start = pathPoints[currentPathIndex];
     glm::vec3 end = pathPoints[currentPathIndex + 1];
-    float speed = 40.0f; // Adjusted speed for visible movement
-
-    progress += speed * deltaTime / glm::distance(start, end);
+    progress += kPathSpeed * deltaTime / glm::distance(start, end);
     if (progress > 1.0f) {
         progress = 0.0f;
         currentPathIndex++;
@@ -220,7 +225,29 @@ void Hiker::setSpeed(float newSpeed) {
 glm::vec3 Hiker::getPosition() const {
     return currentPosition;
 }
-void Hiker::setTerrain(const Terrain* terrain) {
+glm::vec3 Hiker::getPositionAhead(float seconds) const {
+    if (pathPoints.size() < 2) {
+        return currentPosition;
+    }
+
+    // Walk the remaining distance segment by segment, looping like updatePosition
+    size_t index = std::min(currentPathIndex, pathPoints.size() - 2);
+    float segmentProgress = progress;
+    float remaining = kPathSpeed * seconds;
+    for (size_t steps = 0; steps < pathPoints.size(); ++steps) {
+        float length = glm::distance(pathPoints[index], pathPoints[index + 1]);
+        float left = (1.0f - segmentProgress) * length;
+        if (remaining <= left && length > 0.0f) {
+            return glm::mix(pathPoints[index], pathPoints[index + 1], segmentProgress + remaining / length);
+        }
+        remaining -= left;
+        segmentProgress = 0.0f;
+        index = index + 1 < pathPoints.size() - 1 ? index + 1 : 0;
+    }
+    return pathPoints[index];
+}
+
+void Hiker::setTerrain(const HeightField* terrain) {
     terrainRef = terrain;
 }
 void Hiker::moveForward(float deltaTime) {
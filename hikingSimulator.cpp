@@ -1,6 +1,7 @@
 // HikingSimulator.cpp
 
 #include "hikingSimulator.h"
+#include "assetManager.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/string_cast.hpp>
@@ -11,22 +12,22 @@
 // Constructor
 HikingSimulator::HikingSimulator()
     : terrain(),
-    hiker("/Users/sumaia/Desktop/triangle/triangle/resources/hiker_path.txt"),
-    width(0),
-    height(0),
+    hiker(AssetManager::getInstance().resolve("resources/hiker_path.txt")),
     animator(),
-    lastFrameTime(0.0f),
-    windowWidth(1280),
-    windowHeight(720),
+    pitch(0.0f),
+    lastX(0.0f),
+    lastY(0.0f),
     viewMatrix(glm::mat4(1.0f)),
     projectionMatrix(glm::mat4(1.0f)),
     modelMatrix(glm::mat4(1.0f)),
-    cameraMode(CameraMode::OVERVIEW),
-    isMouseEnabled(false),
     firstMouse(true),
-    pitch(0.0f),
-    lastX(0.0f),
-    lastY(0.0f),
+    isMouseEnabled(false),
+    windowWidth(1280),
+    height(0),
+    width(0),
+    windowHeight(720),
+    lastFrameTime(0.0f),
+    cameraMode(CameraMode::OVERVIEW),
     cameraPosition(glm::vec3(0.0f, 50.0f, 200.0f)) {}
 //
 
@@ -41,13 +42,10 @@ bool HikingSimulator::initialize() {
     std::cout << "INFO: Initializing HikingSimulator..." << std::endl;
 
     // Load terrain data
-    if (!terrain.loadTerrainData("/Users/sumaia/Desktop/triangle/triangle/resources/graydata.png")) {
+    if (!terrain.loadTerrainData(AssetManager::getInstance().resolve("resources/graydata.png"))) {
         std::cerr << "ERROR: Failed to load terrain heightmap!" << std::endl;
         return false;
     }
-   
-//    // Set scales and terrain reference for the hiker
-    hiker.setScales(1.0f);
     hiker.setTerrain(&terrain);
 
     windowWidth = terrain.getWidth();
@@ -71,9 +69,9 @@ bool HikingSimulator::initialize() {
     else {
           std::cout << "INFO: Hiker path loaded successfully." << std::endl;
     }
-  
-    // Initialize path shader
-    pathShader = std::make_unique<Shader>("/Users/sumaia/Desktop/triangle/triangle/shaders/pathVert.glsl", "/Users/sumaia/Desktop/triangle/triangle/shaders/pathFrag.glsl");
+
+    // Initialize path shader, shared with any other user of the same sources
+    pathShader = AssetManager::getInstance().loadShader("shaders/pathVert.glsl", "shaders/pathFrag.glsl");
     if (!pathShader->isLoaded()) {
         std::cerr << "ERROR: Failed to load path path shader during initialization." << std::endl;
         return false;
@@ -86,6 +84,7 @@ bool HikingSimulator::initialize() {
     std::cout << "INFO: HikingSimulator initialized successfully." << std::endl;
     return true;
 }
+
 void HikingSimulator::updateProjectionMatrix() {
     float aspectRatio = windowWidth / windowHeight;
     float verticalFOV = 50.0f;  // Wider FOV for better coverage
@@ -49,7 +49,7 @@ private:
     int windowWidth;
     int height,width;
     int windowHeight;
-    std::unique_ptr<Shader> pathShader;
+    std::shared_ptr<Shader> pathShader;
     float lastFrameTime;
     void setupMatrices();
     void updateProjectionMatrix();
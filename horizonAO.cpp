@@ -0,0 +1,142 @@
+#include "horizonAO.h"
+#include "threadPool.h"
+#include "bakeCache.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+const char kCacheTag[4] = { 'H', 'Z', 'A', 'O' };
+}
+
+std::vector<float> padHeightGrid(const std::vector<float>& heights, int width, int height, int border) {
+    int paddedWidth = width + 2 * border;
+    int paddedHeight = height + 2 * border;
+    std::vector<float> padded(static_cast<size_t>(paddedWidth) * paddedHeight);
+    ThreadPool::getInstance().parallelFor(0, paddedHeight, [&](int pz) {
+        int z = std::clamp(pz - border, 0, height - 1);
+        float* out = &padded[static_cast<size_t>(pz) * paddedWidth];
+        const float* row = &heights[static_cast<size_t>(z) * width];
+        std::fill(out, out + border, row[0]);
+        std::copy(row, row + width, out + border);
+        std::fill(out + border + width, out + paddedWidth, row[width - 1]);
+    });
+    return padded;
+}
+
+std::vector<int> horizonStepDistances(int radius) {
+    std::vector<int> distances;
+    for (int d = 1; d <= radius; d = std::max(d + 1, static_cast<int>(std::lround(d * 1.4f)))) {
+        distances.push_back(d);
+    }
+    return distances;
+}
+
+std::vector<std::vector<HorizonStep>> buildHorizonSteps(int sectors, int radius, float horizontalScale) {
+    std::vector<int> distances = horizonStepDistances(radius);
+    std::vector<std::vector<HorizonStep>> steps(sectors);
+    for (int k = 0; k < sectors; ++k) {
+        float angle = 2.0f * static_cast<float>(M_PI) * k / sectors;
+        for (int d : distances) {
+            int dx = static_cast<int>(std::lround(std::cos(angle) * d));
+            int dz = static_cast<int>(std::lround(std::sin(angle) * d));
+            if (!steps[k].empty() && steps[k].back().dx == dx && steps[k].back().dz == dz) continue;
+            float length = std::sqrt(static_cast<float>(dx * dx + dz * dz)) * horizontalScale;
+            steps[k].push_back({ dx, dz, 1.0f / length });
+        }
+    }
+    return steps;
+}
+
+HorizonAO::HorizonAO()
+    : directions(16),
+    radius(64),
+    gridWidth(0), gridHeight(0) {}
+
+void HorizonAO::setDirections(int count) {
+    directions = std::max(4, count);
+}
+
+void HorizonAO::setRadius(int samples) {
+    radius = std::max(1, samples);
+}
+
+void HorizonAO::bake(const std::vector<float>& heights, int width, int height, float horizontalScale) {
+    values.clear();
+    gridWidth = gridHeight = 0;
+    if (width < 2 || height < 2 || heights.size() < static_cast<size_t>(width) * height) return;
+    gridWidth = width;
+    gridHeight = height;
+
+    std::vector<std::vector<HorizonStep>> steps = buildHorizonSteps(directions, radius, horizontalScale);
+
+    // Edge-clamped copy with a radius-wide border, so shifted rows never leave the grid
+    int paddedWidth = width + 2 * radius;
+    std::vector<float> padded = padHeightGrid(heights, width, height, radius);
+
+    values.resize(static_cast<size_t>(width) * height);
+    float toByte = 255.0f / directions;
+    ThreadPool::getInstance().parallelFor(0, height, [&](int z) {
+        std::vector<float> horizon(width);
+        std::vector<float> sky(width, 0.0f);
+        const float* center = &padded[static_cast<size_t>(z + radius) * paddedWidth + radius];
+        for (const std::vector<HorizonStep>& direction : steps) {
+            std::fill(horizon.begin(), horizon.end(), 0.0f);
+            // Highest tangent of the horizon, one shifted row at a time
+            for (const HorizonStep& step : direction) {
+                const float* shifted = center + static_cast<ptrdiff_t>(step.dz) * paddedWidth + step.dx;
+                float inverseDistance = step.inverseDistance;
+                float* h = horizon.data();
+                for (int x = 0; x < width; ++x) {
+                    float slope = (shifted[x] - center[x]) * inverseDistance;
+                    h[x] = slope > h[x] ? slope : h[x];
+                }
+            }
+            // Visible sky in this direction is 1 - sin(atan(tangent))
+            float* s = sky.data();
+            const float* h = horizon.data();
+            for (int x = 0; x < width; ++x) {
+                s[x] += 1.0f - h[x] / std::sqrt(1.0f + h[x] * h[x]);
+            }
+        }
+        unsigned char* out = &values[static_cast<size_t>(z) * width];
+        for (int x = 0; x < width; ++x) {
+            out[x] = static_cast<unsigned char>(std::min(255.0f, sky[x] * toByte + 0.5f));
+        }
+    });
+}
+
+bool HorizonAO::bakeCached(const std::string& cacheFile, const std::vector<float>& heights,
+                           int width, int height, float horizontalScale) {
+    uint64_t key = hashBakeInputs(heights.data(), heights.size(),
+                                  { static_cast<float>(width), static_cast<float>(height), horizontalScale,
+                                    static_cast<float>(directions), static_cast<float>(radius) });
+    std::vector<unsigned char> cached(static_cast<size_t>(width) * height);
+    if (readBakeCache(cacheFile, kCacheTag, key, cached.data(), cached.size())) {
+        values = std::move(cached);
+        gridWidth = width;
+        gridHeight = height;
+        return true;
+    }
+    bake(heights, width, height, horizontalScale);
+    if (isBaked() && !writeBakeCache(cacheFile, kCacheTag, key, values.data(), values.size())) {
+        std::cerr << "ERROR::HORIZON_AO::FAILED_TO_WRITE_CACHE: " << cacheFile << std::endl;
+    }
+    return false;
+}
+
+const std::vector<unsigned char>& HorizonAO::getValues() const {
+    return values;
+}
+
+int HorizonAO::getWidth() const {
+    return gridWidth;
+}
+
+int HorizonAO::getHeight() const {
+    return gridHeight;
+}
+
+bool HorizonAO::isBaked() const {
+    return !values.empty();
+}
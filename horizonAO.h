@@ -0,0 +1,94 @@
+#ifndef HORIZON_AO_H
+#define HORIZON_AO_H
+
+#include <vector>
+#include <string>
+
+/**
+ * @brief Copies a height grid with an edge-clamped border on every side, so rows
+ *        shifted by up to border samples never leave the grid.
+ * @return (width + 2 * border) x (height + 2 * border) heights, row-major.
+ */
+std::vector<float> padHeightGrid(const std::vector<float>& heights, int width, int height, int border);
+
+/**
+ * @brief Distances at which horizons are sampled, growing geometrically up to radius:
+ *        near detail matters most, far ridges only need a few samples.
+ */
+std::vector<int> horizonStepDistances(int radius);
+
+/// One step of a horizon search: a grid offset and the inverse of its world length.
+struct HorizonStep {
+    int dx, dz;
+    float inverseDistance;
+};
+
+/**
+ * @brief Horizon search steps for sectors evenly spaced directions, at the distances of
+ *        horizonStepDistances(radius). Offsets that round to the previous one are skipped.
+ * @param horizontalScale World distance between neighbouring samples.
+ * @return One list of steps per direction, nearest first.
+ */
+std::vector<std::vector<HorizonStep>> buildHorizonSteps(int sectors, int radius, float horizontalScale);
+
+/**
+ * @class HorizonAO
+ * @brief Baked sky visibility of a height grid from horizon angles.
+ *
+ * For every sample the highest horizon is found in a fixed set of directions by
+ * stepping outward at growing distances; the visible sky in each direction is
+ * 1 - sin(horizon angle). Rows run in parallel on the thread pool, and each step
+ * compares a whole row against a shifted row so the inner loop vectorises. The
+ * result is stored as one byte per sample and can be cached on disk, keyed on a
+ * hash of the heights and bake settings.
+ */
+class HorizonAO {
+public:
+    HorizonAO();
+
+    /**
+     * @brief Sets the number of horizon directions (at least 4).
+     */
+    void setDirections(int count);
+
+    /**
+     * @brief Sets how far horizons are searched.
+     * @param samples Search radius in samples.
+     */
+    void setRadius(int samples);
+
+    /**
+     * @brief Bakes the sky visibility of a grid.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void bake(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Loads a cached bake if it was made from the same heights and settings,
+     *        otherwise bakes and writes the cache.
+     * @param cacheFile Path of the cache file.
+     * @return True if the cache was used.
+     */
+    bool bakeCached(const std::string& cacheFile, const std::vector<float>& heights,
+                    int width, int height, float horizontalScale);
+
+    /**
+     * @brief Sky visibility per sample, 0 (fully occluded) to 255 (open sky).
+     */
+    const std::vector<unsigned char>& getValues() const;
+
+    int getWidth() const;
+    int getHeight() const;
+    bool isBaked() const;
+
+private:
+    int directions;
+    int radius;
+    int gridWidth, gridHeight;
+    std::vector<unsigned char> values;
+};
+
+#endif // HORIZON_AO_H
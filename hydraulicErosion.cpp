@@ -0,0 +1,206 @@
+#include "hydraulicErosion.h"
+#include "threadPool.h"
+#include "bakeCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace {
+const char kCacheTag[4] = { 'E', 'R', 'O', 'S' };
+// Tiles per side of a phase and the number of rounds the droplets are spread over;
+// the tile grid shifts every round so tile borders do not line up in the result
+const int kTileSize = 128;
+const int kRounds = 8;
+
+/// Height and downhill gradient at a position, bilinear over the cell.
+struct HeightGradient {
+    float height;
+    float gradientX, gradientZ;
+};
+
+HeightGradient sampleHeightGradient(const std::vector<float>& heights, int width, float x, float z) {
+    int nodeX = static_cast<int>(x), nodeZ = static_cast<int>(z);
+    float cellX = x - nodeX, cellZ = z - nodeZ;
+    size_t cell = static_cast<size_t>(nodeZ) * width + nodeX;
+    float h00 = heights[cell], h10 = heights[cell + 1];
+    float h01 = heights[cell + width], h11 = heights[cell + width + 1];
+    HeightGradient result;
+    result.gradientX = (h10 - h00) * (1.0f - cellZ) + (h11 - h01) * cellZ;
+    result.gradientZ = (h01 - h00) * (1.0f - cellX) + (h11 - h10) * cellX;
+    result.height = h00 * (1.0f - cellX) * (1.0f - cellZ) + h10 * cellX * (1.0f - cellZ) +
+                    h01 * (1.0f - cellX) * cellZ + h11 * cellX * cellZ;
+    return result;
+}
+}
+
+HydraulicErosion::HydraulicErosion() {
+    buildBrush();
+}
+
+void HydraulicErosion::setSettings(const ErosionSettings& newSettings) {
+    settings = newSettings;
+    settings.radius = std::clamp(settings.radius, 1, kTileSize / 4);
+    buildBrush();
+}
+
+const ErosionSettings& HydraulicErosion::getSettings() const {
+    return settings;
+}
+
+void HydraulicErosion::buildBrush() {
+    brushOffsetX.clear();
+    brushOffsetZ.clear();
+    brushWeights.clear();
+    float total = 0.0f;
+    for (int z = -settings.radius; z <= settings.radius; ++z) {
+        for (int x = -settings.radius; x <= settings.radius; ++x) {
+            float weight = settings.radius - std::sqrt(static_cast<float>(x * x + z * z));
+            if (weight <= 0.0f) continue;
+            brushOffsetX.push_back(x);
+            brushOffsetZ.push_back(z);
+            brushWeights.push_back(weight);
+            total += weight;
+        }
+    }
+    for (float& weight : brushWeights) {
+        weight /= total;
+    }
+}
+
+size_t HydraulicErosion::erode(std::vector<float>& heights, int width, int height) const {
+    if (width < 2 || height < 2 || heights.size() < static_cast<size_t>(width) * height) return 0;
+
+    // Droplets of same-phase tiles (two tiles apart) can never reach the same samples
+    int halo = (kTileSize - 1) / 2 - settings.radius - 1;
+    int cellsX = width - 1, cellsZ = height - 1;
+    long long totalCells = static_cast<long long>(cellsX) * cellsZ;
+    size_t simulated = 0;
+    ThreadPool& pool = ThreadPool::getInstance();
+
+    for (int round = 0; round < kRounds; ++round) {
+        int roundDroplets = settings.droplets / kRounds + (round == 0 ? settings.droplets % kRounds : 0);
+        int shift = round * kTileSize * 3 / kRounds % kTileSize;
+        int tilesX = (cellsX + shift + kTileSize - 1) / kTileSize;
+        int tilesZ = (cellsZ + shift + kTileSize - 1) / kTileSize;
+
+        for (int phase = 0; phase < 4; ++phase) {
+            std::vector<std::pair<int, int>> phaseTiles;
+            for (int j = phase / 2; j < tilesZ; j += 2) {
+                for (int i = phase % 2; i < tilesX; i += 2) {
+                    phaseTiles.emplace_back(i, j);
+                }
+            }
+            std::vector<int> counts(phaseTiles.size());
+            pool.parallelFor(0, static_cast<int>(phaseTiles.size()), [&](int t) {
+                int i = phaseTiles[t].first, j = phaseTiles[t].second;
+                int x0 = std::max(0, i * kTileSize - shift), x1 = std::min(cellsX, (i + 1) * kTileSize - shift);
+                int z0 = std::max(0, j * kTileSize - shift), z1 = std::min(cellsZ, (j + 1) * kTileSize - shift);
+                if (x1 <= x0 || z1 <= z0) return;
+                long long area = static_cast<long long>(x1 - x0) * (z1 - z0);
+                counts[t] = static_cast<int>(roundDroplets * area / totalCells);
+                uint32_t tileSeed = settings.seed * 0x9E3779B9u ^ static_cast<uint32_t>(round) * 73856093u ^
+                                    static_cast<uint32_t>(i) * 19349663u ^ static_cast<uint32_t>(j) * 83492791u;
+                erodeTile(heights, width, height, x0, z0, x1, z1,
+                          std::max(0, x0 - halo), std::max(0, z0 - halo),
+                          std::min(cellsX, x1 + halo), std::min(cellsZ, z1 + halo), counts[t], tileSeed);
+            });
+            for (int count : counts) {
+                simulated += count;
+            }
+        }
+    }
+    return simulated;
+}
+
+void HydraulicErosion::erodeTile(std::vector<float>& heights, int width, int height, int x0, int z0, int x1, int z1,
+                                 int minX, int minZ, int maxX, int maxZ, int droplets, uint32_t seed) const {
+    std::mt19937 generator(seed);
+    auto random = [&generator]() {
+        return static_cast<float>(generator() >> 8) * (1.0f / 16777216.0f);
+    };
+    const size_t brushSize = brushWeights.size();
+
+    for (int d = 0; d < droplets; ++d) {
+        float posX = x0 + random() * (x1 - x0);
+        float posZ = z0 + random() * (z1 - z0);
+        float dirX = 0.0f, dirZ = 0.0f;
+        float speed = 1.0f, water = 1.0f, sediment = 0.0f;
+
+        for (int step = 0; step < settings.lifetime; ++step) {
+            int nodeX = static_cast<int>(posX), nodeZ = static_cast<int>(posZ);
+            float cellX = posX - nodeX, cellZ = posZ - nodeZ;
+            size_t cell = static_cast<size_t>(nodeZ) * width + nodeX;
+            HeightGradient here = sampleHeightGradient(heights, width, posX, posZ);
+
+            // Turn downhill, keeping some of the previous direction
+            dirX = dirX * settings.inertia - here.gradientX * (1.0f - settings.inertia);
+            dirZ = dirZ * settings.inertia - here.gradientZ * (1.0f - settings.inertia);
+            float length = std::sqrt(dirX * dirX + dirZ * dirZ);
+            if (length == 0.0f) break;
+            dirX /= length;
+            dirZ /= length;
+            posX += dirX;
+            posZ += dirZ;
+            if (posX < minX || posX >= maxX || posZ < minZ || posZ >= maxZ) break;
+
+            float deltaHeight = sampleHeightGradient(heights, width, posX, posZ).height - here.height;
+            float capacity = std::max(-deltaHeight * speed * water * settings.capacity, settings.minCapacity);
+
+            if (sediment > capacity || deltaHeight > 0.0f) {
+                // Uphill: fill the pit behind; otherwise drop the excess over the cell corners
+                float amount = deltaHeight > 0.0f ? std::min(deltaHeight, sediment)
+                                                  : (sediment - capacity) * settings.depositSpeed;
+                sediment -= amount;
+                heights[cell] += amount * (1.0f - cellX) * (1.0f - cellZ);
+                heights[cell + 1] += amount * cellX * (1.0f - cellZ);
+                heights[cell + width] += amount * (1.0f - cellX) * cellZ;
+                heights[cell + width + 1] += amount * cellX * cellZ;
+            } else {
+                // Erode with the brush, never digging deeper than the drop itself
+                float amount = std::min((capacity - sediment) * settings.erodeSpeed, -deltaHeight);
+                for (size_t b = 0; b < brushSize; ++b) {
+                    int x = nodeX + brushOffsetX[b], z = nodeZ + brushOffsetZ[b];
+                    if (x < 0 || z < 0 || x >= width || z >= height) continue;
+                    float removed = amount * brushWeights[b];
+                    heights[static_cast<size_t>(z) * width + x] -= removed;
+                    sediment += removed;
+                }
+            }
+
+            speed = std::sqrt(std::max(0.0f, speed * speed - deltaHeight * settings.gravity));
+            water *= 1.0f - settings.evaporateSpeed;
+        }
+    }
+}
+
+bool HydraulicErosion::erodeCached(const std::string& cacheFile, std::vector<float>& heights, int width, int height) const {
+    uint64_t key = hashBakeInputs(heights.data(), heights.size(),
+                                  { static_cast<float>(width), static_cast<float>(height),
+                                    static_cast<float>(settings.droplets), static_cast<float>(settings.lifetime),
+                                    settings.inertia, settings.capacity, settings.minCapacity,
+                                    settings.erodeSpeed, settings.depositSpeed, settings.evaporateSpeed,
+                                    settings.gravity, static_cast<float>(settings.radius),
+                                    static_cast<float>(settings.seed) });
+    std::vector<float> cached(heights.size());
+    if (readBakeCache(cacheFile, kCacheTag, key, cached.data(), cached.size() * sizeof(float))) {
+        heights = std::move(cached);
+        return true;
+    }
+    erode(heights, width, height);
+    if (!writeBakeCache(cacheFile, kCacheTag, key, heights.data(), heights.size() * sizeof(float))) {
+        std::cerr << "ERROR::EROSION::FAILED_TO_WRITE_CACHE: " << cacheFile << std::endl;
+    }
+    return false;
+}
+
+void HydraulicErosion::benchmark(const std::vector<float>& heights, int width, int height) const {
+    std::vector<float> copy = heights;
+    auto start = std::chrono::steady_clock::now();
+    size_t droplets = erode(copy, width, height);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Hydraulic erosion (" << ThreadPool::getInstance().getThreadCount() << " threads): "
+              << droplets << " droplets in " << seconds * 1000.0 << " ms, "
+              << (seconds > 0.0 ? droplets / seconds : 0.0) << " droplets/s" << std::endl;
+}
@@ -0,0 +1,81 @@
+#ifndef HYDRAULIC_EROSION_H
+#define HYDRAULIC_EROSION_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+/**
+ * @brief Parameters of the droplet erosion. Heights and distances are in samples and
+ *        world height units, so the defaults suit the 0..105 terrain range.
+ */
+struct ErosionSettings {
+    int droplets = 250000;         ///< Droplets simulated over the whole grid.
+    int lifetime = 30;             ///< Steps before a droplet evaporates.
+    float inertia = 0.05f;         ///< How much a droplet keeps its direction (0..1).
+    float capacity = 4.0f;         ///< Sediment carried per unit of slope, speed and water.
+    float minCapacity = 0.01f;     ///< Capacity on flat ground.
+    float erodeSpeed = 0.3f;       ///< Fraction of the free capacity taken per step.
+    float depositSpeed = 0.3f;     ///< Fraction of the excess sediment dropped per step.
+    float evaporateSpeed = 0.01f;  ///< Water lost per step.
+    float gravity = 4.0f;          ///< Speed gained per unit of height lost.
+    int radius = 3;                ///< Erosion brush radius in samples.
+    uint32_t seed = 1;             ///< Same seed, same grid size: same result.
+};
+
+/**
+ * @class HydraulicErosion
+ * @brief Droplet-based hydraulic erosion of a height grid.
+ *
+ * Each droplet runs downhill, picking up sediment where it speeds up and dropping it
+ * where it slows down, which carves gullies and fills valley floors. The grid is split
+ * into tiles processed in four checkerboard phases: a droplet may only leave its tile
+ * by a halo narrower than half a tile, so tiles of the same phase never touch the same
+ * samples and run in parallel without locks. Every tile draws its droplets from its
+ * own seeded generator, so the result does not depend on the thread count.
+ */
+class HydraulicErosion {
+public:
+    HydraulicErosion();
+
+    void setSettings(const ErosionSettings& settings);
+    const ErosionSettings& getSettings() const;
+
+    /**
+     * @brief Erodes the heights in place.
+     * @param heights Row-major heights.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @return Number of droplets simulated.
+     */
+    size_t erode(std::vector<float>& heights, int width, int height) const;
+
+    /**
+     * @brief Replaces the heights with a cached erosion of the same input and settings,
+     *        or erodes them and writes the cache.
+     * @param cacheFile Path of the cache file.
+     * @return True if the cache was used.
+     */
+    bool erodeCached(const std::string& cacheFile, std::vector<float>& heights, int width, int height) const;
+
+    /**
+     * @brief Erodes a copy of the heights and prints droplets per second.
+     */
+    void benchmark(const std::vector<float>& heights, int width, int height) const;
+
+private:
+    ErosionSettings settings;
+    std::vector<int> brushOffsetX, brushOffsetZ;  ///< Brush cells relative to the droplet.
+    std::vector<float> brushWeights;              ///< Normalised brush weights.
+
+    void buildBrush();
+
+    /**
+     * @brief Simulates the droplets of one tile. Droplets die when they leave the
+     *        tile's halo [minX, maxX) x [minZ, maxZ).
+     */
+    void erodeTile(std::vector<float>& heights, int width, int height, int x0, int z0, int x1, int z1,
+                   int minX, int minZ, int maxX, int maxZ, int droplets, uint32_t seed) const;
+};
+
+#endif // HYDRAULIC_EROSION_H
@@ -0,0 +1,243 @@
+#include "hydrology.h"
+#include "lakeDetector.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+const float kDefaultRiverThreshold = 2000.0f;
+const float kRiverLift = 0.3f;        // Rivers float this far above the ground
+const int kNeighbourX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+const int kNeighbourZ[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+const float kNeighbourDistance[8] = { 1.41421356f, 1.0f, 1.41421356f, 1.0f, 1.0f, 1.41421356f, 1.0f, 1.41421356f };
+const int32_t kUnresolved = -2;
+}
+
+Hydrology::Hydrology()
+    : riverThreshold(kDefaultRiverThreshold), gridWidth(0), gridHeight(0), uploaded(false),
+      overlayTexture(0), riverVAO(0), riverVBO(0) {}
+
+Hydrology::~Hydrology() {
+    if (pending.valid()) pending.wait();
+}
+
+void Hydrology::setRiverThreshold(float cells) {
+    riverThreshold = std::max(1.0f, cells);
+}
+
+const std::vector<int32_t>& Hydrology::getReceivers() const {
+    return receivers;
+}
+
+const std::vector<float>& Hydrology::getAccumulation() const {
+    return accumulation;
+}
+
+size_t Hydrology::getRiverCount() const {
+    return riverCounts.size();
+}
+
+GLuint Hydrology::getOverlayTexture() const {
+    return overlayTexture;
+}
+
+void Hydrology::compute(const std::vector<float>& heights, int width, int height, float horizontalScale) {
+    gridWidth = width;
+    gridHeight = height;
+    receivers.clear();
+    accumulation.clear();
+    overlay.clear();
+    riverVertices.clear();
+    riverFirst.clear();
+    riverCounts.clear();
+    if (width < 3 || height < 3 || heights.size() < static_cast<size_t>(width) * height) return;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<float> filled;
+    LakeDetector::fillDepressions(heights, width, height, filled);
+
+    // Steepest descent on the filled surface; rows are independent
+    receivers.assign(filled.size(), kUnresolved);
+    ThreadPool::getInstance().parallelFor(0, height, [&](int z) {
+        for (int x = 0; x < width; ++x) {
+            int cell = z * width + x;
+            int32_t best = kUnresolved;
+            float bestSlope = 0.0f;
+            for (int n = 0; n < 8; ++n) {
+                int nx = x + kNeighbourX[n], nz = z + kNeighbourZ[n];
+                if (nx < 0 || nz < 0 || nx >= width || nz >= height) continue;
+                int neighbour = nz * width + nx;
+                float slope = (filled[cell] - filled[neighbour]) / kNeighbourDistance[n];
+                if (slope > bestSlope) {
+                    bestSlope = slope;
+                    best = neighbour;
+                }
+            }
+            // Border cells without a lower neighbour drain off the grid
+            bool border = x == 0 || z == 0 || x == width - 1 || z == height - 1;
+            receivers[cell] = best != kUnresolved ? best : (border ? -1 : kUnresolved);
+        }
+    });
+
+    resolveFlats(filled);
+    accumulateFlow();
+    extractRivers(filled, horizontalScale);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Hydrology " << width << " x " << height << ": " << riverCounts.size() << " rivers ("
+              << riverVertices.size() << " vertices) in " << ms << " ms" << std::endl;
+}
+
+void Hydrology::resolveFlats(const std::vector<float>& filled) {
+    // Multi-source BFS from every draining cell into the flats next to it; a flat cell
+    // has no lower neighbour, so the cell that reaches it is at the same height
+    std::vector<int32_t> queue;
+    for (int cell = 0; cell < static_cast<int>(receivers.size()); ++cell) {
+        if (receivers[cell] == kUnresolved) continue;
+        int x = cell % gridWidth, z = cell / gridWidth;
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + kNeighbourX[n], nz = z + kNeighbourZ[n];
+            if (nx < 0 || nz < 0 || nx >= gridWidth || nz >= gridHeight) continue;
+            if (receivers[nz * gridWidth + nx] == kUnresolved) {
+                queue.push_back(cell);
+                break;
+            }
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int cell = queue[head];
+        int x = cell % gridWidth, z = cell / gridWidth;
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + kNeighbourX[n], nz = z + kNeighbourZ[n];
+            if (nx < 0 || nz < 0 || nx >= gridWidth || nz >= gridHeight) continue;
+            int neighbour = nz * gridWidth + nx;
+            if (receivers[neighbour] != kUnresolved || filled[neighbour] != filled[cell]) continue;
+            receivers[neighbour] = cell;
+            queue.push_back(neighbour);
+        }
+    }
+}
+
+void Hydrology::accumulateFlow() {
+    // Kahn's algorithm: a cell passes its area on once all its donors have
+    std::vector<uint8_t> donors(receivers.size(), 0);
+    for (int32_t receiver : receivers) {
+        if (receiver >= 0) donors[receiver]++;
+    }
+    accumulation.assign(receivers.size(), 1.0f);
+    std::vector<int32_t> ready;
+    ready.reserve(receivers.size());
+    for (int cell = 0; cell < static_cast<int>(receivers.size()); ++cell) {
+        if (donors[cell] == 0) ready.push_back(cell);
+    }
+    for (size_t head = 0; head < ready.size(); ++head) {
+        int32_t receiver = receivers[ready[head]];
+        if (receiver < 0) continue;
+        accumulation[receiver] += accumulation[ready[head]];
+        if (--donors[receiver] == 0) ready.push_back(receiver);
+    }
+}
+
+void Hydrology::extractRivers(const std::vector<float>& filled, float horizontalScale) {
+    float halfWidth = (gridWidth - 1) * horizontalScale * 0.5f;
+    float halfDepth = (gridHeight - 1) * horizontalScale * 0.5f;
+    float maxAccumulation = *std::max_element(accumulation.begin(), accumulation.end());
+    float logRange = std::log(std::max(maxAccumulation / riverThreshold, 1.0001f));
+
+    // River sources are river cells without river cells upstream
+    std::vector<uint8_t> riverDonors(receivers.size(), 0);
+    overlay.assign(receivers.size(), 0);
+    for (size_t cell = 0; cell < receivers.size(); ++cell) {
+        if (accumulation[cell] < riverThreshold) continue;
+        float strength = std::log(accumulation[cell] / riverThreshold) / logRange;
+        overlay[cell] = static_cast<unsigned char>(std::lround(255.0f * (0.35f + 0.65f * std::min(strength, 1.0f))));
+        if (receivers[cell] >= 0) riverDonors[receivers[cell]] = 1;
+    }
+
+    // Trace each source downstream until it leaves the grid or meets a traced river
+    std::vector<uint8_t> traced(receivers.size(), 0);
+    for (int32_t source = 0; source < static_cast<int32_t>(receivers.size()); ++source) {
+        if (accumulation[source] < riverThreshold || riverDonors[source]) continue;
+        riverFirst.push_back(static_cast<GLint>(riverVertices.size()));
+        int32_t cell = source;
+        while (true) {
+            int x = cell % gridWidth, z = cell / gridWidth;
+            riverVertices.emplace_back(x * horizontalScale - halfWidth, filled[cell] + kRiverLift,
+                                       z * horizontalScale - halfDepth);
+            if (traced[cell]) break;
+            traced[cell] = 1;
+            if (receivers[cell] < 0) break;
+            cell = receivers[cell];
+        }
+        riverCounts.push_back(static_cast<GLsizei>(riverVertices.size()) - riverFirst.back());
+    }
+}
+
+void Hydrology::computeAsync(const std::vector<float>* heights, int width, int height, float horizontalScale) {
+    if (pending.valid()) pending.wait();
+    uploaded = false;
+    pending = ThreadPool::getInstance().submit([this, heights, width, height, horizontalScale]() {
+        compute(*heights, width, height, horizontalScale);
+    });
+}
+
+bool Hydrology::update() {
+    if (pending.valid()) {
+        if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return uploaded;
+        }
+        pending.get();
+        uploadResources();
+    }
+    return uploaded;
+}
+
+void Hydrology::uploadResources() {
+    if (overlay.empty()) return;
+    if (overlayTexture == 0) glGenTextures(1, &overlayTexture);
+    glBindTexture(GL_TEXTURE_2D, overlayTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, gridWidth, gridHeight, 0, GL_RED, GL_UNSIGNED_BYTE, overlay.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (riverVAO == 0) glGenVertexArrays(1, &riverVAO);
+    if (riverVBO == 0) glGenBuffers(1, &riverVBO);
+    glBindVertexArray(riverVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, riverVBO);
+    glBufferData(GL_ARRAY_BUFFER, riverVertices.size() * sizeof(glm::vec3), riverVertices.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindVertexArray(0);
+    uploaded = true;
+}
+
+void Hydrology::renderRivers(const glm::mat4& view, const glm::mat4& projection, Shader& pathShader) const {
+    if (!uploaded || riverCounts.empty() || !pathShader.isLoaded()) return;
+    pathShader.use();
+    pathShader.setMat4("model", glm::mat4(1.0f));
+    pathShader.setMat4("view", view);
+    pathShader.setMat4("projection", projection);
+    pathShader.setVec3("pathColor", glm::vec3(0.15f, 0.35f, 0.85f));
+    glBindVertexArray(riverVAO);
+    glMultiDrawArrays(GL_LINE_STRIP, riverFirst.data(), riverCounts.data(), static_cast<GLsizei>(riverCounts.size()));
+    glBindVertexArray(0);
+}
+
+void Hydrology::cleanup() {
+    if (pending.valid()) {
+        pending.wait();
+        pending = std::future<void>();
+    }
+    if (overlayTexture) glDeleteTextures(1, &overlayTexture);
+    if (riverVAO) glDeleteVertexArrays(1, &riverVAO);
+    if (riverVBO) glDeleteBuffers(1, &riverVBO);
+    overlayTexture = riverVAO = riverVBO = 0;
+    uploaded = false;
+}
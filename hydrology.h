@@ -0,0 +1,114 @@
+#ifndef HYDROLOGY_H
+#define HYDROLOGY_H
+
+#include <vector>
+#include <future>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader.h"
+
+/**
+ * @class Hydrology
+ * @brief D8 flow directions, flow accumulation and river polylines of a height grid.
+ *
+ * Depressions are filled first so every cell drains off the grid. Flow directions
+ * (steepest of the 8 neighbours) are found row-parallel on the thread pool; cells on
+ * flats, including filled lakes, are then pointed toward the nearest outlet of their
+ * flat by a breadth-first pass. Accumulation visits the cells in topological order of
+ * the flow graph, so each cell is touched once. Cells above the river threshold are
+ * traced downstream into polylines that end where they join a larger river.
+ *
+ * The results are available as an R8 overlay texture for the terrain shader and as
+ * line strips drawn with the path shader.
+ */
+class Hydrology {
+public:
+    Hydrology();
+    ~Hydrology();
+
+    /**
+     * @brief Sets the upstream area a cell needs to be part of a river.
+     * @param cells Upstream area in samples, including the cell itself.
+     */
+    void setRiverThreshold(float cells);
+
+    /**
+     * @brief Computes flow and rivers on the calling thread (plus the pool) and waits.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void compute(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Starts compute on the thread pool. The heights must stay alive until
+     *        update() returns true or cleanup() is called.
+     */
+    void computeAsync(const std::vector<float>* heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Uploads a finished computation. Must be called on the render thread.
+     * @return True once the overlay texture and river lines are available.
+     */
+    bool update();
+
+    /**
+     * @brief Draws the rivers as line strips with the path shader.
+     */
+    void renderRivers(const glm::mat4& view, const glm::mat4& projection, Shader& pathShader) const;
+
+    /**
+     * @brief Downstream neighbour of each cell (row-major index), or -1 where the flow
+     *        leaves the grid.
+     */
+    const std::vector<int32_t>& getReceivers() const;
+
+    /**
+     * @brief Upstream area of each cell in samples, including the cell itself.
+     */
+    const std::vector<float>& getAccumulation() const;
+
+    /**
+     * @brief Number of river polylines.
+     */
+    size_t getRiverCount() const;
+
+    /**
+     * @brief R8 overlay, 0 off the rivers and growing with the log of the upstream
+     *        area on them, or 0 before the first upload.
+     */
+    GLuint getOverlayTexture() const;
+
+    /**
+     * @brief Waits for a running computation and releases the GL resources.
+     */
+    void cleanup();
+
+private:
+    float riverThreshold;
+    int gridWidth, gridHeight;
+    std::vector<int32_t> receivers;
+    std::vector<float> accumulation;
+    std::vector<unsigned char> overlay;     ///< Texture staging, one texel per sample.
+    std::vector<glm::vec3> riverVertices;   ///< All river polylines, back to back.
+    std::vector<GLint> riverFirst;          ///< First vertex of each polyline.
+    std::vector<GLsizei> riverCounts;       ///< Vertex count of each polyline.
+    std::future<void> pending;
+    bool uploaded;
+    GLuint overlayTexture;
+    GLuint riverVAO, riverVBO;
+
+    /**
+     * @brief Points every flat cell toward the nearest cell of its flat that drains.
+     * @param filled Depression-filled heights.
+     */
+    void resolveFlats(const std::vector<float>& filled);
+
+    void accumulateFlow();
+    void extractRivers(const std::vector<float>& filled, float horizontalScale);
+    void uploadResources();
+};
+
+#endif // HYDROLOGY_H
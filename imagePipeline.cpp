@@ -0,0 +1,188 @@
+#include "imagePipeline.h"
+#include "bakeCache.h"
+#include "threadPool.h"
+#include "assetManager.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <iostream>
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+const char kCacheTag[4] = { 'M', 'I', 'P', 'S' };
+const float kPipelineVersion = 1.0f;          // Bump when processing changes
+const size_t kApplyChunkBytes = 64 * 1024;    // Bytes per parallel task of apply()
+
+/// Replaces every byte with its table entry.
+void applyTable(const uint8_t* table, unsigned char* data, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON) && defined(__aarch64__)
+    // Four 64-byte lookups; out-of-range indices return 0 (tbl) or keep the lane (tbx)
+    const uint8x16x4_t quarter0 = vld1q_u8_x4(table);
+    const uint8x16x4_t quarter1 = vld1q_u8_x4(table + 64);
+    const uint8x16x4_t quarter2 = vld1q_u8_x4(table + 128);
+    const uint8x16x4_t quarter3 = vld1q_u8_x4(table + 192);
+    const uint8x16_t step = vdupq_n_u8(64);
+    for (; i + 16 <= count; i += 16) {
+        uint8x16_t index = vld1q_u8(data + i);
+        uint8x16_t result = vqtbl4q_u8(quarter0, index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, quarter1, index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, quarter2, index);
+        index = vsubq_u8(index, step);
+        result = vqtbx4q_u8(result, quarter3, index);
+        vst1q_u8(data + i, result);
+    }
+#endif
+    for (; i < count; ++i) {
+        data[i] = table[data[i]];
+    }
+}
+
+/// Writes row y of a level with the 2 x 2 box filter of the level above it.
+void downsampleRow(const unsigned char* source, int sourceWidth, int sourceHeight,
+                   unsigned char* target, int targetWidth, int channels, int y) {
+    const unsigned char* row0 = source + static_cast<size_t>(std::min(2 * y, sourceHeight - 1)) * sourceWidth * channels;
+    const unsigned char* row1 = source + static_cast<size_t>(std::min(2 * y + 1, sourceHeight - 1)) * sourceWidth * channels;
+    unsigned char* out = target + static_cast<size_t>(y) * targetWidth * channels;
+    for (int x = 0; x < targetWidth; ++x) {
+        int x0 = std::min(2 * x, sourceWidth - 1) * channels;
+        int x1 = std::min(2 * x + 1, sourceWidth - 1) * channels;
+        for (int c = 0; c < channels; ++c) {
+            int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+            out[x * channels + c] = static_cast<unsigned char>((sum + 2) >> 2);
+        }
+    }
+}
+}
+
+int MipChain::getLevels() const {
+    return static_cast<int>(levelOffsets.size());
+}
+
+int MipChain::levelWidth(int level) const {
+    return std::max(1, width >> level);
+}
+
+int MipChain::levelHeight(int level) const {
+    return std::max(1, height >> level);
+}
+
+const unsigned char* MipChain::levelData(int level) const {
+    return texels.data() + levelOffsets[level];
+}
+
+void MipChain::allocate(int newWidth, int newHeight, int newChannels) {
+    width = newWidth;
+    height = newHeight;
+    channels = newChannels;
+    levelOffsets.clear();
+    size_t bytes = 0;
+    for (int level = 0;; ++level) {
+        levelOffsets.push_back(bytes);
+        bytes += static_cast<size_t>(levelWidth(level)) * levelHeight(level) * channels;
+        if (levelWidth(level) == 1 && levelHeight(level) == 1) break;
+    }
+    texels.resize(bytes);
+}
+
+ImagePipeline::ImagePipeline() : brightness(1.0f), contrast(1.0f) {
+    buildTable();
+}
+
+void ImagePipeline::setBrightness(float value) {
+    brightness = value;
+    buildTable();
+}
+
+void ImagePipeline::setContrast(float value) {
+    contrast = value;
+    buildTable();
+}
+
+const std::array<uint8_t, 256>& ImagePipeline::getTable() const {
+    return table;
+}
+
+void ImagePipeline::buildTable() {
+    // The adjustments depend only on the byte value, so the chain runs once per value
+    for (int value = 0; value < 256; ++value) {
+        float pixel = value / 255.0f;
+        pixel = (pixel - 0.5f) * contrast + 0.5f;
+        pixel *= brightness;
+        table[value] = static_cast<uint8_t>(std::clamp(pixel, 0.0f, 1.0f) * 255.0f);
+    }
+}
+
+void ImagePipeline::apply(unsigned char* data, size_t count) const {
+    int chunks = static_cast<int>((count + kApplyChunkBytes - 1) / kApplyChunkBytes);
+    ThreadPool::getInstance().parallelFor(0, chunks, [&](int chunk) {
+        size_t begin = static_cast<size_t>(chunk) * kApplyChunkBytes;
+        applyTable(table.data(), data + begin, std::min(kApplyChunkBytes, count - begin));
+    });
+}
+
+void ImagePipeline::process(const unsigned char* data, int width, int height, int channels, bool adjust,
+                            MipChain& chain) const {
+    chain.allocate(width, height, channels);
+    const size_t rowBytes = static_cast<size_t>(width) * channels;
+    unsigned char* level0 = chain.texels.data();
+    auto prepareRows = [&](int begin, int end) {
+        std::copy(data + begin * rowBytes, data + end * rowBytes, level0 + begin * rowBytes);
+        if (adjust) {
+            applyTable(table.data(), level0 + begin * rowBytes, (end - begin) * rowBytes);
+        }
+    };
+    if (chain.getLevels() == 1) {
+        prepareRows(0, height);
+        return;
+    }
+
+    // Each level-1 row adjusts the level-0 rows it filters, the last one also any odd row
+    const int height1 = chain.levelHeight(1);
+    unsigned char* level1 = chain.texels.data() + chain.levelOffsets[1];
+    ThreadPool::getInstance().parallelFor(0, height1, [&](int y) {
+        prepareRows(2 * y, y == height1 - 1 ? height : 2 * y + 2);
+        downsampleRow(level0, width, height, level1, chain.levelWidth(1), channels, y);
+    });
+    for (int level = 2; level < chain.getLevels(); ++level) {
+        const unsigned char* source = chain.levelData(level - 1);
+        unsigned char* target = chain.texels.data() + chain.levelOffsets[level];
+        ThreadPool::getInstance().parallelFor(0, chain.levelHeight(level), [&](int y) {
+            downsampleRow(source, chain.levelWidth(level - 1), chain.levelHeight(level - 1),
+                          target, chain.levelWidth(level), channels, y);
+        });
+    }
+}
+
+bool ImagePipeline::loadCached(const std::string& imageFile, const std::string& cacheFile, MipChain& chain) const {
+    AssetData encoded = AssetManager::getInstance().readFile(imageFile);
+    int width, height, channels;
+    if (!encoded || !stbi_info_from_memory(encoded.data, static_cast<int>(encoded.size), &width, &height, &channels)) {
+        std::cerr << "ERROR::IMAGE_PIPELINE::FAILED_TO_LOAD_IMAGE: " << imageFile << std::endl;
+        return false;
+    }
+
+    uint64_t key = keyFor(encoded.data, encoded.size);
+    chain.allocate(width, height, channels);
+    if (readBakeCache(cacheFile, kCacheTag, key, chain.texels.data(), chain.texels.size())) {
+        return true;
+    }
+    unsigned char* data = stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size), &width, &height, &channels, 0);
+    if (!data) {
+        std::cerr << "ERROR::IMAGE_PIPELINE::FAILED_TO_LOAD_IMAGE: " << imageFile << std::endl;
+        return false;
+    }
+    process(data, width, height, channels, true, chain);
+    stbi_image_free(data);
+    if (!writeBakeCache(cacheFile, kCacheTag, key, chain.texels.data(), chain.texels.size())) {
+        std::cerr << "ERROR::IMAGE_PIPELINE::FAILED_TO_WRITE_CACHE: " << cacheFile << std::endl;
+    }
+    return true;
+}
+
+uint64_t ImagePipeline::keyFor(const unsigned char* encoded, size_t size) const {
+    return hashBakeBytes(encoded, size, { brightness, contrast, kPipelineVersion });
+}
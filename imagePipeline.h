@@ -0,0 +1,105 @@
+#ifndef IMAGE_PIPELINE_H
+#define IMAGE_PIPELINE_H
+
+#include <vector>
+#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief An image and its full mip chain, finest level first, in one buffer.
+ */
+struct MipChain {
+    int width = 0;                        ///< Width of level 0.
+    int height = 0;                       ///< Height of level 0.
+    int channels = 0;                     ///< Bytes per texel.
+    std::vector<unsigned char> texels;    ///< Every level, tightly packed.
+    std::vector<size_t> levelOffsets;     ///< Start of each level in texels.
+
+    int getLevels() const;
+    int levelWidth(int level) const;
+    int levelHeight(int level) const;
+    const unsigned char* levelData(int level) const;
+
+    /**
+     * @brief Sizes the buffer and offsets for a width x height image down to 1 x 1.
+     */
+    void allocate(int width, int height, int channels);
+};
+
+/**
+ * @class ImagePipeline
+ * @brief Colour adjustments and mip generation for textures, on the CPU.
+ *
+ * The adjustments depend only on a channel's byte value, so their chain is evaluated
+ * once per value into a 256-entry table and adjusting a channel is a single lookup.
+ * The table is applied 16 bytes at a time with table-lookup instructions where NEON
+ * is available. Rows are processed in parallel, and the first mip level is filtered
+ * in the same pass that adjusts the two rows it reads. Results can be cached next to
+ * the image.
+ */
+class ImagePipeline {
+public:
+    ImagePipeline();
+
+    /**
+     * @brief Scales values after the contrast step (1 leaves them unchanged).
+     */
+    void setBrightness(float brightness);
+
+    /**
+     * @brief Scales values around mid-grey (1 leaves them unchanged).
+     */
+    void setContrast(float contrast);
+
+    /**
+     * @brief Composed table of every adjustment.
+     */
+    const std::array<uint8_t, 256>& getTable() const;
+
+    /**
+     * @brief Applies the table to bytes in place.
+     * @param data Bytes to adjust.
+     * @param count Number of bytes.
+     */
+    void apply(unsigned char* data, size_t count) const;
+
+    /**
+     * @brief Adjusts an image and builds its mip chain with a 2 x 2 box filter.
+     * @param data Row-major texels, channels bytes each.
+     * @param width Image width.
+     * @param height Image height.
+     * @param channels Bytes per texel.
+     * @param adjust False to only build the mips.
+     * @param chain Receives the levels.
+     */
+    void process(const unsigned char* data, int width, int height, int channels, bool adjust, MipChain& chain) const;
+
+    /**
+     * @brief Loads an image and processes it, or reads the processed result from a
+     *        cache file keyed by the image's bytes and the adjustments.
+     * @param imageFile Image any format stb_image reads.
+     * @param cacheFile Cache file, rewritten when stale.
+     * @param chain Receives the levels.
+     * @return True if the image (or its cache) was loaded.
+     */
+    bool loadCached(const std::string& imageFile, const std::string& cacheFile, MipChain& chain) const;
+
+    /**
+     * @brief Key of an encoded image under the current adjustments, as used for the
+     *        cache. Products baked from the image (e.g. compressed textures) store it
+     *        to detect when the image or the adjustments change.
+     * @param encoded Bytes of the image file.
+     * @param size Number of bytes.
+     */
+    uint64_t keyFor(const unsigned char* encoded, size_t size) const;
+
+private:
+    float brightness, contrast;
+    std::array<uint8_t, 256> table;
+
+    void buildTable();
+};
+
+#endif // IMAGE_PIPELINE_H
@@ -0,0 +1,181 @@
+#include "lakeDetector.h"
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+#include <queue>
+
+namespace {
+const float kDefaultMinDepth = 0.5f;
+const int kDefaultMinCells = 16;
+const int kNeighbourX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+const int kNeighbourZ[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+}
+
+LakeDetector::LakeDetector()
+    : seaLevel(-FLT_MAX), minDepth(kDefaultMinDepth), minCells(kDefaultMinCells) {}
+
+void LakeDetector::setSeaLevel(float level) {
+    seaLevel = level;
+}
+
+void LakeDetector::setMinimumSize(float depth, int cells) {
+    minDepth = std::max(0.0f, depth);
+    minCells = std::max(1, cells);
+}
+
+const std::vector<Lake>& LakeDetector::getLakes() const {
+    return lakes;
+}
+
+const std::vector<glm::vec3>& LakeDetector::getVertices() const {
+    return vertices;
+}
+
+const std::vector<uint32_t>& LakeDetector::getIndices() const {
+    return indices;
+}
+
+void LakeDetector::fillDepressions(const std::vector<float>& heights, int width, int height, std::vector<float>& filled) {
+    filled = heights;
+    if (width < 3 || height < 3) return;
+
+    typedef std::pair<float, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    std::vector<int> pit;
+    size_t pitHead = 0;
+    std::vector<uint8_t> closed(static_cast<size_t>(width) * height, 0);
+
+    // Water drains off the grid border, so the flood starts there
+    for (int z = 0; z < height; ++z) {
+        for (int x = 0; x < width; ++x) {
+            if (x != 0 && z != 0 && x != width - 1 && z != height - 1) continue;
+            int cell = z * width + x;
+            closed[cell] = 1;
+            open.emplace(filled[cell], cell);
+        }
+    }
+
+    while (!open.empty() || pitHead < pit.size()) {
+        int cell;
+        if (pitHead < pit.size()) {
+            cell = pit[pitHead++];
+        } else {
+            cell = open.top().second;
+            open.pop();
+            pit.clear();
+            pitHead = 0;
+        }
+        int x = cell % width, z = cell / width;
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + kNeighbourX[n], nz = z + kNeighbourZ[n];
+            if (nx < 0 || nz < 0 || nx >= width || nz >= height) continue;
+            int neighbour = nz * width + nx;
+            if (closed[neighbour]) continue;
+            closed[neighbour] = 1;
+            if (filled[neighbour] <= filled[cell]) {
+                // Inside a depression: fill to the spill height and keep flooding at that level
+                filled[neighbour] = filled[cell];
+                pit.push_back(neighbour);
+            } else {
+                open.emplace(filled[neighbour], neighbour);
+            }
+        }
+    }
+}
+
+void LakeDetector::detect(const std::vector<float>& heights, int width, int height, float horizontalScale) {
+    lakes.clear();
+    vertices.clear();
+    indices.clear();
+    if (width < 3 || height < 3 || heights.size() < static_cast<size_t>(width) * height) return;
+
+    std::vector<float> level;
+    fillDepressions(heights, width, height, level);
+    for (float& value : level) {
+        value = std::max(value, seaLevel);
+    }
+
+    // Group submerged samples into lakes of the same level
+    std::vector<int> labels(level.size(), -1);
+    std::vector<int> stack;
+    std::vector<Lake> candidates;
+    for (int start = 0; start < static_cast<int>(level.size()); ++start) {
+        if (labels[start] != -1 || level[start] <= heights[start]) continue;
+        Lake lake = { level[start], 0.0f, 0, width, height, -1, -1, 0, 0 };
+        int label = static_cast<int>(candidates.size());
+        labels[start] = label;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            int x = cell % width, z = cell / width;
+            lake.cells++;
+            lake.maxDepth = std::max(lake.maxDepth, lake.level - heights[cell]);
+            lake.minX = std::min(lake.minX, x);
+            lake.minZ = std::min(lake.minZ, z);
+            lake.maxX = std::max(lake.maxX, x);
+            lake.maxZ = std::max(lake.maxZ, z);
+            const int neighbours[4] = { x > 0 ? cell - 1 : -1, x < width - 1 ? cell + 1 : -1,
+                                        z > 0 ? cell - width : -1, z < height - 1 ? cell + width : -1 };
+            for (int neighbour : neighbours) {
+                if (neighbour < 0 || labels[neighbour] != -1) continue;
+                if (level[neighbour] != lake.level || level[neighbour] <= heights[neighbour]) continue;
+                labels[neighbour] = label;
+                stack.push_back(neighbour);
+            }
+        }
+        candidates.push_back(lake);
+    }
+
+    // Keep the lakes worth drawing and renumber the labels to match
+    std::vector<int> remap(candidates.size(), -1);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (candidates[i].maxDepth < minDepth || candidates[i].cells < minCells) continue;
+        remap[i] = static_cast<int>(lakes.size());
+        lakes.push_back(candidates[i]);
+    }
+    for (int& label : labels) {
+        if (label >= 0) label = remap[label];
+    }
+    for (size_t i = 0; i < lakes.size(); ++i) {
+        buildLakeMesh(lakes[i], static_cast<int>(i), labels, width, height, horizontalScale);
+    }
+}
+
+void LakeDetector::buildLakeMesh(Lake& lake, int lakeIndex, const std::vector<int>& labels, int width, int height,
+                                 float horizontalScale) {
+    float halfWidth = (width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (height - 1) * horizontalScale * 0.5f;
+    lake.firstIndex = static_cast<uint32_t>(indices.size());
+
+    // Cells touching the lake, including the shoreline cells the terrain cuts through
+    int cellX0 = std::max(0, lake.minX - 1), cellX1 = std::min(width - 2, lake.maxX);
+    int cellZ0 = std::max(0, lake.minZ - 1), cellZ1 = std::min(height - 2, lake.maxZ);
+    auto touches = [&](int x, int z) {
+        size_t cell = static_cast<size_t>(z) * width + x;
+        return labels[cell] == lakeIndex || labels[cell + 1] == lakeIndex ||
+               labels[cell + width] == lakeIndex || labels[cell + width + 1] == lakeIndex;
+    };
+
+    for (int z = cellZ0; z <= cellZ1; ++z) {
+        int x = cellX0;
+        while (x <= cellX1) {
+            if (!touches(x, z)) {
+                ++x;
+                continue;
+            }
+            // One quad per run of touching cells
+            int runStart = x;
+            while (x <= cellX1 && touches(x, z)) ++x;
+            float left = runStart * horizontalScale - halfWidth, right = x * horizontalScale - halfWidth;
+            float nearZ = z * horizontalScale - halfDepth, farZ = (z + 1) * horizontalScale - halfDepth;
+            uint32_t base = static_cast<uint32_t>(vertices.size());
+            vertices.emplace_back(left, lake.level, nearZ);
+            vertices.emplace_back(right, lake.level, nearZ);
+            vertices.emplace_back(right, lake.level, farZ);
+            vertices.emplace_back(left, lake.level, farZ);
+            indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+        }
+    }
+    lake.indexCount = static_cast<uint32_t>(indices.size()) - lake.firstIndex;
+}
@@ -0,0 +1,86 @@
+#ifndef LAKE_DETECTOR_H
+#define LAKE_DETECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * @brief One connected body of water with a flat surface.
+ */
+struct Lake {
+    float level;          ///< Water surface height.
+    float maxDepth;       ///< Deepest point below the surface.
+    int cells;            ///< Submerged samples.
+    int minX, minZ;       ///< First submerged sample of the bounding box.
+    int maxX, maxZ;       ///< Last submerged sample of the bounding box.
+    uint32_t firstIndex;  ///< First index of the lake's triangles in getIndices().
+    uint32_t indexCount;  ///< Number of indices of the lake's triangles.
+};
+
+/**
+ * @class LakeDetector
+ * @brief Finds lakes in a height grid and builds a water mesh that covers only them.
+ *
+ * A priority flood from the grid border fills every depression up to its spill
+ * height. Samples below the filled surface, or below the sea level, are under water;
+ * they are grouped into lakes of equal level and shallow or tiny ones are dropped, so
+ * the noise in the heights does not turn into puddles. Each lake is meshed with one
+ * quad per run of cells that touch it, which the terrain's depth test trims to the
+ * shoreline.
+ */
+class LakeDetector {
+public:
+    LakeDetector();
+
+    /**
+     * @brief Floods everything below this height, connected to a depression or not.
+     * @param level Height in world units, or -FLT_MAX for depressions only.
+     */
+    void setSeaLevel(float level);
+
+    /**
+     * @brief Drops lakes that are shallower or smaller than the limits.
+     * @param depth Minimum depth of the deepest point in world units.
+     * @param cells Minimum number of submerged samples.
+     */
+    void setMinimumSize(float depth, int cells);
+
+    /**
+     * @brief Detects the lakes and builds their mesh.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void detect(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+    const std::vector<Lake>& getLakes() const;
+    const std::vector<glm::vec3>& getVertices() const;   ///< World-space water vertices.
+    const std::vector<uint32_t>& getIndices() const;     ///< Triangles, grouped per lake.
+
+    /**
+     * @brief Raises every depression to its spill height (priority flood with a FIFO
+     *        for cells inside pits, so flat fills skip the heap).
+     * @param heights Row-major heights.
+     * @param filled Receives the filled heights.
+     */
+    static void fillDepressions(const std::vector<float>& heights, int width, int height, std::vector<float>& filled);
+
+private:
+    float seaLevel;
+    float minDepth;
+    int minCells;
+    std::vector<Lake> lakes;
+    std::vector<glm::vec3> vertices;
+    std::vector<uint32_t> indices;
+
+    /**
+     * @brief Appends the quads of one lake to the mesh.
+     * @param labels Lake index per sample, -1 on land.
+     */
+    void buildLakeMesh(Lake& lake, int lakeIndex, const std::vector<int>& labels, int width, int height,
+                       float horizontalScale);
+};
+
+#endif // LAKE_DETECTOR_H
@@ -5,7 +5,24 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include "terrain.h"
+#include "tiledTerrain.h"
+#include "demLoader.h"
+#include "viewshed.h"
+#include "hydraulicErosion.h"
+#include "proceduralTerrain.h"
+#include "hydrology.h"
+#include "contourLines.h"
+#include "peakIndex.h"
+#include "virtualTexture.h"
+#include "Skybox.h"
+#include "assetManager.h"
+#include "assetArchive.h"
 #include "hiker.h"
 #include "camera.h"
 #include "hikingSimulator.h"
@@ -19,6 +36,11 @@ void processInput(GLFWwindow* window);
 // Settings
 const unsigned int SCR_WIDTH = 1280;
 const unsigned int SCR_HEIGHT = 720;
+const float kClockHoursPerSecond = 1.0f;                 // Time-of-day speed while T is held
+const int kProceduralWorldSize = 65537;                  // Samples per side of the tiled procedural world
+const float kSummitRadius = 600.0f;                      // Summits within this distance are listed
+const size_t kSummitCount = 3;                           // Most prominent summits listed
+const float kFieldOfView = 45.0f;                        // Vertical field of view in degrees
 
 // Camera
 glm::vec3 cameraPosition = glm::vec3(0.0f, 100.0f, 200.0f);
@@ -122,8 +144,172 @@ void renderHiker(const glm::vec3& position, Shader& shader, const glm::mat4& vie
     glBindVertexArray(0);
 }
 
-int main() {
+// Prints the command line options
+void printUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --assets <dir>                  Asset root (default: the working directory)\n"
+              << "  --archive <file>                Read assets from a packed archive instead of the loose files\n"
+              << "  --pack-assets [archive]         Pack the shaders and resources (default: assets.pack\n"
+              << "                                  under the root) and exit\n"
+              << "  --dem <file>                    Heightmap image or raw 16/32-bit / .hgt DEM\n"
+              << "  --procedural [size]             Generated heights (default 2049 samples per side)\n"
+              << "  --seed <n>                      Seed of the procedural heights\n"
+              << "  --fbm                           fBm instead of ridged noise\n"
+              << "  --erosion [droplets]            Hydraulic erosion while baking (default 250000)\n"
+              << "  --strips                        Triangle strips with primitive restart\n"
+              << "  --adaptive [max error]          Adaptive mesh (default 1.0, negative for the grid)\n"
+              << "  --tiled                         Stream the ground in tiles around the hiker (no water or overlays)\n"
+              << "  --tile-budget <MB>              Memory the resident tiles may use (default 256)\n"
+              << "  --time-of-day [hours]           Sun lighting and shadows (default 9.0); hold T to advance\n"
+              << "  --rivers [upstream samples]     Rivers from flow accumulation (default 2000)\n"
+              << "  --contours [interval]           Contour lines (default 5.0); [ and ] halve and double\n"
+              << "  --peaks                         List the most prominent summits near the hiker\n"
+              << "  --viewshed                      Tint the ground the hiker can see\n"
+              << "  --color-map [image]             Drape imagery through a virtual texture\n"
+              << "  --build-pages [image]           Cut an image into its page file and exit\n"
+              << "  --compress-textures [format]    Block-compress the terrain texture (bc1, bc3, bc7; default bc1) and exit\n"
+              << "  --skybox <dir>                  Draw the sky from the faces (or baked container) in dir;\n"
+              << "                                  with --compress-textures, compress them instead\n"
+              << "  --bake-skybox <dir>             Bake the skybox faces into one container and exit\n"
+              << "  --benchmark                     Print the terrain benchmarks once loaded\n"
+              << "  --help                          Print this message" << std::endl;
+}
+
+/**
+ * @brief Parses a whole option value as a number.
+ * @return False if the text is not a number.
+ */
+bool parseNumber(const std::string& text, double& value) {
+    try {
+        size_t used = 0;
+        value = std::stod(text, &used);
+        return used == text.size();
+    } catch (const std::exception&) {
+        return false;   // std::invalid_argument or std::out_of_range
+    }
+}
+
+int main(int argc, char** argv) {
     srand(static_cast<unsigned int>(time(0)));
+    // Command line options
+    std::vector<std::string> args(argv + 1, argv + argc);
+    auto hasArg = [&args](const std::string& name) {
+        return std::find(args.begin(), args.end(), name) != args.end();
+    };
+    // Value following an option; the next option is never taken as its value
+    auto argValue = [&args](const std::string& name, const std::string& fallback) {
+        auto it = std::find(args.begin(), args.end(), name);
+        return (it != args.end() && it + 1 != args.end() && (it + 1)->compare(0, 2, "--") != 0) ? *(it + 1) : fallback;
+    };
+    if (hasArg("--help")) {
+        printUsage(argv[0]);
+        return 0;
+    }
+    // Every value is checked up front, so a typo prints the usage instead of throwing mid-load
+    bool validArgs = true;
+    auto numberArg = [&](const std::string& name, double fallback) {
+        double value = fallback;
+        std::string text = argValue(name, "");
+        if (!text.empty() && !parseNumber(text, value)) {
+            std::cerr << "ERROR: Invalid number for " << name << ": " << text << std::endl;
+            validArgs = false;
+            value = fallback;
+        }
+        return value;
+    };
+    for (const char* name : { "--assets", "--archive", "--dem", "--seed", "--tile-budget", "--skybox", "--bake-skybox" }) {
+        if (hasArg(name) && argValue(name, "").empty()) {
+            std::cerr << "ERROR: Missing value for " << name << std::endl;
+            validArgs = false;
+        }
+    }
+    const uint32_t seed = static_cast<uint32_t>(std::max(0.0, numberArg("--seed", 1337.0)));
+    const int proceduralSize = static_cast<int>(numberArg("--procedural", 2049.0));
+    const int erosionDroplets = static_cast<int>(numberArg("--erosion", 250000.0));
+    const float adaptiveMaxError = static_cast<float>(numberArg("--adaptive", 1.0));
+    const float startTimeOfDay = static_cast<float>(numberArg("--time-of-day", 9.0));
+    const float riverThreshold = static_cast<float>(numberArg("--rivers", 2000.0));
+    const float contourInterval = static_cast<float>(numberArg("--contours", 5.0));
+    const double tileBudgetMB = numberArg("--tile-budget", 256.0);
+    if (tileBudgetMB <= 0.0) {
+        std::cerr << "ERROR: --tile-budget must be positive" << std::endl;
+        validArgs = false;
+    }
+    BlockFormat textureFormat = BlockFormat::BC1;
+    if (hasArg("--compress-textures") &&
+        !TextureCompressor::parseFormat(argValue("--compress-textures", "bc1"), textureFormat)) {
+        std::cerr << "ERROR: Unknown block format: " << argValue("--compress-textures", "") << std::endl;
+        validArgs = false;
+    }
+    if (!validArgs) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    // Relative asset paths are resolved against --assets <dir>, by default the working directory
+    AssetManager& assets = AssetManager::getInstance();
+    if (hasArg("--assets")) {
+        assets.setRoot(argValue("--assets", assets.getRoot()));
+    }
+    // Offline step: pack the shaders and resources under the asset root into one archive
+    // and exit, e.g. --pack-assets [archive]
+    const std::string archiveFile = argValue("--archive", assets.resolve("assets.pack"));
+    if (hasArg("--pack-assets")) {
+        return AssetArchive::packDirectories(assets.getRoot(), { "shaders", "resources" },
+                                             argValue("--pack-assets", archiveFile)) ? 0 : -1;
+    }
+    // Assets are read from a packed archive only when asked for, so a stale pack never
+    // hides edits to the loose files
+    if (hasArg("--archive") && !assets.mountArchive(archiveFile)) {
+        std::cerr << "ERROR: Failed to open asset archive " << archiveFile << std::endl;
+        return -1;
+    }
+    if (!assets.exists("shaders/terrainVert.glsl")) {
+        std::cerr << "ERROR: No shaders/ under the asset root " << assets.getRoot()
+                  << "; run from the project directory or pass --assets <dir>" << std::endl;
+        return -1;
+    }
+    bool runBenchmarks = hasArg("--benchmark");
+    bool useTiledWorld = hasArg("--tiled");
+    // 8-bit heightmap image, or a raw 16/32-bit or SRTM .hgt DEM with --dem <file>
+    const std::string heightmapFile = argValue("--dem", assets.resolve("resources/graydata.png"));
+    // Generated heights instead of the heightmap, e.g. --procedural 2049 --seed 7 [--fbm]
+    bool useProcedural = hasArg("--procedural");
+    ProceduralSettings proceduralSettings;
+    if (hasArg("--seed")) {
+        proceduralSettings.seed = seed;
+    }
+    if (hasArg("--fbm")) {
+        proceduralSettings.type = NoiseType::FBM;
+    }
+    // Imagery draped over the terrain through a virtual texture, e.g. --color-map <image>
+    bool useColorMap = hasArg("--color-map");
+    const std::string colorMapFile = argValue("--color-map", assets.resolve("resources/colorsdata.png"));
+    // Offline step: cut an image into its page file and exit, e.g. --build-pages <image>
+    if (hasArg("--build-pages")) {
+        std::string image = argValue("--build-pages", colorMapFile);
+        return VirtualTexture::buildPageFile(image, image + ".pages") ? 0 : -1;
+    }
+    const std::string terrainTextureFile = assets.resolve("resources/tex2.png");
+    // Offline step: block-compress the terrain texture (and the skybox faces with
+    // --skybox <dir>) next to the images and exit, e.g. --compress-textures bc7
+    if (hasArg("--compress-textures")) {
+        bool compressed = Terrain::compressTexture(terrainTextureFile, textureFormat);
+        if (compressed && hasArg("--skybox")) {
+            compressed = Skybox::bakeCubemap(argValue("--skybox", ""), true, textureFormat);
+        }
+        return compressed ? 0 : -1;
+    }
+    // Offline step: bake the skybox faces and mips uncompressed into one container, e.g. --bake-skybox <dir>
+    if (hasArg("--bake-skybox")) {
+        return Skybox::bakeCubemap(argValue("--bake-skybox", ""), false) ? 0 : -1;
+    }
+
+    // Read the startup assets on the thread pool while the window and context are created
+    assets.preload({ "shaders/terrainVert.glsl", "shaders/terrainFrag.glsl", "shaders/pathVert.glsl",
+                     "shaders/pathFrag.glsl", "shaders/hikerVert.glsl", "shaders/hikerFrag.glsl",
+                     "shaders/waterVert.glsl", "shaders/waterFrag.glsl", terrainTextureFile,
+                     "resources/tex1.png" });
+
     // Initialize GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
@@ -163,38 +349,102 @@ int main() {
     Terrain terrain;
     terrain.setHeightScale(50.0f);       // Adjust to make the mountain higher
     terrain.setHorizontalScale(1.0f);    // Adjust as needed
-    if (!terrain.loadTerrainData("/Users/sumaia/Desktop/triangle/triangle/resources/graydata.png")) {
-            return -1;
+    terrain.setUse16BitIndices(true);    // Halves index bandwidth
+    if (hasArg("--strips")) {
+        terrain.setTopology(TerrainTopology::TRIANGLE_STRIP);
+    }
+    if (hasArg("--adaptive")) {
+        terrain.setAdaptiveMaxError(adaptiveMaxError);
     }
-    if (!terrain.loadTexture("/Users/sumaia/Desktop/triangle/triangle/resources/tex2.png")) {
+    // Droplet hydraulic erosion while baking, e.g. --erosion 250000
+    if (hasArg("--erosion")) {
+        terrain.setErosionDroplets(erosionDroplets);
+    }
+    if (useProcedural) {
+        terrain.setProceduralSource(proceduralSettings, proceduralSize);
+    }
+    // Sun lighting with horizon-map shadows; hold T to advance the clock
+    if (hasArg("--time-of-day") && !useTiledWorld) {
+        terrain.setTimeOfDay(startTimeOfDay);
+    }
+    // The heightmap is built on a worker thread and streamed in while frames are drawn;
+    // with --tiled only the tiles around the hiker are ever built
+    if (!useTiledWorld) {
+        terrain.loadTerrainDataAsync(heightmapFile);
+    } else {
+        // Lakes, shadows and overlays are baked from the whole grid, which tiling never
+        // holds, so they would not match the tiled ground
+        std::cout << "INFO: Tiled ground only; water, sun shadows and overlays need the whole grid" << std::endl;
+    }
+    if (!terrain.loadTexture(terrainTextureFile)) {
         std::cerr << "ERROR: Failed to load terrain texture"<< std::endl;;
             return -1;
         }
-    // Load hiker path
+    // Ground layers blended by the splat map: grass, then rock; scree and snow are tinted from rock
+    if (!useTiledWorld &&
+        !terrain.loadTextureLayers({ assets.resolve("resources/tex2.png"), assets.resolve("resources/tex1.png") })) {
+        std::cerr << "ERROR: Failed to load terrain layer textures" << std::endl;
+    }
+    // Hiker path is loaded once the terrain heights are available
     Animator animator;
-    Hiker hiker("/Users/sumaia/Desktop/triangle/triangle/resources/hiker_path.txt");
+    Hiker hiker(assets.resolve("resources/hiker_path.txt"));
     hiker.setTerrain(&terrain);
-    hiker.setScales(terrain.getHorizontalScale(), terrain.getHeightScale());
-
-    if (!hiker.loadPathData(terrain)) {
-        std::cerr << "ERROR: Failed to load hiker path data"<< std::endl;
-        return -1;
+    bool worldLoaded = false;
+    // Rivers from flow accumulation with --rivers <upstream samples>
+    bool showRivers = hasArg("--rivers") && !useTiledWorld;
+    Hydrology hydrology;
+    if (showRivers) {
+        hydrology.setRiverThreshold(riverThreshold);
     }
-    else {
-        std::cout << "INFO: Hiker path data loaded successfully."<< std::endl;
-       
+    // Contour lines with --contours <interval>; [ and ] halve and double the interval
+    bool showContours = hasArg("--contours") && !useTiledWorld;
+    ContourLines contours;
+    bool contourKeyDown = false;
+    // Names the most prominent summits near the hiker with --peaks
+    bool showPeaks = hasArg("--peaks") && !useTiledWorld;
+    PeakIndex peakIndex;
+    // Tints what the hiker can see with --viewshed, refreshed a few sectors at a time as they walk
+    bool showViewshed = hasArg("--viewshed") && !useTiledWorld;
+    Viewshed viewshed;
+    std::vector<Peak> nearbySummits, listedSummits;
+    VirtualTexture colorMap;
+    // With --tiled the ground is streamed in tiles around the hiker
+    TiledTerrain tiledWorld;
+    tiledWorld.setMemoryBudget(static_cast<size_t>(tileBudgetMB * 1024.0 * 1024.0));
+    const HeightField* ground = &terrain;
+    if (useTiledWorld) {
+        tiledWorld.setHorizontalScale(terrain.getHorizontalScale());
+        tiledWorld.setTexture(terrain.getTextureID());
+        // A procedural world is generated per tile, so it can be far larger than the baked grid
+        TileSource source = useProcedural ? TiledTerrain::proceduralSource(proceduralSettings, kProceduralWorldSize)
+            : DEMFile::isDEMFile(heightmapFile)
+            ? TiledTerrain::demSource(heightmapFile, terrain.getHeightScale())
+            : TiledTerrain::imageSource(heightmapFile, terrain.getHeightScale());
+        if (!tiledWorld.setSource(source)) {
+            return -1;
+        }
+        ground = &tiledWorld;
+        hiker.setTerrain(ground);
+        // Heights outside the resident tiles are read from the source, so the path loads at once
+        hiker.setScales(terrain.getHorizontalScale(), terrain.getHeightScale());
+        if (!hiker.loadPathData(*ground)) {
+            std::cerr << "ERROR: Failed to load hiker path data"<< std::endl;
+            return -1;
+        }
+        worldLoaded = true;
     }
     glEnable(GL_DEPTH_TEST);
 //    glClearColor(0.5f, 0.7f, 0.9f, 1.0f);  Set a clear color that's not black
     glClearColor(0.53f, 0.81f, 0.92f, 1.0f);
-    // Load shaders
-    Shader terrainShader("/Users/sumaia/Desktop/triangle/triangle/shaders/terrainVert.glsl", "/Users/sumaia/Desktop/triangle/triangle/shaders/terrainFrag.glsl");
-    Shader pathShader("/Users/sumaia/Desktop/triangle/triangle/shaders/pathVert.glsl",
-                      "/Users/sumaia/Desktop/triangle/triangle/shaders/pathFrag.glsl");
-    Shader hikerShader("/Users/sumaia/Desktop/triangle/triangle/shaders/hikerVert.glsl", "/Users/sumaia/Desktop/triangle/triangle/shaders/hikerFrag.glsl"); // New shader for hiker
-    
-    Shader waterShader("/Users/sumaia/Desktop/triangle/triangle/shaders/waterVert.glsl",
-                       "/Users/sumaia/Desktop/triangle/triangle/shaders/waterFrag.glsl");
+    // Load shaders; the asset manager shares each program with other users of its sources
+    std::shared_ptr<Shader> terrainShaderAsset = assets.loadShader("shaders/terrainVert.glsl", "shaders/terrainFrag.glsl");
+    std::shared_ptr<Shader> pathShaderAsset = assets.loadShader("shaders/pathVert.glsl", "shaders/pathFrag.glsl");
+    std::shared_ptr<Shader> hikerShaderAsset = assets.loadShader("shaders/hikerVert.glsl", "shaders/hikerFrag.glsl"); // New shader for hiker
+    std::shared_ptr<Shader> waterShaderAsset = assets.loadShader("shaders/waterVert.glsl", "shaders/waterFrag.glsl");
+    Shader& terrainShader = *terrainShaderAsset;
+    Shader& pathShader = *pathShaderAsset;
+    Shader& hikerShader = *hikerShaderAsset;
+    Shader& waterShader = *waterShaderAsset;
    
     if (!waterShader.isLoaded() )
     {
@@ -205,16 +455,27 @@ int main() {
         return -1;
     }
 
+    // The page file is cut on first use and reused afterwards
+    if (useColorMap && !useTiledWorld) {
+        const std::string pageFile = colorMapFile + ".pages";
+        bool havePages = static_cast<bool>(std::ifstream(pageFile)) || VirtualTexture::buildPageFile(colorMapFile, pageFile);
+        if (!havePages || !colorMap.open(pageFile)) {
+            std::cerr << "ERROR: Failed to load color map " << colorMapFile << std::endl;
+        }
+    }
+
     // Pass terrain shader to terrain
     terrain.setShader(&terrainShader);
+    tiledWorld.setShader(&terrainShader);
+
+    // Sky from the faces in --skybox <dir>, drawn behind everything else
+    bool showSkybox = hasArg("--skybox") && Skybox::getInstance().initialize(argValue("--skybox", ""));
 
     // Initialize hiker model
     initHikerModel();
 
     // Set initial time
     lastFrame = static_cast<float>(glfwGetTime());
-    // Setup water plane
-    terrain.setupWaterPlane();
     // Main render loop
     while (!glfwWindowShouldClose(window)) {
         // Frame timing
@@ -222,12 +483,104 @@ int main() {
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        // Stream the terrain in with a bounded upload per frame; tiles are uploaded below
+        bool terrainReady = !useTiledWorld && terrain.updateAsyncLoad(kTerrainUploadBytesPerFrame);
+        if (terrain.getLoadState() == TerrainLoadState::FAILED) {
+            return -1;
+        }
+        if (!worldLoaded && terrain.hasHeightData()) {
+            worldLoaded = true;
+            hiker.setScales(terrain.getHorizontalScale(), terrain.getHeightScale());
+            if (!hiker.loadPathData(*ground)) {
+                std::cerr << "ERROR: Failed to load hiker path data"<< std::endl;
+                return -1;
+            }
+            else {
+                std::cout << "INFO: Hiker path data loaded successfully."<< std::endl;
+            }
+            // Setup water plane
+            terrain.setupWaterPlane();
+            if (colorMap.isOpen()) {
+                glm::vec2 halfExtent = glm::vec2(terrain.getWidth() - 1, terrain.getHeight() - 1) *
+                                       terrain.getHorizontalScale() * 0.5f;
+                colorMap.setWorldRect(-halfExtent, halfExtent, (terrain.getMinHeight() + terrain.getMaxHeight()) * 0.5f);
+                terrain.setColorMap(&colorMap);
+            }
+            if (showContours) {
+                contours.setHeightGrid(&terrain.getHeights(), terrain.getWidth(), terrain.getHeight(),
+                                       terrain.getHorizontalScale());
+                contours.setInterval(contourInterval);
+            }
+            if (showViewshed) {
+                viewshed.setHeightGrid(&terrain.getHeights(), terrain.getWidth(), terrain.getHeight(),
+                                       terrain.getHorizontalScale());
+            }
+            if (showPeaks) {
+                auto peakStart = std::chrono::steady_clock::now();
+                peakIndex.build(terrain.getHeights(), terrain.getWidth(), terrain.getHeight(), terrain.getHorizontalScale());
+                double peakMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - peakStart).count();
+                std::cout << "INFO: " << peakIndex.getPeaks().size() << " summits indexed in " << peakMs << " ms" << std::endl;
+            }
+            if (showRivers) {
+                hydrology.computeAsync(&terrain.getHeights(), terrain.getWidth(), terrain.getHeight(),
+                                       terrain.getHorizontalScale());
+            }
+            if (runBenchmarks) {
+                terrain.benchmarkVertexCache(16);
+                terrain.benchmarkVertexCache(32);
+                terrain.benchmarkRaycast(4096);
+
+                // Full-grid viewshed from the hiker's start, then one incremental update after a step
+                Viewshed viewshedBenchmark;
+                viewshedBenchmark.setHeightGrid(&terrain.getHeights(), terrain.getWidth(), terrain.getHeight(),
+                                                terrain.getHorizontalScale());
+                glm::vec3 start = hiker.getPosition();
+                glm::vec2 observer = terrain.getSampleCoordinates(start.x, start.z);
+                auto viewshedStart = std::chrono::steady_clock::now();
+                viewshedBenchmark.compute(observer);
+                double viewshedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - viewshedStart).count();
+                viewshedStart = std::chrono::steady_clock::now();
+                int sectors = viewshedBenchmark.refresh(observer + glm::vec2(8.0f, 0.0f), Viewshed::getSectorCount() / 4);
+                double refreshMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - viewshedStart).count();
+                std::cout << "INFO: Viewshed " << terrain.getWidth() << " x " << terrain.getHeight() << ": full "
+                          << viewshedMs << " ms, " << viewshedBenchmark.countVisible() << " visible samples; update of "
+                          << sectors << " of " << Viewshed::getSectorCount() << " sectors " << refreshMs << " ms" << std::endl;
+
+                HydraulicErosion().benchmark(terrain.getHeights(), terrain.getWidth(), terrain.getHeight());
+                ProceduralTerrain(proceduralSettings).benchmark(1024);
+                ContourLines contourBenchmark;
+                contourBenchmark.setHeightGrid(&terrain.getHeights(), terrain.getWidth(), terrain.getHeight(),
+                                               terrain.getHorizontalScale());
+                contourBenchmark.benchmark();
+                PeakIndex().benchmark(terrain.getHeights(), terrain.getWidth(), terrain.getHeight(), terrain.getHorizontalScale());
+                Hydrology().compute(terrain.getHeights(), terrain.getWidth(), terrain.getHeight(), terrain.getHorizontalScale());
+
+                // Triangle count per error threshold, to pick a budget per deployment
+                const TerrainRTIN& mesher = terrain.getAdaptiveMesher();
+                for (const RTINBudget& entry : mesher.errorBudgetTable({ 0.0f, 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f })) {
+                    std::cout << "INFO: Adaptive mesh max error " << entry.maxError << ": "
+                              << entry.triangles << " triangles" << std::endl;
+                }
+                std::cout << "INFO: Adaptive mesh error for 500k triangles: "
+                          << mesher.errorForTriangleBudget(500000) << std::endl;
+            }
+        }
+
     
         // Clear the screen
         glClearColor(0.5f, 0.7f, 0.9f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
         processInput(window);
+        if (terrain.getTimeOfDay() >= 0.0f && glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS) {
+            terrain.setTimeOfDay(terrain.getTimeOfDay() + deltaTime * kClockHoursPerSecond);
+        }
+        bool halveInterval = glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+        bool doubleInterval = glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+        if (showContours && worldLoaded && (halveInterval || doubleInterval) && !contourKeyDown) {
+            contours.setInterval(contours.getInterval() * (halveInterval ? 0.5f : 2.0f));
+        }
+        contourKeyDown = halveInterval || doubleInterval;
         // Update camera front vector based on mouse movement
         cameraFront.x = cos(glm::radians(yaw)) * cos(glm::radians(pitch));
         cameraFront.y = sin(glm::radians(pitch));
@@ -236,33 +589,92 @@ int main() {
 
         // Camera/view transformation
         glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + cameraFront, cameraUp);
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 1000.0f);
-
-        // Render terrain
-        terrain.render(glm::mat4(1.0f), view, projection, cameraPosition);
-        // Render water
-        
-        waterShader.use();
-        waterShader.setFloat("time", static_cast<float>(glfwGetTime())); // Animate water
-        terrain.renderWater(glm::mat4(1.0f), view, projection, cameraPosition, waterShader);
-//        
+        glm::mat4 projection = glm::perspective(glm::radians(kFieldOfView), (float)SCR_WIDTH / SCR_HEIGHT, 0.1f, 1000.0f);
 
-        // Update hiker's position
-        hiker.updatePosition(deltaTime, terrain);
-
-        // Render hiker's path
-        hiker.renderPath(view, projection, pathShader);
-
-        // Render hiker at current position
-        glm::vec3 hikerPosition = hiker.getPosition();
-        renderHiker(hikerPosition, hikerShader, view, projection);
+        if (useTiledWorld) {
+            // Keep tiles around the hiker and prefetch along the path ahead; drawn once the
+            // tile under the hiker is resident
+            tiledWorld.update(hiker.getPosition(), { hiker.getPositionAhead(1.0f), hiker.getPositionAhead(3.0f) });
+            terrainReady = tiledWorld.isReady();
+        }
+        if (terrainReady) {
+            // Render terrain
+            if (useTiledWorld) {
+                tiledWorld.render(glm::mat4(1.0f), view, projection, cameraPosition);
+            } else {
+                terrain.setRiverOverlay(hydrology.update() ? hydrology.getOverlayTexture() : 0);
+                if (showViewshed) {
+                    glm::vec3 eye = hiker.getPosition();
+                    bool viewshedReady = viewshed.update(terrain.getSampleCoordinates(eye.x, eye.z));
+                    terrain.setVisibilityMask(viewshedReady ? viewshed.getTexture() : 0);
+                }
+                colorMap.update(cameraPosition, SCR_HEIGHT / (2.0f * std::tan(glm::radians(kFieldOfView) * 0.5f)));
+                terrain.render(glm::mat4(1.0f), view, projection, cameraPosition);
+                hydrology.renderRivers(view, projection, pathShader);
+                if (showContours) {
+                    contours.render(view, projection, pathShader);
+                }
+                // Render water
+
+                waterShader.use();
+                waterShader.setFloat("time", static_cast<float>(glfwGetTime())); // Animate water
+                terrain.renderWater(glm::mat4(1.0f), view, projection, cameraPosition, waterShader);
+            }
+
+            // Update hiker's position
+            hiker.updatePosition(deltaTime, *ground);
+
+            // Render hiker's path
+            hiker.renderPath(view, projection, pathShader);
+
+            // Render hiker at current position
+            glm::vec3 hikerPosition = hiker.getPosition();
+            renderHiker(hikerPosition, hikerShader, view, projection);
+
+            // List the summits around the hiker whenever they change
+            if (showPeaks) {
+                peakIndex.query(hikerPosition, kSummitRadius, kSummitCount, nearbySummits);
+                bool changed = nearbySummits.size() != listedSummits.size();
+                for (size_t i = 0; !changed && i < nearbySummits.size(); ++i) {
+                    changed = nearbySummits[i].x != listedSummits[i].x || nearbySummits[i].z != listedSummits[i].z;
+                }
+                if (changed) {
+                    listedSummits = nearbySummits;
+                    std::cout << "INFO: Summits near the hiker:";
+                    for (const Peak& summit : listedSummits) {
+                        std::cout << " [" << "height " << summit.position.y << ", prominence " << summit.prominence << ", "
+                                  << glm::distance(glm::vec2(summit.position.x, summit.position.z),
+                                                   glm::vec2(hikerPosition.x, hikerPosition.z)) << " away]";
+                    }
+                    std::cout << std::endl;
+                }
+            }
+        }
+        if (showSkybox) {
+            // Rotation only, so the sky stays at infinity
+            Skybox::getInstance().render(glm::mat4(glm::mat3(view)), projection);
+        }
         // Output hiker progress
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
+    if (useTiledWorld && runBenchmarks) {
+        TileCacheStats tileStats = tiledWorld.getStats();
+        std::cout << "INFO: Tile cache hits " << tileStats.hits << ", misses " << tileStats.misses
+                  << ", prefetched " << tileStats.prefetched << ", evicted " << tileStats.evicted
+                  << ", resident " << tileStats.residentTiles << " tiles (" << tileStats.residentBytes << " bytes)" << std::endl;
+    }
     // Cleanup resources
+    tiledWorld.cleanup();
+    hydrology.cleanup();
+    viewshed.cleanup();
+    contours.cleanup();
+    colorMap.cleanup();
     terrain.cleanup();
     hiker.cleanup();
+    if (showSkybox) {
+        Skybox::getInstance().cleanup();
+    }
 
     // Cleanup hiker model
     glDeleteVertexArrays(1, &hikerVAO);
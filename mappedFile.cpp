@@ -0,0 +1,66 @@
+#include "mappedFile.h"
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+MappedFile::MappedFile() : mapping(nullptr), length(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "ERROR::MAPPED_FILE::FAILED_TO_OPEN: " << path << std::endl;
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        std::cerr << "ERROR::MAPPED_FILE::EMPTY_OR_UNREADABLE: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void* address = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        std::cerr << "ERROR::MAPPED_FILE::FAILED_TO_MAP: " << path << std::endl;
+        return false;
+    }
+    mapping = address;
+    length = static_cast<size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        munmap(mapping, length);
+        mapping = nullptr;
+        length = 0;
+    }
+}
+
+void MappedFile::adviseSequential() const {
+    if (mapping) madvise(mapping, length, MADV_SEQUENTIAL);
+}
+
+void MappedFile::adviseRandom() const {
+    if (mapping) madvise(mapping, length, MADV_RANDOM);
+}
+
+const unsigned char* MappedFile::data() const {
+    return static_cast<const unsigned char*>(mapping);
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
+
+bool MappedFile::isOpen() const {
+    return mapping != nullptr;
+}
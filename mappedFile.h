@@ -0,0 +1,53 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a file.
+ *
+ * Pages are faulted in by the OS as they are touched, so large files cost nothing
+ * until they are read and are never copied into a decode buffer.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Maps a file, unmapping any previous one.
+     * @param path Path to the file.
+     * @return True if successful, false otherwise.
+     */
+    bool open(const std::string& path);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    void close();
+
+    /**
+     * @brief Hints that the mapping will be read front to back.
+     */
+    void adviseSequential() const;
+
+    /**
+     * @brief Hints that the mapping will be read in scattered windows.
+     */
+    void adviseRandom() const;
+
+    const unsigned char* data() const;
+    size_t size() const;
+    bool isOpen() const;
+
+private:
+    void* mapping;   ///< Start of the mapping, or nullptr.
+    size_t length;   ///< Mapped bytes.
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,220 @@
+#include "peakIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace {
+const float kDefaultMinProminence = 5.0f;
+const int kBucketSamples = 64;
+const int kNeighbourX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+const int kNeighbourZ[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
+
+/// Maps a float to an unsigned key with the same order.
+inline uint32_t orderedBits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+/**
+ * @brief Sample indices from highest to lowest; equal heights keep index order.
+ *        LSD radix sort on (key << 32 | index) in three 11-bit digits, skipping
+ *        digits all keys share.
+ */
+std::vector<uint32_t> sortDescending(const std::vector<float>& heights) {
+    const int digitBits = 11;
+    const uint64_t digitMask = (1u << digitBits) - 1;
+    size_t count = heights.size();
+    std::vector<uint64_t> items(count), scratch(count);
+    for (size_t i = 0; i < count; ++i) {
+        items[i] = static_cast<uint64_t>(~orderedBits(heights[i])) << 32 | static_cast<uint32_t>(i);
+    }
+    std::vector<size_t> histogram((1u << digitBits) + 1);
+    for (int shift = 32; shift < 64; shift += digitBits) {
+        std::fill(histogram.begin(), histogram.end(), 0);
+        for (uint64_t item : items) {
+            histogram[((item >> shift) & digitMask) + 1]++;
+        }
+        if (histogram[((items[0] >> shift) & digitMask) + 1] == count) continue;
+        for (size_t b = 1; b < histogram.size(); ++b) {
+            histogram[b] += histogram[b - 1];
+        }
+        for (uint64_t item : items) {
+            scratch[histogram[(item >> shift) & digitMask]++] = item;
+        }
+        items.swap(scratch);
+    }
+    std::vector<uint32_t> order(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[i] = static_cast<uint32_t>(items[i]);
+    }
+    return order;
+}
+
+inline int32_t findRoot(std::vector<int32_t>& parent, int32_t cell) {
+    // Path halving
+    while (parent[cell] != cell) {
+        parent[cell] = parent[parent[cell]];
+        cell = parent[cell];
+    }
+    return cell;
+}
+}
+
+PeakIndex::PeakIndex()
+    : minProminence(kDefaultMinProminence), horizontalScale(1.0f), halfWidth(0.0f), halfDepth(0.0f),
+      bucketSize(kBucketSamples), bucketsX(0), bucketsZ(0) {}
+
+void PeakIndex::setMinimumProminence(float prominence) {
+    minProminence = prominence;
+}
+
+const std::vector<Peak>& PeakIndex::getPeaks() const {
+    return peaks;
+}
+
+void PeakIndex::build(const std::vector<float>& heights, int width, int height, float scale) {
+    peaks.clear();
+    horizontalScale = scale;
+    halfWidth = (width - 1) * scale * 0.5f;
+    halfDepth = (height - 1) * scale * 0.5f;
+    if (width < 1 || height < 1 || heights.size() < static_cast<size_t>(width) * height) {
+        buildBuckets(width, height);
+        return;
+    }
+
+    std::vector<uint32_t> order = sortDescending(heights);
+    // Roots are always the summit of their region: the lower region joins the higher
+    std::vector<int32_t> parent(heights.size(), -1);
+    auto higher = [&heights](int32_t a, int32_t b) {
+        return heights[a] > heights[b] || (heights[a] == heights[b] && a < b);
+    };
+    auto addPeak = [&](int32_t summit, float prominence) {
+        if (prominence < minProminence) return;
+        Peak peak;
+        peak.x = summit % width;
+        peak.z = summit / width;
+        peak.position = glm::vec3(peak.x * scale - halfWidth, heights[summit], peak.z * scale - halfDepth);
+        peak.prominence = prominence;
+        peaks.push_back(peak);
+    };
+
+    for (uint32_t index : order) {
+        int32_t cell = static_cast<int32_t>(index);
+        int x = cell % width, z = cell / width;
+        parent[cell] = cell;
+        bool joined = false;
+        for (int n = 0; n < 8; ++n) {
+            int nx = x + kNeighbourX[n], nz = z + kNeighbourZ[n];
+            if (nx < 0 || nz < 0 || nx >= width || nz >= height) continue;
+            int32_t neighbour = nz * width + nx;
+            if (parent[neighbour] < 0) continue;
+            int32_t region = findRoot(parent, neighbour);
+            if (!joined) {
+                parent[cell] = region;
+                joined = true;
+                continue;
+            }
+            int32_t own = findRoot(parent, cell);
+            if (region == own) continue;
+            // Two regions meet at this col; the lower summit's prominence ends here
+            int32_t low = higher(region, own) ? own : region;
+            int32_t high = low == own ? region : own;
+            addPeak(low, heights[low] - heights[cell]);
+            parent[low] = high;
+        }
+    }
+    // The highest summit stands above the lowest point of the grid
+    if (!order.empty()) {
+        addPeak(static_cast<int32_t>(order.front()), heights[order.front()] - heights[order.back()]);
+    }
+
+    std::sort(peaks.begin(), peaks.end(), [](const Peak& a, const Peak& b) {
+        return a.prominence > b.prominence;
+    });
+    buildBuckets(width, height);
+}
+
+void PeakIndex::buildBuckets(int width, int height) {
+    bucketsX = std::max(1, (width + bucketSize - 1) / bucketSize);
+    bucketsZ = std::max(1, (height + bucketSize - 1) / bucketSize);
+    bucketStart.assign(static_cast<size_t>(bucketsX) * bucketsZ + 1, 0);
+    bucketPeaks.resize(peaks.size());
+    auto bucketOf = [this](const Peak& peak) {
+        return static_cast<size_t>(peak.z / bucketSize) * bucketsX + peak.x / bucketSize;
+    };
+    // Counting sort; peaks are already by prominence, which the buckets keep
+    for (const Peak& peak : peaks) {
+        bucketStart[bucketOf(peak) + 1]++;
+    }
+    for (size_t b = 1; b < bucketStart.size(); ++b) {
+        bucketStart[b] += bucketStart[b - 1];
+    }
+    std::vector<uint32_t> next(bucketStart.begin(), bucketStart.end() - 1);
+    for (uint32_t p = 0; p < peaks.size(); ++p) {
+        bucketPeaks[next[bucketOf(peaks[p])]++] = p;
+    }
+}
+
+void PeakIndex::query(const glm::vec3& position, float radius, size_t count, std::vector<Peak>& result) const {
+    result.clear();
+    if (count == 0 || peaks.empty()) return;
+    float centerX = (position.x + halfWidth) / horizontalScale;
+    float centerZ = (position.z + halfDepth) / horizontalScale;
+    float reach = radius / horizontalScale;
+    int minX = std::max(0, static_cast<int>(std::floor((centerX - reach) / bucketSize)));
+    int maxX = std::min(bucketsX - 1, static_cast<int>(std::floor((centerX + reach) / bucketSize)));
+    int minZ = std::max(0, static_cast<int>(std::floor((centerZ - reach) / bucketSize)));
+    int maxZ = std::min(bucketsZ - 1, static_cast<int>(std::floor((centerZ + reach) / bucketSize)));
+
+    // Indices of the best peaks so far; peaks are ordered by prominence, so a smaller
+    // index is a better peak and the worst kept one is the largest index
+    std::vector<uint32_t> best;
+    best.reserve(count + 1);
+    float reachSquared = reach * reach;
+    for (int bz = minZ; bz <= maxZ; ++bz) {
+        for (int bx = minX; bx <= maxX; ++bx) {
+            size_t bucket = static_cast<size_t>(bz) * bucketsX + bx;
+            for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; ++i) {
+                uint32_t p = bucketPeaks[i];
+                // The rest of the bucket is less prominent than everything kept
+                if (best.size() == count && p > best.front()) break;
+                float dx = peaks[p].x - centerX, dz = peaks[p].z - centerZ;
+                if (dx * dx + dz * dz > reachSquared) continue;
+                best.push_back(p);
+                std::push_heap(best.begin(), best.end());
+                if (best.size() > count) {
+                    std::pop_heap(best.begin(), best.end());
+                    best.pop_back();
+                }
+            }
+        }
+    }
+    std::sort(best.begin(), best.end());
+    for (uint32_t p : best) {
+        result.push_back(peaks[p]);
+    }
+}
+
+void PeakIndex::benchmark(const std::vector<float>& heights, int width, int height, float scale) {
+    auto start = std::chrono::steady_clock::now();
+    build(heights, width, height, scale);
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    const int queries = 10000;
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> across(-halfWidth, halfWidth), along(-halfDepth, halfDepth);
+    std::vector<Peak> result;
+    size_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; ++q) {
+        query(glm::vec3(across(generator), 0.0f, along(generator)), 500.0f * scale, 5, result);
+        found += result.size();
+    }
+    double queryUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / queries;
+    std::cout << "INFO: Peak index " << width << " x " << height << ": " << peaks.size() << " peaks with prominence >= "
+              << minProminence << " built in " << buildMs << " ms; top-5 within 500 samples: " << queryUs
+              << " us per query (" << found << " found)" << std::endl;
+}
@@ -0,0 +1,80 @@
+#ifndef PEAK_INDEX_H
+#define PEAK_INDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/**
+ * @brief A summit and how far it stands above the terrain around it.
+ */
+struct Peak {
+    glm::vec3 position;   ///< World position of the summit.
+    int x, z;             ///< Sample coordinates of the summit.
+    float prominence;     ///< Height above the highest col leading to higher ground.
+};
+
+/**
+ * @class PeakIndex
+ * @brief Topographic prominence of every summit in a height grid, with a spatial index.
+ *
+ * Samples are visited from high to low (radix sort of the height bits, linear in the
+ * grid size) and merged with their already visited neighbours in a union-find. A
+ * sample with no visited neighbour starts a new summit; where two regions meet, the
+ * region with the lower summit ends there and that summit's prominence is its height
+ * above the meeting point. Summits above the minimum prominence are bucketed in a
+ * uniform grid, each bucket sorted by prominence, so nearby-summit queries only touch
+ * the buckets under the search circle.
+ */
+class PeakIndex {
+public:
+    PeakIndex();
+
+    /**
+     * @brief Drops summits less prominent than this from the index.
+     * @param prominence Minimum prominence in world units.
+     */
+    void setMinimumProminence(float prominence);
+
+    /**
+     * @brief Finds the summits and builds the index.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void build(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief The most prominent summits within a radius, most prominent first.
+     * @param position World position; only x and z are used.
+     * @param radius Search radius in world units.
+     * @param count Maximum number of summits.
+     * @param result Receives the summits.
+     */
+    void query(const glm::vec3& position, float radius, size_t count, std::vector<Peak>& result) const;
+
+    /**
+     * @brief All indexed summits, most prominent first.
+     */
+    const std::vector<Peak>& getPeaks() const;
+
+    /**
+     * @brief Times a build of the grid and a batch of queries and prints the results.
+     */
+    void benchmark(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+private:
+    float minProminence;
+    float horizontalScale;
+    float halfWidth, halfDepth;
+    std::vector<Peak> peaks;
+    int bucketSize;                     ///< Samples per bucket side.
+    int bucketsX, bucketsZ;
+    std::vector<uint32_t> bucketStart;  ///< First peak of each bucket in bucketPeaks, plus an end.
+    std::vector<uint32_t> bucketPeaks;  ///< Indices into peaks, by bucket, most prominent first.
+
+    void buildBuckets(int width, int height);
+};
+
+#endif // PEAK_INDEX_H
@@ -0,0 +1,161 @@
+#include "proceduralTerrain.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+const float kSkew = 0.36602540378f;    // (sqrt(3) - 1) / 2
+const float kUnskew = 0.21132486540f;  // (3 - sqrt(3)) / 6
+// Octaves and relative frequency of the warp field
+const int kWarpOctaves = 3;
+const float kWarpFrequency = 0.5f;
+
+inline uint32_t hashCorner(int32_t i, int32_t j, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(i) * 0x27d4eb2du ^ static_cast<uint32_t>(j) * 0x165667b1u ^ seed;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+inline int32_t fastFloor(float value) {
+    int32_t truncated = static_cast<int32_t>(value);
+    return truncated - static_cast<int32_t>(value < static_cast<float>(truncated));
+}
+
+/// Contribution of one simplex corner; the gradient is one of 8 directions picked by the
+/// hash. Selects are written as arithmetic so the row loop has no control flow.
+inline float cornerContribution(uint32_t hash, float x, float y) {
+    float t = std::max(0.5f - x * x - y * y, 0.0f);
+    float swap = static_cast<float>((hash >> 2) & 1u);
+    float u = x + (y - x) * swap;
+    float v = y + (x - y) * swap;
+    float signU = 1.0f - 2.0f * static_cast<float>(hash & 1u);
+    float signV = 2.0f - 4.0f * static_cast<float>((hash >> 1) & 1u);
+    float t2 = t * t;
+    return t2 * t2 * (signU * u + signV * v);
+}
+
+/**
+ * @brief 2D simplex noise of a row of positions, roughly in [-1, 1]. Written without
+ *        tables or branches so the loop vectorises.
+ */
+void simplexRow(const float* xs, const float* zs, int count, float frequency, uint32_t seed, float* out) {
+    for (int k = 0; k < count; ++k) {
+        float x = xs[k] * frequency, y = zs[k] * frequency;
+        float s = (x + y) * kSkew;
+        int32_t i = fastFloor(x + s), j = fastFloor(y + s);
+        float t = static_cast<float>(i + j) * kUnskew;
+        float x0 = x - (static_cast<float>(i) - t), y0 = y - (static_cast<float>(j) - t);
+        int32_t i1 = static_cast<int32_t>(x0 > y0);
+        int32_t j1 = 1 - i1;
+        float x1 = x0 - i1 + kUnskew, y1 = y0 - j1 + kUnskew;
+        float x2 = x0 - 1.0f + 2.0f * kUnskew, y2 = y0 - 1.0f + 2.0f * kUnskew;
+        out[k] = 40.0f * (cornerContribution(hashCorner(i, j, seed), x0, y0) +
+                          cornerContribution(hashCorner(i + i1, j + j1, seed), x1, y1) +
+                          cornerContribution(hashCorner(i + 1, j + 1, seed), x2, y2));
+    }
+}
+
+inline uint32_t octaveSeed(uint32_t seed, int octave) {
+    return seed + static_cast<uint32_t>(octave + 1) * 0x9E3779B9u;
+}
+}
+
+ProceduralTerrain::ProceduralTerrain() {}
+
+ProceduralTerrain::ProceduralTerrain(const ProceduralSettings& newSettings) {
+    setSettings(newSettings);
+}
+
+void ProceduralTerrain::setSettings(const ProceduralSettings& newSettings) {
+    settings = newSettings;
+    settings.octaves = std::clamp(settings.octaves, 1, 16);
+}
+
+const ProceduralSettings& ProceduralTerrain::getSettings() const {
+    return settings;
+}
+
+void ProceduralTerrain::evaluateRow(const float* xs, const float* zs, int count, float* out) const {
+    std::vector<float> px(xs, xs + count), pz(zs, zs + count);
+    std::vector<float> noise(count), sum(count, 0.0f), weight(count, 1.0f);
+
+    // Domain warp: offset the positions by a low-frequency fBm field
+    if (settings.warpStrength > 0.0f) {
+        std::vector<float> warpX(count, 0.0f), warpZ(count, 0.0f);
+        float frequency = settings.frequency * kWarpFrequency, amplitude = 1.0f;
+        for (int octave = 0; octave < kWarpOctaves; ++octave) {
+            simplexRow(xs, zs, count, frequency, octaveSeed(settings.seed ^ 0xA511E9B3u, octave), noise.data());
+            for (int k = 0; k < count; ++k) warpX[k] += amplitude * noise[k];
+            simplexRow(xs, zs, count, frequency, octaveSeed(settings.seed ^ 0x63D83595u, octave), noise.data());
+            for (int k = 0; k < count; ++k) warpZ[k] += amplitude * noise[k];
+            frequency *= settings.lacunarity;
+            amplitude *= settings.gain;
+        }
+        for (int k = 0; k < count; ++k) {
+            px[k] += settings.warpStrength * warpX[k];
+            pz[k] += settings.warpStrength * warpZ[k];
+        }
+    }
+
+    float frequency = settings.frequency, amplitude = 1.0f, totalAmplitude = 0.0f;
+    for (int octave = 0; octave < settings.octaves; ++octave) {
+        simplexRow(px.data(), pz.data(), count, frequency, octaveSeed(settings.seed, octave), noise.data());
+        if (settings.type == NoiseType::FBM) {
+            for (int k = 0; k < count; ++k) sum[k] += amplitude * noise[k];
+        } else {
+            // Ridges where the noise crosses zero; each octave is weighted by the one
+            // before, so detail piles up on the crests and valleys stay smooth
+            for (int k = 0; k < count; ++k) {
+                float signal = 1.0f - std::fabs(noise[k]);
+                signal *= signal * weight[k];
+                weight[k] = std::clamp(signal * 2.0f, 0.0f, 1.0f);
+                sum[k] += amplitude * signal;
+            }
+        }
+        totalAmplitude += amplitude;
+        frequency *= settings.lacunarity;
+        amplitude *= settings.gain;
+    }
+
+    float scale = 1.0f / totalAmplitude;
+    bool signedNoise = settings.type == NoiseType::FBM;
+    for (int k = 0; k < count; ++k) {
+        float value = sum[k] * scale;
+        value = signedNoise ? value * 0.5f + 0.5f : value;
+        out[k] = std::clamp(value, 0.0f, 1.0f) * settings.heightScale;
+    }
+}
+
+void ProceduralTerrain::fill(float originX, float originZ, int columns, int rows, float* out) const {
+    std::vector<float> xs(columns), zs(columns);
+    for (int x = 0; x < columns; ++x) xs[x] = originX + x;
+    for (int z = 0; z < rows; ++z) {
+        std::fill(zs.begin(), zs.end(), originZ + z);
+        evaluateRow(xs.data(), zs.data(), columns, out + static_cast<size_t>(z) * columns);
+    }
+}
+
+void ProceduralTerrain::generate(std::vector<float>& heights, int width, int height) const {
+    heights.resize(static_cast<size_t>(width) * height);
+    float originX = -(width - 1) * 0.5f;
+    float originZ = -(height - 1) * 0.5f;
+    ThreadPool::getInstance().parallelFor(0, height, [&](int z) {
+        fill(originX, originZ + z, width, 1, &heights[static_cast<size_t>(z) * width]);
+    });
+}
+
+void ProceduralTerrain::benchmark(int size) const {
+    std::vector<float> heights;
+    auto start = std::chrono::steady_clock::now();
+    generate(heights, size, size);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double samplesPerSecond = seconds > 0.0 ? static_cast<double>(heights.size()) / seconds : 0.0;
+    int threads = ThreadPool::getInstance().getThreadCount();
+    std::cout << "INFO: Procedural terrain " << size << " x " << size << " (" << settings.octaves << " octaves): "
+              << seconds * 1000.0 << " ms, " << samplesPerSecond << " samples/s, "
+              << samplesPerSecond / threads << " samples/s per thread (" << threads << " threads)" << std::endl;
+}
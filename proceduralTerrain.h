@@ -0,0 +1,75 @@
+#ifndef PROCEDURAL_TERRAIN_H
+#define PROCEDURAL_TERRAIN_H
+
+#include <vector>
+#include <cstdint>
+
+enum class NoiseType {
+    FBM,      ///< Sum of simplex octaves: rolling hills.
+    RIDGED    ///< Ridged multifractal: sharp crests, smooth valleys.
+};
+
+/**
+ * @brief Parameters of the procedural heights. Frequencies are per sample.
+ */
+struct ProceduralSettings {
+    NoiseType type = NoiseType::RIDGED;
+    int octaves = 8;
+    float frequency = 1.0f / 512.0f;  ///< Frequency of the first octave.
+    float lacunarity = 2.0f;          ///< Frequency multiplier per octave.
+    float gain = 0.5f;                ///< Amplitude multiplier per octave.
+    float warpStrength = 80.0f;       ///< Domain warp offset in samples, 0 to disable.
+    float heightScale = 105.0f;       ///< Heights span 0..heightScale.
+    uint32_t seed = 1337;
+};
+
+/**
+ * @class ProceduralTerrain
+ * @brief Seamless fBm / ridged multifractal heights with domain warping.
+ *
+ * Heights are a pure function of the seed and the sample position relative to the
+ * world centre, so any window, tile or grid size produces the same surface and
+ * neighbouring windows match exactly. The simplex kernel works on whole rows with
+ * table-free integer hashing and selects instead of branches, so the compiler can
+ * vectorise it; rows run in parallel on the thread pool.
+ */
+class ProceduralTerrain {
+public:
+    ProceduralTerrain();
+    explicit ProceduralTerrain(const ProceduralSettings& settings);
+
+    void setSettings(const ProceduralSettings& settings);
+    const ProceduralSettings& getSettings() const;
+
+    /**
+     * @brief Evaluates a window of heights on the calling thread.
+     * @param originX Sample x of the first column, relative to the world centre.
+     * @param originZ Sample z of the first row, relative to the world centre.
+     * @param columns Number of columns.
+     * @param rows Number of rows.
+     * @param out Receives columns x rows heights, row-major.
+     */
+    void fill(float originX, float originZ, int columns, int rows, float* out) const;
+
+    /**
+     * @brief Evaluates a whole centred grid, rows in parallel.
+     * @param heights Receives width x height heights.
+     */
+    void generate(std::vector<float>& heights, int width, int height) const;
+
+    /**
+     * @brief Generates a size x size grid and prints samples per second, in total and
+     *        per thread.
+     */
+    void benchmark(int size) const;
+
+private:
+    ProceduralSettings settings;
+
+    /**
+     * @brief Heights of one row at arbitrary (x, z) sample positions.
+     */
+    void evaluateRow(const float* xs, const float* zs, int count, float* out) const;
+};
+
+#endif // PROCEDURAL_TERRAIN_H
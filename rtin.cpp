@@ -0,0 +1,207 @@
+#include "rtin.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdlib>
+
+namespace {
+// Depth of the hierarchy at which extraction is split into parallel tasks
+const int kParallelDepth = 8;
+}
+
+TerrainRTIN::TerrainRTIN() : gridWidth(0), gridHeight(0), size(0) {}
+
+bool TerrainRTIN::isBuilt() const {
+    return !errors.empty();
+}
+
+void TerrainRTIN::build(const std::vector<float>& heights, int width, int height) {
+    errors.clear();
+    gridWidth = width;
+    gridHeight = height;
+    if (width < 2 || height < 2 || heights.size() < static_cast<size_t>(width) * height) return;
+
+    // Smallest 2^k + 1 grid that covers the terrain
+    int tileSize = 2;
+    while (tileSize < std::max(width, height) - 1) tileSize *= 2;
+    size = tileSize + 1;
+    errors.assign(static_cast<size_t>(size) * size, 0.0f);
+
+    auto sample = [&](int x, int y) {
+        return heights[std::min(y, height - 1) * width + std::min(x, width - 1)];
+    };
+    const float refineAlways = std::numeric_limits<float>::infinity();
+
+    // Visit every triangle from the finest level to the coarsest, decoding its
+    // vertices from its implicit binary-tree id.
+    const int numSmallestTriangles = tileSize * tileSize;
+    const int numTriangles = numSmallestTriangles * 2 - 2;
+    const int lastLevelIndex = numTriangles - numSmallestTriangles;
+    for (int i = numTriangles - 1; i >= 0; --i) {
+        int id = i + 2;
+        int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0;
+        if (id & 1) {
+            bx = by = cx = tileSize;  // bottom-left triangle
+        } else {
+            ax = ay = cy = tileSize;  // top-right triangle
+        }
+        while ((id >>= 1) > 1) {
+            int mx = (ax + bx) >> 1;
+            int my = (ay + by) >> 1;
+            if (id & 1) {  // left half
+                bx = ax; by = ay;
+                ax = cx; ay = cy;
+            } else {       // right half
+                ax = bx; ay = by;
+                bx = cx; by = cy;
+            }
+            cx = mx;
+            cy = my;
+        }
+
+        // Triangles in the padding are never emitted; those crossing its border
+        // must be split until they don't
+        int minX = std::min({ ax, bx, cx }), maxX = std::max({ ax, bx, cx });
+        int minY = std::min({ ay, by, cy }), maxY = std::max({ ay, by, cy });
+        if (minX >= width - 1 || minY >= height - 1) continue;
+        bool inside = maxX <= width - 1 && maxY <= height - 1;
+
+        int middleIndex = ((ay + by) >> 1) * size + ((ax + bx) >> 1);
+        float middleError = refineAlways;
+        if (inside) {
+            float interpolated = (sample(ax, ay) + sample(bx, by)) * 0.5f;
+            middleError = std::fabs(interpolated - sample((ax + bx) >> 1, (ay + by) >> 1));
+        }
+
+        float& error = errors[middleIndex];
+        error = std::max(error, middleError);
+        if (i < lastLevelIndex) {
+            // Bigger triangles carry the error of their children
+            int leftChildIndex = ((ay + cy) >> 1) * size + ((ax + cx) >> 1);
+            int rightChildIndex = ((by + cy) >> 1) * size + ((bx + cx) >> 1);
+            error = std::max({ error, errors[leftChildIndex], errors[rightChildIndex] });
+        }
+    }
+}
+
+bool TerrainRTIN::needsSplit(const Triangle& t, float maxError) const {
+    int mx = (t.ax + t.bx) >> 1;
+    int my = (t.ay + t.by) >> 1;
+    return std::abs(t.ax - t.cx) + std::abs(t.ay - t.cy) > 1 && errors[my * size + mx] > maxError;
+}
+
+bool TerrainRTIN::isOutside(const Triangle& t) const {
+    return std::min({ t.ax, t.bx, t.cx }) >= gridWidth - 1 ||
+           std::min({ t.ay, t.by, t.cy }) >= gridHeight - 1;
+}
+
+void TerrainRTIN::collectRoots(float maxError, std::vector<Triangle>& roots) const {
+    int tileSize = size - 1;
+    std::vector<std::pair<Triangle, int>> stack = {
+        { { tileSize, tileSize, 0, 0, 0, tileSize }, 0 },
+        { { 0, 0, tileSize, tileSize, tileSize, 0 }, 0 }
+    };
+    while (!stack.empty()) {
+        auto [t, depth] = stack.back();
+        stack.pop_back();
+        if (isOutside(t)) continue;
+        if (depth >= kParallelDepth || !needsSplit(t, maxError)) {
+            roots.push_back(t);
+            continue;
+        }
+        int mx = (t.ax + t.bx) >> 1;
+        int my = (t.ay + t.by) >> 1;
+        // Pushed in reverse so roots come out in the same order as a serial traversal
+        stack.push_back({ { t.bx, t.by, t.cx, t.cy, mx, my }, depth + 1 });
+        stack.push_back({ { t.cx, t.cy, t.ax, t.ay, mx, my }, depth + 1 });
+    }
+}
+
+void TerrainRTIN::emitTriangles(const Triangle& t, float maxError, std::vector<GLuint>& out) const {
+    if (isOutside(t)) return;
+    if (needsSplit(t, maxError)) {
+        int mx = (t.ax + t.bx) >> 1;
+        int my = (t.ay + t.by) >> 1;
+        emitTriangles({ t.cx, t.cy, t.ax, t.ay, mx, my }, maxError, out);
+        emitTriangles({ t.bx, t.by, t.cx, t.cy, mx, my }, maxError, out);
+        return;
+    }
+    // (a, c, b) matches the winding of the regular grid triangles
+    out.push_back(t.ay * gridWidth + t.ax);
+    out.push_back(t.cy * gridWidth + t.cx);
+    out.push_back(t.by * gridWidth + t.bx);
+}
+
+size_t TerrainRTIN::countSubtree(const Triangle& t, float maxError) const {
+    if (isOutside(t)) return 0;
+    if (!needsSplit(t, maxError)) return 1;
+    int mx = (t.ax + t.bx) >> 1;
+    int my = (t.ay + t.by) >> 1;
+    return countSubtree({ t.cx, t.cy, t.ax, t.ay, mx, my }, maxError) +
+           countSubtree({ t.bx, t.by, t.cx, t.cy, mx, my }, maxError);
+}
+
+void TerrainRTIN::extract(float maxError, std::vector<GLuint>& out) const {
+    if (!isBuilt()) return;
+
+    std::vector<Triangle> roots;
+    collectRoots(maxError, roots);
+
+    std::vector<std::vector<GLuint>> parts(roots.size());
+    ThreadPool::getInstance().parallelFor(0, static_cast<int>(roots.size()), [&](int i) {
+        emitTriangles(roots[i], maxError, parts[i]);
+    });
+
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    out.reserve(out.size() + total);
+    for (const auto& part : parts) out.insert(out.end(), part.begin(), part.end());
+}
+
+size_t TerrainRTIN::countTriangles(float maxError) const {
+    if (!isBuilt()) return 0;
+
+    std::vector<Triangle> roots;
+    collectRoots(maxError, roots);
+
+    std::vector<size_t> counts(roots.size(), 0);
+    ThreadPool::getInstance().parallelFor(0, static_cast<int>(roots.size()), [&](int i) {
+        counts[i] = countSubtree(roots[i], maxError);
+    });
+
+    size_t total = 0;
+    for (size_t count : counts) total += count;
+    return total;
+}
+
+std::vector<RTINBudget> TerrainRTIN::errorBudgetTable(const std::vector<float>& thresholds) const {
+    std::vector<RTINBudget> table;
+    table.reserve(thresholds.size());
+    for (float threshold : thresholds) {
+        table.push_back({ threshold, countTriangles(threshold) });
+    }
+    return table;
+}
+
+float TerrainRTIN::errorForTriangleBudget(size_t maxTriangles) const {
+    if (!isBuilt()) return 0.0f;
+
+    float largest = 0.0f;
+    for (float error : errors) {
+        if (std::isfinite(error)) largest = std::max(largest, error);
+    }
+
+    // Triangle count only decreases as the threshold grows
+    float low = 0.0f, high = largest;
+    if (countTriangles(low) <= maxTriangles) return low;
+    for (int iteration = 0; iteration < 24; ++iteration) {
+        float mid = 0.5f * (low + high);
+        if (countTriangles(mid) <= maxTriangles) {
+            high = mid;
+        } else {
+            low = mid;
+        }
+    }
+    return high;
+}
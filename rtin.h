@@ -0,0 +1,91 @@
+#ifndef RTIN_H
+#define RTIN_H
+
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+
+/**
+ * @brief Triangle count of an adaptive mesh extracted at a given error.
+ */
+struct RTINBudget {
+    float maxError;     ///< Maximum vertical error in world units.
+    size_t triangles;   ///< Triangles in the extracted mesh.
+};
+
+/**
+ * @class TerrainRTIN
+ * @brief Right-triangulated irregular network over a terrain height grid.
+ *
+ * The error hierarchy is built once; meshes for any error threshold are then
+ * extracted in time linear in the number of output triangles. Meshes are crack-free
+ * and index the original width x height grid vertices, so they can share the
+ * terrain's vertex buffer.
+ */
+class TerrainRTIN {
+public:
+    TerrainRTIN();
+
+    /**
+     * @brief Builds the error hierarchy for a height grid.
+     *
+     * Grids that are not 2^k + 1 square are padded; triangles crossing the padding
+     * border are always refined so every emitted triangle lies inside the grid.
+     * @param heights Row-major heights.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     */
+    void build(const std::vector<float>& heights, int width, int height);
+
+    /**
+     * @brief Extracts a triangle list whose vertical error does not exceed maxError.
+     *
+     * Top-level subtrees of the hierarchy are extracted in parallel on the thread pool.
+     * @param maxError Maximum vertical error in world units.
+     * @param out Triangle list indices into the width x height grid.
+     */
+    void extract(float maxError, std::vector<GLuint>& out) const;
+
+    /**
+     * @brief Counts the triangles extract would produce, without emitting them.
+     * @param maxError Maximum vertical error in world units.
+     * @return Number of triangles.
+     */
+    size_t countTriangles(float maxError) const;
+
+    /**
+     * @brief Triangle counts for a set of error thresholds.
+     * @param thresholds Error thresholds in world units.
+     * @return One entry per threshold.
+     */
+    std::vector<RTINBudget> errorBudgetTable(const std::vector<float>& thresholds) const;
+
+    /**
+     * @brief Smallest error threshold whose mesh fits a triangle budget.
+     * @param maxTriangles Triangle budget.
+     * @return Error threshold in world units.
+     */
+    float errorForTriangleBudget(size_t maxTriangles) const;
+
+    /**
+     * @brief Returns true once build has been called on a non-empty grid.
+     */
+    bool isBuilt() const;
+
+private:
+    struct Triangle {
+        int ax, ay, bx, by, cx, cy;
+    };
+
+    int gridWidth, gridHeight;   ///< Dimensions of the source grid.
+    int size;                    ///< Padded grid size (2^k + 1).
+    std::vector<float> errors;   ///< Hierarchical error per padded grid vertex.
+
+    bool needsSplit(const Triangle& t, float maxError) const;
+    bool isOutside(const Triangle& t) const;
+    void collectRoots(float maxError, std::vector<Triangle>& roots) const;
+    void emitTriangles(const Triangle& t, float maxError, std::vector<GLuint>& out) const;
+    size_t countSubtree(const Triangle& t, float maxError) const;
+};
+
+#endif // RTIN_H
@@ -1,31 +1,36 @@
 #include "shader.h"
-#include <fstream>
-#include <sstream>
+#include "assetManager.h"
 #include <iostream>
 #include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
+namespace {
+// Whole file as text, or empty if it cannot be read; packed shaders come from the archive
+std::string readSource(const char* path) {
+    AssetData source = AssetManager::getInstance().readFile(path);
+    if (!source) {
+        return std::string();
+    }
+    return std::string(reinterpret_cast<const char*>(source.data), source.size);
+}
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath)
+    : Shader(ShaderSource{ readSource(vertexPath), readSource(fragmentPath) })
+{
+}
+
+Shader::Shader(const ShaderSource& source)
     : programID(0), loaded(false)
 {
-    // Load shader source code from files
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile(vertexPath), fShaderFile(fragmentPath);
-    if (!vShaderFile.is_open() || !fShaderFile.is_open()) {
+    if (source.vertex.empty() || source.fragment.empty()) {
         errorLog = "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ";
         return;
     }
-    std::stringstream vShaderStream, fShaderStream;
-    vShaderStream << vShaderFile.rdbuf();
-    fShaderStream << fShaderFile.rdbuf();
-    vertexCode = vShaderStream.str();
-    fragmentCode = fShaderStream.str();
-    vShaderFile.close();
-    fShaderFile.close();
 
     // Compile shaders
-    unsigned int vertexShader = compileShader(vertexCode, GL_VERTEX_SHADER);
-    unsigned int fragmentShader = compileShader(fragmentCode, GL_FRAGMENT_SHADER);
+    unsigned int vertexShader = compileShader(source.vertex, GL_VERTEX_SHADER);
+    unsigned int fragmentShader = compileShader(source.fragment, GL_FRAGMENT_SHADER);
     if (!vertexShader || !fragmentShader) {
         errorLog += "ERROR::SHADER::COMPILATION_FAILED\n";
         glDeleteProgram(programID);
@@ -83,6 +88,13 @@ void Shader::setMat4(const std::string& name, const glm::mat4& mat) const {
     }
 }
 
+void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
+    GLint location = getUniformLocation(name);
+    if (location != -1) {
+        glUniform2fv(location, 1, &value[0]);
+    }
+}
+
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
     GLint location = getUniformLocation(name);
     if (location != -1) {
@@ -90,6 +102,13 @@ void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
     }
 }
 
+void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
+    GLint location = getUniformLocation(name);
+    if (location != -1) {
+        glUniform4fv(location, 1, &value[0]);
+    }
+}
+
 void Shader::setFloat(const std::string& name, float value) const {
     GLint location = getUniformLocation(name);
     if (location != -1) {
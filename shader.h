@@ -9,15 +9,29 @@
 #include <string>
 #include <unordered_map>
 
+/**
+ * @brief GLSL text of both stages of a shader program.
+ */
+struct ShaderSource {
+    std::string vertex;
+    std::string fragment;
+};
+
 class Shader {
 public:
     Shader(const char* vertexPath, const char* fragmentPath);
+    /**
+     * @brief Compiles already loaded sources, e.g. from the AssetManager.
+     */
+    explicit Shader(const ShaderSource& source);
     ~Shader();
     void use() const;
     GLuint getProgramID() const;
     bool isLoaded() const;
     void setMat4(const std::string& name, const glm::mat4& mat) const;
+    void setVec2(const std::string& name, const glm::vec2& value) const;
     void setVec3(const std::string& name, const glm::vec3& value) const;
+    void setVec4(const std::string& name, const glm::vec4& value) const;
     void setFloat(const std::string& name, float value) const;
     void setInt(const std::string& name, int value) const;
     std::string getErrorLog() const;
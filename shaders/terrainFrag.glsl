@@ -72,10 +72,74 @@ uniform float minHeight; // Minimum height of your terrain
 uniform float maxHeight;
 // Material properties
 uniform float shininess;
+// Textures with one texel per height sample; uv = FragPos.xz * gridScale + gridOffset
+uniform vec2 gridScale;
+uniform vec2 gridOffset;
+// Optional visibility tint (e.g. viewshed)
+uniform sampler2D visibilityMask;
+uniform int useVisibilityMask;
+// Baked sky visibility (horizon-based ambient occlusion)
+uniform sampler2D occlusionMap;
+uniform int useOcclusionMap;
+// Time-of-day sun shadows: horizon elevation per azimuth, 3 azimuths per layer plus the
+// next layer's first in alpha; sunWeights blends the two azimuths around the sun
+uniform sampler2DArray sunHorizonMap;
+uniform int useSunHorizon;
+uniform vec2 horizonScale;
+uniform vec2 horizonOffset;
+uniform float sunLayer;
+uniform vec4 sunWeights;
+uniform float sunElevation;
+// Slope / 90 degrees, aspect / 2 pi and curvature around 0.5 per sample
+uniform sampler2D analysisMap;
+uniform int useAnalysisMap;
+// Ground layer weights per sample (grass, rock, scree, snow) and the layer albedos
+uniform sampler2D splatMap;
+uniform sampler2DArray layerAlbedos;
+uniform int useSplatMap;
+// Draped imagery from a virtual texture: the indirection holds, per finest page, the
+// cache slot (r, g) and mip level (b) of the page to sample
+uniform sampler2D colorIndirection;
+uniform sampler2D colorPages;
+uniform int useColorMap;
+uniform vec2 colorWorldScale;
+uniform vec2 colorWorldOffset;
+uniform vec2 colorImageFraction;
+uniform vec2 colorVirtualPages;
+uniform float colorPageTexels;
+uniform float colorSlotTexels;
+uniform float colorBorder;
+uniform float colorCacheTexels;
+// River overlay from flow accumulation, brighter for larger rivers
+uniform sampler2D riverMap;
+uniform int useRiverMap;
+
+vec3 sampleColorMap(vec2 worldXZ) {
+    vec2 uv = clamp(worldXZ * colorWorldScale + colorWorldOffset, 0.0, 1.0) * colorImageFraction;
+    vec2 finest = uv * colorVirtualPages;
+    ivec2 page = min(ivec2(finest), ivec2(colorVirtualPages) - 1);
+    vec3 entry = floor(texelFetch(colorIndirection, page, 0).rgb * 255.0 + 0.5);
+    // A page of level n spans 2^n finest pages
+    float span = exp2(entry.b);
+    vec2 inPage = finest / span - floor(vec2(page) / span);
+    vec2 texel = entry.rg * colorSlotTexels + colorBorder + inPage * colorPageTexels;
+    return texture(colorPages, texel / colorCacheTexels).rgb;
+}
 
 void main() {
+    vec2 gridUV = FragPos.xz * gridScale + gridOffset;
     vec3 color;
-    if (FragPos.y < minHeight + 0.3 * (maxHeight - minHeight)) {
+    vec3 textureColor;
+    if (useSplatMap != 0) {
+        // Baked layer weights replace the height bands: one lookup, no branches
+        vec4 weights = texture(splatMap, gridUV);
+        textureColor = texture(layerAlbedos, vec3(TexCoords, 0.0)).rgb * weights.r +
+                       texture(layerAlbedos, vec3(TexCoords, 1.0)).rgb * weights.g +
+                       texture(layerAlbedos, vec3(TexCoords, 2.0)).rgb * weights.b +
+                       texture(layerAlbedos, vec3(TexCoords, 3.0)).rgb * weights.a;
+        color = vec3(1.0);
+    } else {
+        if (FragPos.y < minHeight + 0.3 * (maxHeight - minHeight)) {
             // Low elevations: dark green
             color = vec3(0.0, 0.6, 0.0);
         } else if (FragPos.y < minHeight + 0.6 * (maxHeight - minHeight)) {
@@ -91,8 +155,26 @@ void main() {
             vec3 highColor = vec3(0.8, 1.0, 0.8); // Very light green
             color = mix(midColor, highColor, factor);
         }
-    // Ambient lighting
-    vec3 ambient = vec3(0.3) * color;
+        textureColor = texture(terrainTexture, TexCoords).rgb;
+    }
+    if (useColorMap != 0) {
+        textureColor = sampleColorMap(FragPos.xz);
+        color = vec3(1.0);
+    }
+    if (useAnalysisMap != 0) {
+        vec4 analysis = texture(analysisMap, gridUV);
+        // Bare rock on steep slopes unless the splat map or imagery already shows it
+        if (useSplatMap == 0 && useColorMap == 0) {
+            float rock = smoothstep(35.0 / 90.0, 50.0 / 90.0, analysis.r);
+            color = mix(color, vec3(0.5, 0.47, 0.42), rock);
+        }
+        // A little darker in gullies
+        color *= mix(1.0, 0.9, smoothstep(0.5, 0.7, analysis.b));
+    }
+    float skyVisibility = useOcclusionMap != 0 ? texture(occlusionMap, gridUV).r : 1.0;
+
+    // Ambient lighting, darkened where the horizon hides the sky
+    vec3 ambient = vec3(0.3) * color * skyVisibility;
     // Lighting calculations
 
     // Diffuse lighting
@@ -101,7 +183,7 @@ void main() {
     vec3 norm = normalize(cross(dFdx(FragPos), dFdy(FragPos)));
     vec3 lightDir = normalize(lightPos - FragPos);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * vec3(0.7) * lightColor;
+    vec3 diffuse = diff * vec3(0.7) * lightColor * mix(0.6, 1.0, skyVisibility);
 
     // Specular lighting
     vec3 viewDir = normalize(viewPos - FragPos);
@@ -109,10 +191,28 @@ void main() {
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
     vec3 specular = spec *  lightColor;
 
-    // Texture color
-    vec3 textureColor = texture(terrainTexture, TexCoords).rgb;
+    // Sun hidden behind the horizon in its azimuth: only ambient light remains
+    if (useSunHorizon != 0) {
+        vec4 horizons = texture(sunHorizonMap, vec3(FragPos.xz * horizonScale + horizonOffset, sunLayer));
+        float horizon = dot(horizons, sunWeights) * 1.5707963;
+        float sunVisibility = smoothstep(-0.02, 0.02, sunElevation - horizon);
+        diffuse *= sunVisibility;
+        specular *= sunVisibility;
+    }
 
     // Combine results
     vec3 result = (ambient + diffuse + specular) * textureColor;
+
+    // Water over the river channels
+    if (useRiverMap != 0) {
+        float river = texture(riverMap, gridUV).r;
+        result = mix(result, vec3(0.12, 0.3, 0.6) * (0.5 + 0.5 * diff), smoothstep(0.1, 0.5, river));
+    }
+
+    // Darken and cool what the hiker cannot see
+    if (useVisibilityMask != 0) {
+        float visible = texture(visibilityMask, gridUV).r;
+        result = mix(result * vec3(0.45, 0.5, 0.7), result, visible);
+    }
     FragColor = vec4(result, 1.0);
 }
@@ -0,0 +1,78 @@
+#include "splatMap.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+inline float smoothStep(float edge0, float edge1, float x) {
+    float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+}
+
+SplatMap::SplatMap() : width(0), height(0) {}
+
+void SplatMap::setSettings(const SplatSettings& newSettings) {
+    settings = newSettings;
+    settings.blend = std::max(settings.blend, 0.1f);
+}
+
+void SplatMap::bake(const TerrainAnalysis& analysis, const std::vector<float>& heights, float minHeight, float maxHeight) {
+    width = analysis.getWidth();
+    height = analysis.getHeight();
+    texels.assign(static_cast<size_t>(width) * height * 4, 0);
+    if (!analysis.isBuilt() || heights.size() < static_cast<size_t>(width) * height) {
+        width = height = 0;
+        texels.clear();
+        return;
+    }
+    float inverseRange = maxHeight > minHeight ? 1.0f / (maxHeight - minHeight) : 0.0f;
+    const float halfBlend = settings.blend * 0.5f;
+    const float snowBlend = 0.03f;
+
+    ThreadPool::getInstance().parallelFor(0, height, [&](int z) {
+        for (int x = 0; x < width; ++x) {
+            size_t sample = static_cast<size_t>(z) * width + x;
+            float slope = analysis.getSlope(x, z);
+            float altitude = (heights[sample] - minHeight) * inverseRange;
+
+            // Each layer takes its share of what the layers before it left
+            float rock = smoothStep(settings.rockSlope - halfBlend, settings.rockSlope + halfBlend, slope);
+            float snow = smoothStep(settings.snowAltitude - snowBlend, settings.snowAltitude + snowBlend, altitude) *
+                         (1.0f - smoothStep(settings.snowSlope - halfBlend, settings.snowSlope + halfBlend, slope));
+            float scree = smoothStep(settings.screeSlope - halfBlend, settings.screeSlope + halfBlend, slope) *
+                          smoothStep(settings.screeAltitude - snowBlend, settings.screeAltitude + snowBlend, altitude);
+            float rest = 1.0f - rock;
+            float snowWeight = rest * snow;
+            rest -= snowWeight;
+            float screeWeight = rest * scree;
+            rest -= screeWeight;
+
+            // Rounding the running totals keeps the sum at exactly 255
+            long rockTotal = std::lround(rock * 255.0f);
+            long screeTotal = std::lround((rock + screeWeight) * 255.0f);
+            long snowTotal = std::lround((1.0f - rest) * 255.0f);
+            unsigned char* texel = &texels[sample * 4];
+            texel[0] = static_cast<unsigned char>(255 - snowTotal);
+            texel[1] = static_cast<unsigned char>(rockTotal);
+            texel[2] = static_cast<unsigned char>(screeTotal - rockTotal);
+            texel[3] = static_cast<unsigned char>(snowTotal - screeTotal);
+        }
+    });
+}
+
+bool SplatMap::isBaked() const {
+    return width > 0;
+}
+
+int SplatMap::getWidth() const {
+    return width;
+}
+
+int SplatMap::getHeight() const {
+    return height;
+}
+
+const std::vector<unsigned char>& SplatMap::getTexels() const {
+    return texels;
+}
@@ -0,0 +1,59 @@
+#ifndef SPLAT_MAP_H
+#define SPLAT_MAP_H
+
+#include <vector>
+#include "terrainAnalysis.h"
+
+/**
+ * @brief Where each ground layer appears. Altitudes are fractions of the height range.
+ */
+struct SplatSettings {
+    float rockSlope = 38.0f;       ///< Slope in degrees where rock takes over.
+    float screeSlope = 24.0f;      ///< Slope in degrees where scree starts.
+    float screeAltitude = 0.45f;   ///< Scree only lies above this altitude.
+    float snowAltitude = 0.8f;     ///< Snow line.
+    float snowSlope = 45.0f;       ///< Snow slides off slopes steeper than this.
+    float blend = 6.0f;            ///< Width of the slope transitions in degrees.
+};
+
+/**
+ * @class SplatMap
+ * @brief Per-sample weights of the grass, rock, scree and snow layers.
+ *
+ * Baked once from the slope grid and the heights into RGBA8 texels (r grass, g rock,
+ * b scree, a snow) that always sum to 255, so the terrain shader blends the layer
+ * albedos with one texture lookup instead of branching on height per fragment. Rock
+ * claims steep ground first, snow then takes its share of the rest above the snow
+ * line, scree of what remains, and grass covers the remainder.
+ */
+class SplatMap {
+public:
+    SplatMap();
+
+    void setSettings(const SplatSettings& settings);
+
+    /**
+     * @brief Bakes the weights, rows in parallel.
+     * @param analysis Slope grid of the heights.
+     * @param heights Row-major heights, same layout as the analysis.
+     * @param minHeight Lowest height of the grid.
+     * @param maxHeight Highest height of the grid.
+     */
+    void bake(const TerrainAnalysis& analysis, const std::vector<float>& heights, float minHeight, float maxHeight);
+
+    bool isBaked() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * @brief RGBA8 weights, one texel per sample, row-major.
+     */
+    const std::vector<unsigned char>& getTexels() const;
+
+private:
+    SplatSettings settings;
+    int width, height;
+    std::vector<unsigned char> texels;
+};
+
+#endif // SPLAT_MAP_H
@@ -0,0 +1,106 @@
+#include "sunHorizon.h"
+#include "horizonAO.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+SunHorizonMap::SunHorizonMap()
+    : layers(4),             // 12 azimuths, 30 degrees apart
+    radius(128),           // Long shadows at a low sun
+    maxResolution(2048),
+    textureWidth(0), textureHeight(0),
+    stride(1) {}
+
+void SunHorizonMap::setLayers(int count) {
+    layers = std::max(1, count);
+}
+
+void SunHorizonMap::setRadius(int samples) {
+    radius = std::max(1, samples);
+}
+
+void SunHorizonMap::setMaxResolution(int texels) {
+    maxResolution = std::max(2, texels);
+}
+
+void SunHorizonMap::bake(const std::vector<float>& heights, int width, int height, float horizontalScale) {
+    texels.clear();
+    textureWidth = textureHeight = 0;
+    if (width < 2 || height < 2 || heights.size() < static_cast<size_t>(width) * height) return;
+    stride = (std::max(width, height) + maxResolution - 1) / maxResolution;
+    textureWidth = (width - 1) / stride + 1;
+    textureHeight = (height - 1) / stride + 1;
+
+    int azimuths = layers * 3;
+    std::vector<std::vector<HorizonStep>> steps = buildHorizonSteps(azimuths, radius, horizontalScale);
+
+    int paddedWidth = width + 2 * radius;
+    std::vector<float> padded = padHeightGrid(heights, width, height, radius);
+    size_t layerSize = static_cast<size_t>(textureWidth) * textureHeight * 4;
+    texels.resize(layerSize * layers);
+    float toByte = 255.0f / (0.5f * static_cast<float>(M_PI));
+
+    ThreadPool::getInstance().parallelFor(0, textureHeight, [&](int v) {
+        std::vector<float> horizon(textureWidth);
+        const float* center = &padded[static_cast<size_t>(v * stride + radius) * paddedWidth + radius];
+        for (int k = 0; k < azimuths; ++k) {
+            std::fill(horizon.begin(), horizon.end(), 0.0f);
+            for (const HorizonStep& step : steps[k]) {
+                const float* shifted = center + static_cast<ptrdiff_t>(step.dz) * paddedWidth + step.dx;
+                float inverseDistance = step.inverseDistance;
+                float* h = horizon.data();
+                for (int u = 0; u < textureWidth; ++u) {
+                    float slope = (shifted[u * stride] - center[u * stride]) * inverseDistance;
+                    h[u] = slope > h[u] ? slope : h[u];
+                }
+            }
+            // Azimuth k is channel k % 3 of layer k / 3, and channel 3 of the layer before
+            auto store = [&](int layer, int channel) {
+                unsigned char* out = &texels[layer * layerSize + static_cast<size_t>(v) * textureWidth * 4 + channel];
+                for (int u = 0; u < textureWidth; ++u) {
+                    out[u * 4] = static_cast<unsigned char>(std::atan(horizon[u]) * toByte + 0.5f);
+                }
+            };
+            store(k / 3, k % 3);
+            if (k % 3 == 0) {
+                store((k / 3 + layers - 1) % layers, 3);
+            }
+        }
+    });
+}
+
+void SunHorizonMap::lookup(float azimuth, int& layer, glm::vec4& weights) const {
+    int azimuths = layers * 3;
+    float position = azimuth / (2.0f * static_cast<float>(M_PI)) * azimuths;
+    position -= std::floor(position / azimuths) * azimuths;
+    int k = std::min(static_cast<int>(position), azimuths - 1);
+    float blend = position - k;
+    layer = k / 3;
+    weights = glm::vec4(0.0f);
+    weights[k % 3] = 1.0f - blend;
+    weights[k % 3 + 1] = blend;
+}
+
+const std::vector<unsigned char>& SunHorizonMap::getTexels() const {
+    return texels;
+}
+
+int SunHorizonMap::getTextureWidth() const {
+    return textureWidth;
+}
+
+int SunHorizonMap::getTextureHeight() const {
+    return textureHeight;
+}
+
+int SunHorizonMap::getLayers() const {
+    return layers;
+}
+
+int SunHorizonMap::getStride() const {
+    return stride;
+}
+
+bool SunHorizonMap::isBaked() const {
+    return !texels.empty();
+}
@@ -0,0 +1,75 @@
+#ifndef SUN_HORIZON_H
+#define SUN_HORIZON_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * @class SunHorizonMap
+ * @brief Precomputed horizon elevation per texel for a ring of sun azimuths.
+ *
+ * A sample is in shadow exactly when the sun is lower than the horizon in the sun's
+ * azimuth, so with the horizons stored, self-shadowing for any sun position is one
+ * texture fetch and a compare. Each RGBA8 layer holds three azimuths in RGB, and its
+ * alpha repeats the first azimuth of the next layer, so the two azimuths bracketing
+ * any sun direction always share a layer.
+ */
+class SunHorizonMap {
+public:
+    SunHorizonMap();
+
+    /**
+     * @brief Sets the number of RGBA layers; the map stores 3 azimuths per layer.
+     */
+    void setLayers(int count);
+
+    /**
+     * @brief Sets how far horizons are searched.
+     * @param samples Search radius in height samples.
+     */
+    void setRadius(int samples);
+
+    /**
+     * @brief Limits the texture size; larger grids are baked at every n-th sample.
+     * @param texels Largest texture side.
+     */
+    void setMaxResolution(int texels);
+
+    /**
+     * @brief Computes the horizons on the thread pool.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void bake(const std::vector<float>& heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Layer and channel weights that interpolate the horizon at an azimuth.
+     * @param azimuth Angle in the x/z plane, from +x toward +z, in radians.
+     * @param layer Receives the texture layer.
+     * @param weights Receives the weights to dot with the fetched RGBA.
+     */
+    void lookup(float azimuth, int& layer, glm::vec4& weights) const;
+
+    /**
+     * @brief Layer-major RGBA8 texels; each channel is a horizon elevation, 0 to 90 degrees.
+     */
+    const std::vector<unsigned char>& getTexels() const;
+
+    int getTextureWidth() const;
+    int getTextureHeight() const;
+    int getLayers() const;
+    int getStride() const;          ///< Height samples per texel.
+    bool isBaked() const;
+
+private:
+    int layers;
+    int radius;
+    int maxResolution;
+    int textureWidth, textureHeight;
+    int stride;
+    std::vector<unsigned char> texels;
+};
+
+#endif // SUN_HORIZON_H
@@ -10,19 +10,136 @@
 #include <cstdlib> // For rand()
 #include <ctime>   // For time()
 #include <cmath>   // For sqrt()
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include "threadPool.h"
+#include "demLoader.h"
+#include "textureCompression.h"
+#include "assetManager.h"
+#include "hydraulicErosion.h"
+#include "bakeCache.h"
+#include "frustum.h"
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace {
+// Size of the staging buffer used to stream terrain data to the GPU
+const size_t kStagingBufferSize = 4 * 1024 * 1024;
+// Highest sun elevation of the day (radians) and distance of the sun light
+const float kMaxSunElevation = glm::radians(60.0f);
+const float kSunDistance = 100000.0f;
+// Ground layers in the splat map and the side of each layer in the albedo array
+const int kLayerCount = 4;
+const int kLayerSize = 256;
+
+/**
+ * @brief Bilinearly resamples an image to size x size RGBA texels, wrapping at the
+ *        edges so tiling images stay seamless.
+ */
+void resampleLayer(const unsigned char* data, int imageWidth, int imageHeight, int channels,
+                   int size, unsigned char* texels) {
+    for (int y = 0; y < size; ++y) {
+        float sy = (y + 0.5f) * imageHeight / size - 0.5f;
+        int y0 = static_cast<int>(std::floor(sy));
+        float fy = sy - y0;
+        int row0 = (y0 % imageHeight + imageHeight) % imageHeight;
+        int row1 = (row0 + 1) % imageHeight;
+        for (int x = 0; x < size; ++x) {
+            float sx = (x + 0.5f) * imageWidth / size - 0.5f;
+            int x0 = static_cast<int>(std::floor(sx));
+            float fx = sx - x0;
+            int col0 = (x0 % imageWidth + imageWidth) % imageWidth;
+            int col1 = (col0 + 1) % imageWidth;
+            const unsigned char* p00 = data + (static_cast<size_t>(row0) * imageWidth + col0) * channels;
+            const unsigned char* p10 = data + (static_cast<size_t>(row0) * imageWidth + col1) * channels;
+            const unsigned char* p01 = data + (static_cast<size_t>(row1) * imageWidth + col0) * channels;
+            const unsigned char* p11 = data + (static_cast<size_t>(row1) * imageWidth + col1) * channels;
+            unsigned char* texel = texels + (static_cast<size_t>(y) * size + x) * 4;
+            texel[3] = 255;
+            for (int c = 0; c < 4; ++c) {
+                // Grey images fill RGB from their first channel; alpha is the last channel if any
+                bool hasAlpha = channels == 2 || channels == 4;
+                int source = c < 3 ? (channels < 3 ? 0 : c) : channels - 1;
+                if (c == 3 && !hasAlpha) continue;
+                float top = p00[source] + fx * (p10[source] - p00[source]);
+                float bottom = p01[source] + fx * (p11[source] - p01[source]);
+                texel[c] = static_cast<unsigned char>(top + fy * (bottom - top) + 0.5f);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Stands in for a missing layer: scree is a lighter, warmer copy of the rock
+ *        albedo and snow keeps only a trace of its detail.
+ */
+void tintLayer(const unsigned char* source, size_t texelCount, int layer, unsigned char* texels) {
+    const glm::vec3 screeTint(1.25f, 1.2f, 1.1f);
+    const glm::vec3 snowColor(240.0f, 245.0f, 255.0f);
+    for (size_t i = 0; i < texelCount; ++i) {
+        glm::vec3 color(source[i * 4], source[i * 4 + 1], source[i * 4 + 2]);
+        if (layer == 2) {
+            color = color * screeTint;
+        } else {
+            float luminance = glm::dot(color, glm::vec3(0.299f, 0.587f, 0.114f));
+            color = snowColor * (0.85f + 0.15f * luminance / 255.0f);
+        }
+        color = glm::clamp(color, glm::vec3(0.0f), glm::vec3(255.0f));
+        texels[i * 4] = static_cast<unsigned char>(color.x);
+        texels[i * 4 + 1] = static_cast<unsigned char>(color.y);
+        texels[i * 4 + 2] = static_cast<unsigned char>(color.z);
+        texels[i * 4 + 3] = source[i * 4 + 3];
+    }
+}
+
+/// Brightens and adds contrast to simulate daylight.
+void configureDaylight(ImagePipeline& pipeline) {
+    pipeline.setBrightness(1.2f);
+    pipeline.setContrast(1.1f);
+}
+}
 
 // Constructor
 Terrain::Terrain()
-    :terrainShader(nullptr),
+    :waterVAO(0), waterVBO(0), waterEBO(0),
+    waterHeight(10.0f),    // Sea level; depressions above it are filled as lakes
     terrainVAO(0), terrainVBO(0), terrainEBO(0),
+    terrainShader(nullptr),
+    textureID(0),
+    visibilityTexture(0),
+    riverTexture(0),
+    colorMap(nullptr),
+    occlusionTexture(0),
+    analysisTexture(0),
+    splatTexture(0),
+    layerTexture(0),
+    sunHorizonTexture(0),
+    timeOfDay(-1.0f),
     width(0), height(0),
+    heightScale(800.0f),   // Decrease heightScale for better proportion
+    horizontalScale(1.0f),
+    surveyHeightScale(1.0f),
     minHeight(0.0f), maxHeight(0.0f),
-    textureID(0) ,
     textureRepeat(10.0f),
-    heightScale(800.0f),   // Decrease heightScale for better proportion
-    horizontalScale(1.0f){
+    use16BitIndices(false),
+    topology(TerrainTopology::TRIANGLES),
+    gridUse16BitIndices(false),
+    gridTopology(TerrainTopology::TRIANGLES),
+    chunkSize(128),        // 129 x 129 vertices per chunk fit 16-bit indices
+    vertexCacheSize(32),
+    erosionDroplets(0),
+    waterBuffersDirty(false),
+    visibleWaterPlanes(0),
+    proceduralSize(0),
+    terrainVertexCount(0),
+    adaptiveMaxError(-1.0f),
+    loadState(TerrainLoadState::EMPTY),
+    stagingBuffer(0),
+    uploadedBytes(0){
 //        setupWaterPlane();
+        configureDaylight(texturePipeline);
     }
 
 Terrain::~Terrain() {
@@ -30,15 +147,86 @@ Terrain::~Terrain() {
 }
 void Terrain::setShader(Shader* shader) {
     terrainShader = shader;
+    if (terrainShader == nullptr || !terrainShader->isLoaded()) {
+        return;
+    }
+    // Every sampler keeps its own unit; render only binds textures and sets the use* flags
+    terrainShader->use();
+    terrainShader->setInt("terrainTexture", 0);
+    terrainShader->setInt("visibilityMask", 1);
+    terrainShader->setInt("occlusionMap", 2);
+    terrainShader->setInt("sunHorizonMap", 3);
+    terrainShader->setInt("riverMap", 4);
+    terrainShader->setInt("analysisMap", 5);
+    terrainShader->setInt("layerAlbedos", 6);
+    terrainShader->setInt("splatMap", 7);
+}
+
+void Terrain::resetShaderFeatures(Shader& shader) {
+    shader.setInt("useVisibilityMask", 0);
+    shader.setInt("useOcclusionMap", 0);
+    shader.setInt("useSunHorizon", 0);
+    shader.setInt("useRiverMap", 0);
+    shader.setInt("useAnalysisMap", 0);
+    shader.setInt("useSplatMap", 0);
+    shader.setInt("useColorMap", 0);
 }
 
 Shader* Terrain::getShader() const {
     return terrainShader;
 }
 
+GLuint Terrain::getTextureID() const {
+    return textureID;
+}
+
+const std::vector<float>& Terrain::getHeights() const {
+    return heights;
+}
+
+glm::vec2 Terrain::getSampleCoordinates(float x, float z) const {
+    float halfWidth = (width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (height - 1) * horizontalScale * 0.5f;
+    return glm::vec2((x + halfWidth) / horizontalScale, (z + halfDepth) / horizontalScale);
+}
+
+void Terrain::setVisibilityMask(GLuint texture) {
+    visibilityTexture = texture;
+}
+
+void Terrain::setRiverOverlay(GLuint texture) {
+    riverTexture = texture;
+}
+
+void Terrain::setColorMap(const VirtualTexture* map) {
+    colorMap = map;
+}
+
+void Terrain::setTimeOfDay(float hours) {
+    timeOfDay = hours < 0.0f ? -1.0f : std::fmod(hours, 24.0f);
+}
+
+float Terrain::getTimeOfDay() const {
+    return timeOfDay;
+}
+
+void Terrain::getSunAngles(float& azimuth, float& elevation) const {
+    // 0 at sunrise (6:00), pi at sunset (18:00); below the horizon at night
+    float angle = (timeOfDay - 6.0f) / 12.0f * glm::pi<float>();
+    azimuth = angle;
+    elevation = kMaxSunElevation * std::sin(angle);
+}
+
+glm::vec3 Terrain::getSunDirection() const {
+    float azimuth, elevation;
+    getSunAngles(azimuth, elevation);
+    return glm::vec3(std::cos(elevation) * std::cos(azimuth), std::sin(elevation),
+                     std::cos(elevation) * std::sin(azimuth));
+}
+
 
 float Terrain::RandomFloatRange(float min, float max) {
-    return min + static_cast<float>(rand()) / (static_cast<float>(RAND_MAX / (max - min)));
+    return std::uniform_real_distribution<float>(min, max)(noiseGenerator);
 }
 void Terrain::diamondStep(int stepSize, float scale) {
     int halfStep = stepSize / 2;
@@ -97,13 +285,64 @@ void Terrain::squareStep(int stepSize, float scale) {
 
 
 bool Terrain::loadTerrainData(const std::string& heightmapFile) {
-    // Load heightmap image
+    loadState = TerrainLoadState::BUILDING;
+    if (!buildTerrainData(heightmapFile, timeOfDay >= 0.0f)) {
+        loadState = TerrainLoadState::FAILED;
+        return false;
+    }
+    setupTerrainVAO();
+    loadState = TerrainLoadState::READY;
+    return true;
+}
+
+void Terrain::loadTerrainDataAsync(const std::string& heightmapFile) {
+    if (pendingBuild.valid()) {
+        pendingBuild.wait();
+    }
+    loadState = TerrainLoadState::BUILDING;
+    bool withSunHorizon = timeOfDay >= 0.0f;
+    pendingBuild = ThreadPool::getInstance().submit([this, heightmapFile, withSunHorizon]() {
+        return buildTerrainData(heightmapFile, withSunHorizon);
+    });
+}
+
+bool Terrain::updateAsyncLoad(size_t maxUploadBytes) {
+    if (loadState == TerrainLoadState::BUILDING && pendingBuild.valid() &&
+        pendingBuild.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        if (!pendingBuild.get()) {
+            loadState = TerrainLoadState::FAILED;
+            return false;
+        }
+        createTerrainBuffers(true);
+        loadState = TerrainLoadState::UPLOADING;
+    }
+    if (loadState == TerrainLoadState::UPLOADING && uploadTerrainSlice(maxUploadBytes)) {
+        releaseMeshData();
+        loadState = TerrainLoadState::READY;
+        std::cout << "INFO: Terrain streamed to the GPU." << std::endl;
+    }
+    return loadState == TerrainLoadState::READY;
+}
+
+TerrainLoadState Terrain::getLoadState() const {
+    return loadState;
+}
+
+bool Terrain::hasHeightData() const {
+    return loadState == TerrainLoadState::UPLOADING || loadState == TerrainLoadState::READY;
+}
+
+bool Terrain::loadImageHeights(const std::string& heightmapFile) {
+    // Load heightmap image, decoded straight from the archive mapping when packed
     int nrComponents;
-    unsigned char* data = stbi_load(heightmapFile.c_str(), &width, &height, &nrComponents, 1);
+    AssetData encoded = AssetManager::getInstance().readFile(heightmapFile);
+    unsigned char* data = !encoded ? nullptr
+        : stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size), &width, &height, &nrComponents, 1);
     if (!data) {
         std::cerr << "ERROR::TERRAIN::FAILED_TO_LOAD_HEIGHTMAP: " << heightmapFile << std::endl;
         return false;
     }
+    noiseGenerator.seed(static_cast<std::mt19937::result_type>(hashBakeBytes(encoded.data, encoded.size, {})));
     if (width <= 0 || height <= 0) {
            std::cerr << "ERROR: Invalid heightmap dimensions (width: " << width
                << ", height: " << height << ")" << std::endl;
@@ -164,6 +403,101 @@ bool Terrain::loadTerrainData(const std::string& heightmapFile) {
             scale *= pow(1.5f, -roughness);
         }
 //    }
+    return true;
+}
+
+bool Terrain::loadDEMHeights(const std::string& demFile) {
+    DEMFile dem;
+    if (!dem.open(demFile)) {
+        std::cerr << "ERROR::TERRAIN::FAILED_TO_LOAD_DEM: " << demFile << std::endl;
+        return false;
+    }
+    width = dem.getWidth();
+    height = dem.getHeight();
+    heightScale = 105.0f;
+    horizontalScale = 1.0f;
+
+    // Heights are decoded straight from the mapping into the height grid
+    float low, high;
+    dem.adviseAccess(true);
+    dem.computeRange(low, high);
+    heights.resize(static_cast<size_t>(width) * height);
+    dem.readWindow(0, 0, width, height, heights.data());
+
+    // Same 0..heightScale range as 8-bit heightmaps, but at full precision and
+    // without the synthetic noise, since survey data is already detailed
+    float range = high > low ? high - low : 1.0f;
+    for (float& heightValue : heights) {
+        heightValue = (heightValue - low) / range * heightScale;
+    }
+    minHeight = 0.0f;
+    maxHeight = high > low ? heightScale : 0.0f;
+    // Metres per height unit against metres per horizontal unit, so slopes stay true
+    float spacing = dem.getSampleSpacing();
+    if (spacing > 0.0f) {
+        surveyHeightScale = (range / heightScale) / (spacing / horizontalScale);
+    }
+
+    std::cout << "INFO: Loaded DEM " << demFile << " (" << width << " x " << height
+              << ", " << low << " to " << high;
+    if (spacing > 0.0f) {
+        std::cout << ", " << spacing << " m apart";
+    }
+    std::cout << ")" << std::endl;
+    return true;
+}
+
+bool Terrain::loadProceduralHeights() {
+    width = height = proceduralSize;
+    heightScale = procedural.getSettings().heightScale;
+    horizontalScale = 1.0f;
+
+    auto start = std::chrono::steady_clock::now();
+    procedural.generate(heights, width, height);
+    double generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    auto range = std::minmax_element(heights.begin(), heights.end());
+    minHeight = *range.first;
+    maxHeight = *range.second;
+    std::cout << "INFO: Generated procedural terrain " << width << " x " << height << " (seed "
+              << procedural.getSettings().seed << ") in " << generateMs << " ms" << std::endl;
+    return true;
+}
+
+std::string Terrain::bakeCachePath(const std::string& heightmapFile, const std::string& extension) const {
+    if (proceduralSize <= 0) {
+        return heightmapFile + extension;
+    }
+    size_t slash = heightmapFile.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? std::string() : heightmapFile.substr(0, slash + 1);
+    return directory + "procedural-" + std::to_string(procedural.getSettings().seed) + "-"
+         + std::to_string(proceduralSize) + extension;
+}
+
+bool Terrain::buildTerrainData(const std::string& heightmapFile, bool withSunHorizon) {
+    surveyHeightScale = 1.0f;
+    bool loaded = proceduralSize > 0 ? loadProceduralHeights()
+                : DEMFile::isDEMFile(heightmapFile) ? loadDEMHeights(heightmapFile)
+                : loadImageHeights(heightmapFile);
+    if (!loaded) {
+        return false;
+    }
+    if (erosionDroplets > 0) {
+        // Optional erosion stage, cached because it is the slowest part of the bake
+        ErosionSettings settings;
+        settings.droplets = erosionDroplets;
+        HydraulicErosion erosion;
+        erosion.setSettings(settings);
+        auto erosionStart = std::chrono::steady_clock::now();
+        bool cached = erosion.erodeCached(bakeCachePath(heightmapFile, ".eroded"), heights, width, height);
+        double erosionMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - erosionStart).count();
+        std::cout << "INFO: Erosion (" << erosionDroplets << " droplets) " << (cached ? "loaded from cache" : "simulated")
+                  << " in " << erosionMs << " ms" << std::endl;
+
+        auto range = std::minmax_element(heights.begin(), heights.end());
+        minHeight = *range.first;
+        maxHeight = *range.second;
+    }
     // Generate positions and normals
     positions.resize(width * height);
     normals.resize(width * height);
@@ -190,46 +524,118 @@ bool Terrain::loadTerrainData(const std::string& heightmapFile) {
     }
 
     calculateNormals();
-    setupTerrainVAO();
+    heightPyramid.build(heights, width, height);
+
+    // Sky visibility is cached next to the heightmap and rebaked when the heights change
+    auto bakeStart = std::chrono::steady_clock::now();
+    bool cached = horizonAO.bakeCached(bakeCachePath(heightmapFile, ".ao"), heights, width, height, horizontalScale);
+    double bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+    std::cout << "INFO: Horizon AO " << (cached ? "loaded from cache" : "baked") << " in " << bakeMs << " ms" << std::endl;
+
+    // Slope, aspect and curvature once, for shading and for every gameplay consumer
+    bakeStart = std::chrono::steady_clock::now();
+    analysis.build(heights, width, height, horizontalScale, surveyHeightScale);
+    bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+    std::cout << "INFO: Slope, aspect and curvature computed in " << bakeMs << " ms" << std::endl;
+
+    // Ground layer weights, so the shader blends albedos without height branches
+    bakeStart = std::chrono::steady_clock::now();
+    splatMap.bake(analysis, heights, minHeight, maxHeight);
+    bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+    std::cout << "INFO: Splat map baked in " << bakeMs << " ms" << std::endl;
+
+    // Horizons per sun azimuth, so time-of-day shadows need no shadow-map passes
+    if (withSunHorizon) {
+        bakeStart = std::chrono::steady_clock::now();
+        sunHorizon.bake(heights, width, height, horizontalScale);
+        bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+        std::cout << "INFO: Sun horizon map " << sunHorizon.getTextureWidth() << " x " << sunHorizon.getTextureHeight()
+                  << " x " << sunHorizon.getLayers() * 3 << " azimuths baked in " << bakeMs << " ms" << std::endl;
+    }
+
+    // Water only where the ground is below the sea level or inside a depression
+    bakeStart = std::chrono::steady_clock::now();
+    lakeDetector.setSeaLevel(waterHeight);
+    lakeDetector.detect(heights, width, height, horizontalScale);
+    bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - bakeStart).count();
+    std::cout << "INFO: Found " << lakeDetector.getLakes().size() << " lakes ("
+              << lakeDetector.getIndices().size() / 3 << " water triangles) in " << bakeMs << " ms" << std::endl;
+
+    if (adaptiveMaxError >= 0.0f) {
+        rtin.build(heights, width, height);
+    }
+    buildMeshData();
 
     return true;
 }
+
 void Terrain::setupTerrainVAO() {
-    // Generate indices
-    indices.clear();
-    for (int z = 0; z < height - 1; ++z) {
-        for (int x = 0; x < width - 1; ++x) {
-            int i0 = z * width + x;
-            int i1 = z * width + x + 1;
-            int i2 = (z + 1) * width + x;
-            int i3 = (z + 1) * width + x + 1;
+    createTerrainBuffers(false);
+    releaseMeshData();
+    std::cout << "INFO: Terrain VAO, VBO, and EBO setup complete." << std::endl;
+}
 
-            // First triangle
-            indices.push_back(i0);
-            indices.push_back(i1);
-            indices.push_back(i2);
+void Terrain::buildMeshData() {
+    // Create vertex data
+    vertexData.clear();
+    use16BitIndices = gridUse16BitIndices;
+    topology = gridTopology;
+    if (adaptiveMaxError >= 0.0f && (use16BitIndices || topology != TerrainTopology::TRIANGLES)) {
+        std::cout << "INFO: Adaptive terrain mesh uses 32-bit triangle lists." << std::endl;
+        use16BitIndices = false;
+        topology = TerrainTopology::TRIANGLES;
+    }
 
-            // Second triangle
-            indices.push_back(i1);
-            indices.push_back(i3);
-            indices.push_back(i2);
+    indices.clear();
+    chunkIndices.clear();
+    chunks.clear();
+    if (use16BitIndices) {
+        // Every chunk owns a copy of its vertices (shared edges are duplicated)
+        // so its local indices fit in 16 bits.
+        int bandWidth = vertexCacheSize > 0 ? vertexCacheBandWidth(vertexCacheSize) : 0;
+        appendGridChunks(width, height, chunkSize, bandWidth, topology, chunkIndices, chunks);
+        for (const TerrainChunk& chunk : chunks) {
+            for (int z = chunk.firstRow; z < chunk.firstRow + chunk.rows; ++z) {
+                for (int x = chunk.firstColumn; x < chunk.firstColumn + chunk.columns; ++x) {
+                    int i = z * width + x;
+                    vertexData.push_back({ positions[i], normals[i], texCoords[i] });
+                }
+            }
+        }
+    } else {
+        vertexData.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            vertexData[i].Position = positions[i];
+            vertexData[i].Normal = normals[i];
+            vertexData[i].TexCoords = texCoords[i];
+        }
+        if (adaptiveMaxError >= 0.0f) {
+            rtin.extract(adaptiveMaxError, indices);
+        } else {
+            appendTerrainIndices(width, height, restartIndex(), indices);
         }
     }
+    terrainVertexCount = static_cast<GLsizei>(vertexData.size());
+}
 
-    // Create vertex data
-    struct Vertex {
-        glm::vec3 Position;
-        glm::vec3 Normal;
-        glm::vec2 TexCoords;
-    };
-    std::vector<Vertex> vertexData(positions.size());
-    for (size_t i = 0; i < positions.size(); ++i) {
-        vertexData[i].Position = positions[i];
-        vertexData[i].Normal = normals[i];
-        vertexData[i].TexCoords = texCoords[i];
-    }
+void Terrain::reuploadMeshData() {
+    const void* indexSource = use16BitIndices ? static_cast<const void*>(chunkIndices.data())
+                                              : static_cast<const void*>(indices.data());
+    // The attribute pointers refer to the buffer objects, so only their storage is replaced
+    glBindVertexArray(terrainVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, terrainVBO);
+    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(TerrainVertex), vertexData.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize(), indexSource, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Terrain::createTerrainBuffers(bool streamed) {
+    const void* indexSource = use16BitIndices ? static_cast<const void*>(chunkIndices.data())
+                                              : static_cast<const void*>(indices.data());
 
-    // OpenGL buffer setup (VAO, VBO, EBO)
+    // OpenGL buffer setup (VAO, VBO, EBO); streamed buffers are filled by uploadTerrainSlice
     glGenVertexArrays(1, &terrainVAO);
     glGenBuffers(1, &terrainVBO);
     glGenBuffers(1, &terrainEBO);
@@ -237,25 +643,149 @@ void Terrain::setupTerrainVAO() {
     glBindVertexArray(terrainVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, terrainVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(Vertex), vertexData.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(TerrainVertex),
+                 streamed ? nullptr : vertexData.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize(), streamed ? nullptr : indexSource, GL_STATIC_DRAW);
 
     // Vertex attribute pointers
     // Position attribute
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)0);
     // Normal attribute
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, Normal));
     // Texture coordinate attribute
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, TexCoords));
 
     glBindVertexArray(0);
 
-    std::cout << "INFO: Terrain VAO, VBO, and EBO setup complete." << std::endl;
+    if (streamed) {
+        // Staging buffer the slices are written to before being copied on the GPU
+        glGenBuffers(1, &stagingBuffer);
+        glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+        glBufferData(GL_COPY_READ_BUFFER, kStagingBufferSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        uploadedBytes = 0;
+    }
+    createLightingTextures();
+}
+
+void Terrain::createLightingTextures() {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (horizonAO.isBaked()) {
+        glGenTextures(1, &occlusionTexture);
+        glBindTexture(GL_TEXTURE_2D, occlusionTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, horizonAO.getWidth(), horizonAO.getHeight(), 0,
+                     GL_RED, GL_UNSIGNED_BYTE, horizonAO.getValues().data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (analysis.isBuilt()) {
+        std::vector<unsigned char> texels = analysis.packTexels();
+        glGenTextures(1, &analysisTexture);
+        glBindTexture(GL_TEXTURE_2D, analysisTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, analysis.getWidth(), analysis.getHeight(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (splatMap.isBaked()) {
+        glGenTextures(1, &splatTexture);
+        glBindTexture(GL_TEXTURE_2D, splatTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, splatMap.getWidth(), splatMap.getHeight(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, splatMap.getTexels().data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    if (sunHorizon.isBaked()) {
+        glGenTextures(1, &sunHorizonTexture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, sunHorizonTexture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, sunHorizon.getTextureWidth(), sunHorizon.getTextureHeight(),
+                     sunHorizon.getLayers(), 0, GL_RGBA, GL_UNSIGNED_BYTE, sunHorizon.getTexels().data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool Terrain::uploadTerrainSlice(size_t maxBytes) {
+    const unsigned char* vertexBytes = reinterpret_cast<const unsigned char*>(vertexData.data());
+    const unsigned char* indexBytes = use16BitIndices
+        ? reinterpret_cast<const unsigned char*>(chunkIndices.data())
+        : reinterpret_cast<const unsigned char*>(indices.data());
+    size_t vertexSize = vertexData.size() * sizeof(TerrainVertex);
+    size_t totalSize = vertexSize + indexDataSize();
+
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuffer);
+    while (maxBytes > 0 && uploadedBytes < totalSize) {
+        // Vertices first, then indices
+        bool vertexPart = uploadedBytes < vertexSize;
+        size_t offset = vertexPart ? uploadedBytes : uploadedBytes - vertexSize;
+        size_t remaining = vertexPart ? vertexSize - offset : totalSize - uploadedBytes;
+        size_t slice = std::min({ maxBytes, kStagingBufferSize, remaining });
+        const unsigned char* source = (vertexPart ? vertexBytes : indexBytes) + offset;
+
+        // Invalidating lets the driver hand out fresh storage instead of waiting on the last copy
+        void* staging = glMapBufferRange(GL_COPY_READ_BUFFER, 0, slice,
+                                         GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (!staging) {
+            std::cerr << "ERROR::TERRAIN::FAILED_TO_MAP_STAGING_BUFFER" << std::endl;
+            break;
+        }
+        std::memcpy(staging, source, slice);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vertexPart ? terrainVBO : terrainEBO);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, offset, slice);
+
+        uploadedBytes += slice;
+        maxBytes -= slice;
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    if (uploadedBytes < totalSize) return false;
+    glDeleteBuffers(1, &stagingBuffer);
+    stagingBuffer = 0;
+    return true;
+}
+
+size_t Terrain::indexDataSize() const {
+    return use16BitIndices ? chunkIndices.size() * sizeof(GLushort) : indices.size() * sizeof(GLuint);
+}
+
+void Terrain::releaseMeshData() {
+    // Only the draw ranges and indices (for benchmarks and re-extraction) stay on the CPU
+    std::vector<TerrainVertex>().swap(vertexData);
+}
+
+void Terrain::appendTerrainIndices(int columns, int rows, GLuint restart, std::vector<GLuint>& out) const {
+    // Emit cells in column bands so each row's vertices are still cached for the next row
+    int bandWidth = vertexCacheSize > 0 ? vertexCacheBandWidth(vertexCacheSize) : 0;
+    if (topology == TerrainTopology::TRIANGLE_STRIP) {
+        appendGridStrips(columns, rows, bandWidth, restart, out);
+    } else {
+        appendGridTriangles(columns, rows, bandWidth, out);
+    }
+}
+
+GLuint Terrain::restartIndex() const {
+    return use16BitIndices ? 0xFFFFu : 0xFFFFFFFFu;
 }
 
 
@@ -301,12 +831,16 @@ void Terrain::calculateNormals() {
 // Render terrain
 void Terrain::render(const glm::mat4& model, const glm::mat4& view,
     const glm::mat4& projection, const glm::vec3& cameraPosition) {
+    if (loadState != TerrainLoadState::READY) {
+        return;  // Still loading
+    }
     if (!terrainShader->isLoaded()) {
         std::cerr << "ERROR: Failed to compile and link terrain shader!" << std::endl;
         std::cerr << terrainShader->getErrorLog() << std::endl;
         return;  // Stop rendering if shader is not loaded
     }
     terrainShader->use();
+    resetShaderFeatures(*terrainShader);
 
     terrainShader->setMat4("model", model);
     terrainShader->setMat4("view", view);
@@ -318,6 +852,32 @@ void Terrain::render(const glm::mat4& model, const glm::mat4& view,
 //    terrainShader->setVec3("lightColor", glm::vec3(1.0f, 0.5f, 0.7f)); // Warm sunlight color
     terrainShader->setVec3("lightColor", glm::vec3(1.0f, 1.0f, 0.9f)); // Adjust to neutral sunlight
 
+    // Time of day: a distant sun, warmer near the horizon, shadowed by the horizon map
+    if (timeOfDay >= 0.0f && sunHorizonTexture != 0) {
+        terrainShader->setInt("useSunHorizon", 1);
+        float azimuth, elevation;
+        getSunAngles(azimuth, elevation);
+        glm::vec3 sun = getSunDirection();
+        terrainShader->setVec3("lightPos", sun * kSunDistance);
+        float daylight = glm::clamp(sun.y * 3.0f, 0.0f, 1.0f);
+        terrainShader->setVec3("lightColor", glm::mix(glm::vec3(1.0f, 0.55f, 0.35f), glm::vec3(1.0f, 1.0f, 0.9f), daylight));
+
+        int layer;
+        glm::vec4 weights;
+        sunHorizon.lookup(azimuth, layer, weights);
+        float texelsPerWorld = 1.0f / (horizontalScale * sunHorizon.getStride());
+        glm::vec2 texels(static_cast<float>(sunHorizon.getTextureWidth()), static_cast<float>(sunHorizon.getTextureHeight()));
+        glm::vec2 center((width - 1) * 0.5f, (height - 1) * 0.5f);
+        terrainShader->setVec2("horizonScale", glm::vec2(texelsPerWorld) / texels);
+        terrainShader->setVec2("horizonOffset", (center / static_cast<float>(sunHorizon.getStride()) + 0.5f) / texels);
+        terrainShader->setFloat("sunLayer", static_cast<float>(layer));
+        terrainShader->setVec4("sunWeights", weights);
+        terrainShader->setFloat("sunElevation", elevation);
+        glActiveTexture(GL_TEXTURE3);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, sunHorizonTexture);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
     terrainShader->setFloat("shininess", 24.0f); // Adjust shininess
 
 
@@ -328,16 +888,71 @@ void Terrain::render(const glm::mat4& model, const glm::mat4& view,
     // Bind texture
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    terrainShader->setInt("terrainTexture", 0);
+
+    // Per-sample textures; sample (0, 0) sits at the centre of the first texel
+    glm::vec2 samples(static_cast<float>(width), static_cast<float>(height));
+    terrainShader->setVec2("gridScale", glm::vec2(1.0f / horizontalScale) / samples);
+    terrainShader->setVec2("gridOffset", (glm::vec2((width - 1) * 0.5f, (height - 1) * 0.5f) + 0.5f) / samples);
+    if (visibilityTexture != 0) {
+        terrainShader->setInt("useVisibilityMask", 1);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+    }
+    if (occlusionTexture != 0) {
+        terrainShader->setInt("useOcclusionMap", 1);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, occlusionTexture);
+    }
+    if (analysisTexture != 0) {
+        terrainShader->setInt("useAnalysisMap", 1);
+        glActiveTexture(GL_TEXTURE5);
+        glBindTexture(GL_TEXTURE_2D, analysisTexture);
+    }
+    if (splatTexture != 0 && layerTexture != 0) {
+        terrainShader->setInt("useSplatMap", 1);
+        glActiveTexture(GL_TEXTURE6);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, layerTexture);
+        glActiveTexture(GL_TEXTURE7);
+        glBindTexture(GL_TEXTURE_2D, splatTexture);
+    }
+    if (colorMap != nullptr && colorMap->isOpen()) {
+        terrainShader->setInt("useColorMap", 1);
+        colorMap->bind(*terrainShader, 8);
+    }
+    if (riverTexture != 0) {
+        terrainShader->setInt("useRiverMap", 1);
+        glActiveTexture(GL_TEXTURE4);
+        glBindTexture(GL_TEXTURE_2D, riverTexture);
+    }
+    glActiveTexture(GL_TEXTURE0);
 
         // Draw the terrain
+    GLenum mode = GL_TRIANGLES;
+    if (topology == TerrainTopology::TRIANGLE_STRIP) {
+        mode = GL_TRIANGLE_STRIP;
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restartIndex());
+    }
     glBindVertexArray(terrainVAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    if (use16BitIndices) {
+        for (const auto& chunk : chunks) {
+            glDrawElementsBaseVertex(mode, chunk.indexCount, GL_UNSIGNED_SHORT,
+                                     (void*)chunk.indexOffset, chunk.baseVertex);
+        }
+    } else {
+        glDrawElements(mode, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, 0);
+    }
     glBindVertexArray(0);
+    if (topology == TerrainTopology::TRIANGLE_STRIP) {
+        glDisable(GL_PRIMITIVE_RESTART);
+    }
 //
 
 }
 float Terrain::getHeightAtPosition(float x, float z) const {
+    if (positions.empty()) {
+        return 0.0f;
+    }
     float halfWidth = (width - 1) * horizontalScale * 0.5f;
     float halfDepth = (height - 1) * horizontalScale * 0.5f;
 
@@ -383,6 +998,42 @@ float Terrain::getHeightAtPosition(float x, float z) const {
 
 
 bool Terrain::loadTexture(const std::string& textureFile) {
+    auto start = std::chrono::steady_clock::now();
+    // A block-compressed container from compressTexture() skips decoding and mips
+    // entirely; it is ignored once the image or the daylight adjustments change.
+    // Holding the image bytes lets the fallback below reuse them instead of rereading
+    AssetData encoded = AssetManager::getInstance().readFile(textureFile);
+    uint64_t key = encoded ? texturePipeline.keyFor(encoded.data, encoded.size) : 0;
+    // The same image under the same adjustments is uploaded once, whichever path it came from
+    if (std::shared_ptr<Texture> live = encoded ? AssetManager::getInstance().findTexture(key) : nullptr) {
+        sharedTexture = live;
+        textureID = live->getID();
+        std::cout << "INFO: Sharing the loaded texture for " << textureFile << std::endl;
+        return true;
+    }
+    CompressedTexture compressed;
+    bool useCompressed = encoded && TextureCompressor::readContainer(textureFile + ".bct", key, compressed) &&
+                         TextureCompressor::isSupported(compressed.format);
+    // Otherwise daylight adjustment and mips come from the CPU pipeline, cached next to the image
+    MipChain chain;
+    GLenum format = GL_RGBA;
+    if (!useCompressed) {
+        if (!texturePipeline.loadCached(textureFile, textureFile + ".mips", chain)) {
+            std::cerr << "ERROR::TERRAIN::FAILED_TO_LOAD_TEXTURE: " << textureFile << std::endl;
+            return false;
+        }
+        if (chain.channels == 1)
+            format = GL_RED;
+        else if (chain.channels == 3)
+            format = GL_RGB;
+        else if (chain.channels == 4)
+            format = GL_RGBA;
+        else {
+            std::cerr << "ERROR::TERRAIN::UNSUPPORTED_TEXTURE_FORMAT: " << textureFile << std::endl;
+            return false;
+        }
+    }
+
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
 
@@ -392,50 +1043,127 @@ bool Terrain::loadTexture(const std::string& textureFile) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // Minification filter
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR); // Magnification filter
 
-    // Load image using stb_image
-    int texWidth, texHeight, nrChannels;
-    unsigned char* data = stbi_load(textureFile.c_str(), &texWidth, &texHeight, &nrChannels, 0);
-    if (data) {
-        //Adjust brightness and contrast to simulate daylight
-        float brightnessFactor = 1.2f; // Brighten the texture
-        float contrastFactor = 1.1f;  // Increase contrast
-
-        for (int i = 0; i < texWidth * texHeight * nrChannels; ++i) {
-            float pixel = data[i] / 255.0f; // Normalize pixel value
-            pixel = (pixel - 0.5f) * contrastFactor + 0.5f; // Apply contrast
-            pixel *= brightnessFactor; // Apply brightness
-            data[i] = static_cast<unsigned char>(glm::clamp(pixel, 0.0f, 1.0f) * 255.0f);
+    if (useCompressed) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, compressed.getLevels() - 1);
+        TextureCompressor::upload(compressed, GL_TEXTURE_2D);
+    } else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain.getLevels() - 1);
+        // Rows of RGB and odd widths are not 4-byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for (int level = 0; level < chain.getLevels(); ++level) {
+            glTexImage2D(GL_TEXTURE_2D, level, format, chain.levelWidth(level), chain.levelHeight(level), 0,
+                         format, GL_UNSIGNED_BYTE, chain.levelData(level));
         }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    sharedTexture = AssetManager::getInstance().shareTexture(key, textureID);
 
-        GLenum format;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-        else {
-            std::cerr << "ERROR::TERRAIN::UNSUPPORTED_TEXTURE_FORMAT: " << textureFile << std::endl;
-            stbi_image_free(data);
-            return false;
-        }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (useCompressed) {
+        std::cout << "INFO: Terrain texture loaded as BC" << static_cast<uint32_t>(compressed.format) << " ("
+                  << compressed.data.size() / 1024 << " KB) in " << loadMs << " ms." << std::endl;
+    } else {
+        std::cout << "INFO: Terrain texture loaded successfully with daylight adjustments in " << loadMs << " ms." << std::endl;
+    }
+    return true;
+}
 
-        // Adjust the texture format to ensure proper daylight color rendering
-        glTexImage2D(GL_TEXTURE_2D, 0, format, texWidth, texHeight, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+bool Terrain::compressTexture(const std::string& textureFile, BlockFormat format) {
+    ImagePipeline pipeline;
+    configureDaylight(pipeline);
+    return TextureCompressor::compressFile(textureFile, textureFile + ".bct", format, pipeline);
+}
 
+bool Terrain::loadTextureLayers(const std::vector<std::string>& layerFiles) {
+    if (layerFiles.empty() || layerFiles.size() > static_cast<size_t>(kLayerCount)) {
+        std::cerr << "ERROR::TERRAIN::LAYER_COUNT: expected 1 to " << kLayerCount << " layer images" << std::endl;
+        return false;
+    }
+    // The array is keyed on every image under the daylight adjustments, so the same
+    // layers are decoded and uploaded once
+    std::vector<AssetData> encoded;
+    std::vector<uint64_t> imageKeys;
+    for (const std::string& file : layerFiles) {
+        encoded.push_back(AssetManager::getInstance().readFile(file));
+        imageKeys.push_back(encoded.back() ? texturePipeline.keyFor(encoded.back().data, encoded.back().size) : 0);
+    }
+    uint64_t key = hashBakeBytes(reinterpret_cast<const unsigned char*>(imageKeys.data()), imageKeys.size() * sizeof(uint64_t),
+                                 { static_cast<float>(kLayerCount), static_cast<float>(kLayerSize) });
+    if (std::shared_ptr<Texture> live = AssetManager::getInstance().findTexture(key)) {
+        sharedLayers = live;
+        layerTexture = live->getID();
+        std::cout << "INFO: Sharing the loaded terrain layer array." << std::endl;
+        return true;
+    }
 
+    const size_t layerTexels = static_cast<size_t>(kLayerSize) * kLayerSize;
+    std::vector<unsigned char> texels(layerTexels * 4 * kLayerCount);
+    for (size_t layer = 0; layer < layerFiles.size(); ++layer) {
+        int imageWidth, imageHeight, channels;
+        unsigned char* data = !encoded[layer] ? nullptr
+            : stbi_load_from_memory(encoded[layer].data, static_cast<int>(encoded[layer].size), &imageWidth, &imageHeight, &channels, 0);
+        if (!data) {
+            std::cerr << "ERROR::TERRAIN::FAILED_TO_LOAD_TEXTURE: " << layerFiles[layer] << std::endl;
+            return false;
+        }
+        texturePipeline.apply(data, static_cast<size_t>(imageWidth) * imageHeight * channels);
+        resampleLayer(data, imageWidth, imageHeight, channels, kLayerSize, &texels[layer * layerTexels * 4]);
         stbi_image_free(data);
-        std::cout << "INFO: Terrain texture loaded successfully with daylight adjustments." << std::endl;
-        return true;
-    } else {
-        std::cerr << "ERROR::TERRAIN::FAILED_TO_LOAD_TEXTURE: " << textureFile << std::endl;
-        return false;
     }
+    // Grass and rock fall back to the last image; scree and snow are tinted from it
+    const unsigned char* last = &texels[(layerFiles.size() - 1) * layerTexels * 4];
+    for (int layer = static_cast<int>(layerFiles.size()); layer < kLayerCount; ++layer) {
+        unsigned char* target = &texels[layer * layerTexels * 4];
+        if (layer < 2) {
+            std::memcpy(target, last, layerTexels * 4);
+        } else {
+            tintLayer(last, layerTexels, layer, target);
+        }
+    }
+
+    // Mips per layer on the CPU, gathered per level for the array upload
+    std::vector<MipChain> chains(kLayerCount);
+    for (int layer = 0; layer < kLayerCount; ++layer) {
+        texturePipeline.process(&texels[layer * layerTexels * 4], kLayerSize, kLayerSize, 4, false, chains[layer]);
+    }
+    const int levels = chains[0].getLevels();
+
+    // A fresh name: the previous array may still be held by another terrain
+    glGenTextures(1, &layerTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, layerTexture);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+    std::vector<unsigned char> levelTexels;
+    for (int level = 0; level < levels; ++level) {
+        size_t levelBytes = static_cast<size_t>(chains[0].levelWidth(level)) * chains[0].levelHeight(level) * 4;
+        levelTexels.resize(levelBytes * kLayerCount);
+        for (int layer = 0; layer < kLayerCount; ++layer) {
+            std::memcpy(&levelTexels[layer * levelBytes], chains[layer].levelData(level), levelBytes);
+        }
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, chains[0].levelWidth(level), chains[0].levelHeight(level),
+                     kLayerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, levelTexels.data());
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    sharedLayers = AssetManager::getInstance().shareTexture(key, layerTexture);
+    std::cout << "INFO: " << layerFiles.size() << " terrain layer images loaded into a " << kLayerCount
+              << "-layer array." << std::endl;
+    return true;
 }
 
 // Cleanup terrain resources
 void Terrain::cleanup() {
+    // A background build still writes to the CPU data
+    if (pendingBuild.valid()) {
+        pendingBuild.wait();
+        pendingBuild = std::future<bool>();
+    }
+    if (stagingBuffer) glDeleteBuffers(1, &stagingBuffer);
+    stagingBuffer = 0;
+    loadState = TerrainLoadState::EMPTY;
     if (terrainVAO) glDeleteVertexArrays(1, &terrainVAO);
     if (terrainVBO) glDeleteBuffers(1, &terrainVBO);
     if (terrainEBO) glDeleteBuffers(1, &terrainEBO);
@@ -443,13 +1171,47 @@ void Terrain::cleanup() {
     terrainVAO = 0;
     terrainVBO = 0;
     terrainEBO = 0;
-    if (textureID != 0) {
-            glDeleteTextures(1, &textureID);
-            textureID = 0;
-        }
+    // Shared textures are deleted with their last holder
+    sharedTexture.reset();
+    textureID = 0;
+    if (occlusionTexture != 0) {
+        glDeleteTextures(1, &occlusionTexture);
+        occlusionTexture = 0;
+    }
+    if (analysisTexture != 0) {
+        glDeleteTextures(1, &analysisTexture);
+        analysisTexture = 0;
+    }
+    if (splatTexture != 0) {
+        glDeleteTextures(1, &splatTexture);
+        splatTexture = 0;
+    }
+    sharedLayers.reset();
+    layerTexture = 0;
+    if (sunHorizonTexture != 0) {
+        glDeleteTextures(1, &sunHorizonTexture);
+        sunHorizonTexture = 0;
+    }
+    if (waterVAO) glDeleteVertexArrays(1, &waterVAO);
+    if (waterVBO) glDeleteBuffers(1, &waterVBO);
+    if (waterEBO) glDeleteBuffers(1, &waterEBO);
+    waterVAO = waterVBO = waterEBO = 0;
+    waterPlanes.clear();
+    waterVertices.clear();
+    waterIndices.clear();
+    waterBuffersDirty = false;
     positions.clear();
     normals.clear();
+    vertexData.clear();
     indices.clear();
+    chunkIndices.clear();
+    chunks.clear();
+    rtin = TerrainRTIN();
+    heightPyramid = HeightPyramid();
+    horizonAO = HorizonAO();
+    sunHorizon = SunHorizonMap();
+    analysis = TerrainAnalysis();
+    splatMap = SplatMap();
     heights.clear();
     texCoords.clear();
 
@@ -482,6 +1244,166 @@ float Terrain::getMaxHeight() const {
 // Setters
 void Terrain::setHeightScale(float scale) { heightScale = scale; }
 void Terrain::setHorizontalScale(float scale) { horizontalScale = scale; }
+void Terrain::setUse16BitIndices(bool enable) { use16BitIndices = gridUse16BitIndices = enable; }
+void Terrain::setTopology(TerrainTopology mode) { topology = gridTopology = mode; }
+
+bool Terrain::setAdaptiveMaxError(float maxError) {
+    TerrainLoadState state = loadState;
+    if (state == TerrainLoadState::BUILDING || state == TerrainLoadState::UPLOADING) {
+        std::cerr << "ERROR::TERRAIN::ADAPTIVE_MESH_CHANGED_WHILE_LOADING" << std::endl;
+        return false;
+    }
+    adaptiveMaxError = maxError;
+    if (state != TerrainLoadState::READY) {
+        return true; // Applied by the next load
+    }
+
+    if (maxError >= 0.0f && !use16BitIndices && topology == TerrainTopology::TRIANGLES) {
+        // Shared grid vertices are already uploaded: re-extract into the index buffer only
+        getAdaptiveMesher();
+        indices.clear();
+        rtin.extract(maxError, indices);
+        glBindVertexArray(terrainVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, terrainEBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    } else {
+        // Chunked or strip vertices, or back to the grid: rebuild both buffers from the CPU grid
+        if (maxError >= 0.0f) {
+            getAdaptiveMesher();
+        }
+        buildMeshData();
+        reuploadMeshData();
+        releaseMeshData();
+    }
+    if (maxError >= 0.0f) {
+        std::cout << "INFO: Adaptive terrain mesh: " << indices.size() / 3 << " triangles at max error "
+                  << maxError << std::endl;
+    } else {
+        std::cout << "INFO: Terrain mesh restored to the regular grid." << std::endl;
+    }
+    return true;
+}
+
+const TerrainAnalysis& Terrain::getAnalysis() const {
+    return analysis;
+}
+
+const TerrainRTIN& Terrain::getAdaptiveMesher() {
+    if (!rtin.isBuilt()) {
+        rtin.build(heights, width, height);
+    }
+    return rtin;
+}
+void Terrain::setVertexCacheSize(int entries) { vertexCacheSize = entries; }
+void Terrain::setErosionDroplets(int droplets) { erosionDroplets = std::max(0, droplets); }
+void Terrain::setProceduralSource(const ProceduralSettings& settings, int size) {
+    procedural.setSettings(settings);
+    proceduralSize = size >= 2 ? size : 0;
+}
+
+VertexCacheStats Terrain::benchmarkVertexCache(int cacheSize) const {
+    // Baseline: the original row-by-row order over the shared grid vertices
+    std::vector<GLuint> rowMajor;
+    appendGridTriangles(width, height, 0, rowMajor);
+    VertexCacheStats baseline = simulateVertexCache(rowMajor, positions.size(), cacheSize);
+
+    // Current index buffer, with chunk indices rebased onto the whole VBO
+    std::vector<GLuint> current;
+    size_t indexBytes;
+    if (use16BitIndices) {
+        current.reserve(chunkIndices.size());
+        for (const auto& chunk : chunks) {
+            size_t first = chunk.indexOffset / sizeof(GLushort);
+            for (GLsizei i = 0; i < chunk.indexCount; ++i) {
+                GLushort index = chunkIndices[first + i];
+                current.push_back(index == 0xFFFFu ? 0xFFFFFFFFu : index + chunk.baseVertex);
+            }
+        }
+        indexBytes = chunkIndices.size() * sizeof(GLushort);
+    } else {
+        current = indices;
+        indexBytes = indices.size() * sizeof(GLuint);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    VertexCacheStats stats = simulateVertexCache(current, terrainVertexCount, cacheSize, topology, 0xFFFFFFFFu);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "INFO: Vertex cache simulation (" << cacheSize << " entry FIFO, "
+              << stats.triangles << " triangles, " << ms << " ms)" << std::endl;
+    std::cout << "INFO:   row-major  ACMR " << baseline.acmr << "  ATVR " << baseline.atvr
+              << "  index bytes " << rowMajor.size() * sizeof(GLuint) << std::endl;
+    std::cout << "INFO:   current    ACMR " << stats.acmr << "  ATVR " << stats.atvr
+              << "  index bytes " << indexBytes << std::endl;
+    return stats;
+}
+
+bool Terrain::raycast(const glm::vec3& origin, const glm::vec3& direction, glm::vec3& hitPoint,
+                      float maxDistance) const {
+    float length = glm::length(direction);
+    if (!hasHeightData() || length == 0.0f) {
+        return false;
+    }
+
+    // The pyramid works in sample coordinates; y stays in world units
+    float halfWidth = (width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (height - 1) * horizontalScale * 0.5f;
+    float invHS = 1.0f / horizontalScale;
+    glm::vec3 gridOrigin((origin.x + halfWidth) * invHS, origin.y, (origin.z + halfDepth) * invHS);
+    glm::vec3 gridDirection(direction.x * invHS, direction.y, direction.z * invHS);
+
+    float t;
+    if (!heightPyramid.intersect(gridOrigin, gridDirection, maxDistance / length, t)) {
+        return false;
+    }
+    hitPoint = origin + direction * t;
+    return true;
+}
+
+void Terrain::benchmarkRaycast(int rayCount) const {
+    if (!hasHeightData()) return;
+
+    // Rays from above the terrain looking down at a random angle, like mouse picks
+    float halfWidth = (width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (height - 1) * horizontalScale * 0.5f;
+    std::mt19937 generator(1234);
+    auto uniform = [&generator](float low, float high) {
+        return std::uniform_real_distribution<float>(low, high)(generator);
+    };
+    std::vector<glm::vec3> origins(rayCount), directions(rayCount);
+    for (int i = 0; i < rayCount; ++i) {
+        origins[i] = glm::vec3(uniform(-halfWidth, halfWidth), maxHeight + 50.0f, uniform(-halfDepth, halfDepth));
+        directions[i] = glm::normalize(glm::vec3(uniform(-1.0f, 1.0f), uniform(-0.6f, -0.05f), uniform(-1.0f, 1.0f)));
+    }
+
+    int pyramidHits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rayCount; ++i) {
+        glm::vec3 hit;
+        pyramidHits += raycast(origins[i], directions[i], hit) ? 1 : 0;
+    }
+    double pyramidMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Baseline: march in half-sample steps until the ray drops below the surface
+    int marchHits = 0;
+    float step = 0.5f * horizontalScale;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rayCount; ++i) {
+        glm::vec3 p = origins[i];
+        while (std::fabs(p.x) <= halfWidth && std::fabs(p.z) <= halfDepth && p.y >= minHeight) {
+            if (p.y <= getHeightAtPosition(p.x, p.z)) {
+                marchHits++;
+                break;
+            }
+            p += directions[i] * step;
+        }
+    }
+    double marchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "INFO: Ray casts (" << rayCount << " rays): pyramid " << pyramidMs << " ms, "
+              << pyramidHits << " hits; fixed-step march " << marchMs << " ms, " << marchHits << " hits" << std::endl;
+}
 
 //water rendering
 void Terrain::renderWater(const glm::mat4& model, const glm::mat4& view,
@@ -491,6 +1413,42 @@ void Terrain::renderWater(const glm::mat4& model, const glm::mat4& view,
         std::cerr << waterShader.getErrorLog() << std::endl;
         return;  // Stop rendering if shader is not loaded
     }
+    uploadWaterBuffers();
+    visibleWaterPlanes = 0;
+    if (waterVAO == 0 || waterPlanes.empty()) return;
+
+    // Cull the planes against the frustum and sort the rest front to back, so nearer
+    // water fills the depth buffer first and hidden blended fragments are rejected
+    Frustum frustum(projection * view * model);
+    glm::vec3 eye = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+    waterDrawOrder.clear();
+    for (size_t i = 0; i < waterPlanes.size(); ++i) {
+        const WaterPlane& plane = waterPlanes[i];
+        glm::vec3 halfSize(plane.size.x * 0.5f, 0.0f, plane.size.y * 0.5f);
+        glm::vec3 center(plane.position.x, plane.height, plane.position.z);
+        if (plane.indexCount == 0 || !frustum.intersectsBox(center - halfSize, center + halfSize)) continue;
+        glm::vec3 nearest = glm::clamp(eye, center - halfSize, center + halfSize);
+        glm::vec3 offset = nearest - eye;
+        waterDrawOrder.emplace_back(glm::dot(offset, offset), i);
+    }
+    if (waterDrawOrder.empty()) return;
+    std::sort(waterDrawOrder.begin(), waterDrawOrder.end());
+
+    // Neighbours in the index buffer that are also neighbours in draw order share a range
+    waterDrawCounts.clear();
+    waterDrawOffsets.clear();
+    size_t nextIndex = 0;
+    for (const auto& entry : waterDrawOrder) {
+        const WaterPlane& plane = waterPlanes[entry.second];
+        if (!waterDrawCounts.empty() && plane.firstIndex == nextIndex) {
+            waterDrawCounts.back() += plane.indexCount;
+        } else {
+            waterDrawCounts.push_back(plane.indexCount);
+            waterDrawOffsets.push_back((const void*)(plane.firstIndex * sizeof(GLuint)));
+        }
+        nextIndex = plane.firstIndex + plane.indexCount;
+    }
+    visibleWaterPlanes = waterDrawOrder.size();
 
     waterShader.use();
 
@@ -504,58 +1462,100 @@ void Terrain::renderWater(const glm::mat4& model, const glm::mat4& view,
     
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glBindVertexArray(waterVAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    glMultiDrawElements(GL_TRIANGLES, waterDrawCounts.data(), GL_UNSIGNED_INT, waterDrawOffsets.data(),
+                        static_cast<GLsizei>(waterDrawCounts.size()));
     glBindVertexArray(0);
     
 }
 
+size_t Terrain::getVisibleWaterPlanes() const {
+    return visibleWaterPlanes;
+}
 
 void Terrain::addWaterPlane(const glm::vec3& position, const glm::vec2& size, float height) {
+    glm::vec2 halfSize = size * 0.5f;
+    glm::vec2 boundsMin(position.x - halfSize.x, position.z - halfSize.y);
+    glm::vec2 boundsMax(position.x + halfSize.x, position.z + halfSize.y);
+    std::vector<glm::vec3> vertices = {
+        glm::vec3(boundsMin.x, height, boundsMin.y),  // Bottom-left
+        glm::vec3(boundsMax.x, height, boundsMin.y),  // Bottom-right
+        glm::vec3(boundsMax.x, height, boundsMax.y),  // Top-right
+        glm::vec3(boundsMin.x, height, boundsMax.y)   // Top-left
+    };
+    appendWaterMesh(vertices, { 0, 1, 2, 0, 2, 3 }, boundsMin, boundsMax, height);
+}
+
+void Terrain::appendWaterMesh(const std::vector<glm::vec3>& vertices, const std::vector<GLuint>& indices,
+                              const glm::vec2& boundsMin, const glm::vec2& boundsMax, float height) {
     WaterPlane plane;
-    plane.position = position;
-    plane.size = size;
+    glm::vec2 center = (boundsMin + boundsMax) * 0.5f;
+    plane.position = glm::vec3(center.x, height, center.y);
+    plane.size = boundsMax - boundsMin;
     plane.height = height;
+    plane.firstIndex = static_cast<unsigned int>(waterIndices.size());
+    plane.indexCount = static_cast<unsigned int>(indices.size());
+
+    GLuint baseVertex = static_cast<GLuint>(waterVertices.size());
+    waterVertices.insert(waterVertices.end(), vertices.begin(), vertices.end());
+    for (GLuint index : indices) {
+        waterIndices.push_back(baseVertex + index);
+    }
     waterPlanes.push_back(plane);
+    waterBuffersDirty = true;
 }
 
-
 void Terrain::setupWaterPlane() {
-    waterHeight = 10.0f; // Adjust this height as needed
-
-    // Define a simple quad for the water plane
-    float halfWidth = (width - 1) * horizontalScale * 0.3f;
-    float halfDepth = (height - 1) * horizontalScale * 0.29f;
-
-    // Define a smaller water plane
-//        float halfWidth = 40.0f; // Fixed width of the water plane (e.g., 100x100 size)
-//        float halfDepth = 40.0f; // Fixed depth of the water plane
-
-    float waterVertices[] = {
-        -halfWidth, waterHeight, -halfDepth,  // Bottom-left
-         halfWidth, waterHeight, -halfDepth,  // Bottom-right
-         halfWidth, waterHeight,  halfDepth,  // Top-right
-        -halfWidth, waterHeight,  halfDepth   // Top-left
-    };
+    // The lakes were found with the heights; here they become water planes
+    const std::vector<glm::vec3>& lakeVertices = lakeDetector.getVertices();
+    const std::vector<uint32_t>& lakeIndices = lakeDetector.getIndices();
+    float halfWidth = (width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (height - 1) * horizontalScale * 0.5f;
 
-    unsigned int waterIndices[] = {
-        0, 1, 2, // First triangle
-        0, 2, 3  // Second triangle
-    };
+    // Each lake's quads are independent, so its vertices are a contiguous slice
+    std::vector<glm::vec3> vertices;
+    std::vector<GLuint> indices;
+    for (const Lake& lake : lakeDetector.getLakes()) {
+        if (lake.indexCount == 0) continue;
+        uint32_t firstVertex = lakeIndices[lake.firstIndex];
+        uint32_t lastVertex = lakeIndices[lake.firstIndex + lake.indexCount - 1];
+        for (uint32_t i = lake.firstIndex; i < lake.firstIndex + lake.indexCount; ++i) {
+            firstVertex = std::min(firstVertex, lakeIndices[i]);
+            lastVertex = std::max(lastVertex, lakeIndices[i]);
+        }
+        vertices.assign(lakeVertices.begin() + firstVertex, lakeVertices.begin() + lastVertex + 1);
+        indices.clear();
+        for (uint32_t i = lake.firstIndex; i < lake.firstIndex + lake.indexCount; ++i) {
+            indices.push_back(lakeIndices[i] - firstVertex);
+        }
+        // Bounds of the shoreline cells, one sample beyond the submerged ones
+        glm::vec2 boundsMin(std::max(lake.minX - 1, 0) * horizontalScale - halfWidth,
+                            std::max(lake.minZ - 1, 0) * horizontalScale - halfDepth);
+        glm::vec2 boundsMax(std::min(lake.maxX + 1, width - 1) * horizontalScale - halfWidth,
+                            std::min(lake.maxZ + 1, height - 1) * horizontalScale - halfDepth);
+        appendWaterMesh(vertices, indices, boundsMin, boundsMax, lake.level);
+    }
+    uploadWaterBuffers();
+    std::cout << "INFO: " << waterPlanes.size() << " water planes, " << waterIndices.size() / 3
+              << " triangles." << std::endl;
+}
 
-    // Create VAO and VBO for the water plane
-    glGenVertexArrays(1, &waterVAO);
-    glGenBuffers(1, &waterVBO);
+void Terrain::uploadWaterBuffers() {
+    if (!waterBuffersDirty) return;
+    waterBuffersDirty = false;
+    if (waterIndices.empty()) return;
 
-    GLuint waterEBO;
-    glGenBuffers(1, &waterEBO);
+    // Create VAO and VBO for all water planes
+    if (waterVAO == 0) glGenVertexArrays(1, &waterVAO);
+    if (waterVBO == 0) glGenBuffers(1, &waterVBO);
+    if (waterEBO == 0) glGenBuffers(1, &waterEBO);
 
     glBindVertexArray(waterVAO);
 
     glBindBuffer(GL_ARRAY_BUFFER, waterVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(waterVertices), waterVertices, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, waterVertices.size() * sizeof(glm::vec3), waterVertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, waterEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(waterIndices), waterIndices, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, waterIndices.size() * sizeof(GLuint), waterIndices.data(), GL_STATIC_DRAW);
 
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
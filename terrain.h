@@ -3,18 +3,63 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include <future>
+#include <cfloat>
+#include <utility>
+#include <random>
+#include <memory>
 #include <glm/glm.hpp>
 #include "shader.h"
+#include "terrainMesh.h"
+#include "rtin.h"
+#include "heightField.h"
+#include "heightPyramid.h"
+#include "horizonAO.h"
+#include "sunHorizon.h"
+#include "proceduralTerrain.h"
+#include "lakeDetector.h"
+#include "terrainAnalysis.h"
+#include "splatMap.h"
+#include "virtualTexture.h"
+#include "imagePipeline.h"
+#include "textureCompression.h"
+#include "texture.h"
 struct WaterPlane {
     glm::vec3 position; // Center position of the water plane
     glm::vec2 size;     // Size (width and depth) of the water plane
     float height;       // Height of the water plane
+    unsigned int firstIndex; // First index of the plane's triangles in the water EBO
+    unsigned int indexCount; // Number of indices of the plane's triangles
 };
+/**
+ * @brief Interleaved terrain vertex as stored in the VBO.
+ */
+struct TerrainVertex {
+    glm::vec3 Position;
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+};
+
+/**
+ * @brief Progress of a terrain load.
+ */
+enum class TerrainLoadState {
+    EMPTY,      ///< Nothing loaded.
+    BUILDING,   ///< CPU stage running (decode, noise, diamond-square, normals, indices).
+    UPLOADING,  ///< Heights available; GPU buffers are being streamed.
+    READY,      ///< Fully loaded and renderable.
+    FAILED      ///< The CPU stage failed.
+};
+
+/// Upload budget per frame for streamed terrain loads (see Terrain::updateAsyncLoad).
+const size_t kTerrainUploadBytesPerFrame = 8 * 1024 * 1024;
+
 /**
  * @class Terrain
  * @brief Handles loading, rendering, and interaction with the terrain.
  */
-class Terrain {
+class Terrain : public HeightField {
 public:
     /**
      * @brief Constructor.
@@ -23,12 +68,38 @@ public:
     ~Terrain();
 
     /**
-     * @brief Loads terrain data from a heightmap image.
-     * @param texturePath Path to the heightmap image.
+     * @brief Loads terrain data from a heightmap image, or from a raw DEM
+     *        (.r16/.raw, .r32/.f32, .hgt).
+     * @param texturePath Path to the heightmap image or DEM.
      * @return True if successful, false otherwise.
      */
     bool loadTerrainData(const std::string& texturePath);
 
+    /**
+     * @brief Starts loading a heightmap on a worker thread. The CPU stage runs in the
+     *        background; updateAsyncLoad streams the result to the GPU.
+     * @param heightmapFile Path to the heightmap image.
+     */
+    void loadTerrainDataAsync(const std::string& heightmapFile);
+
+    /**
+     * @brief Advances an asynchronous load. Must be called on the render thread,
+     *        typically once per frame.
+     * @param maxUploadBytes Upload budget for this call.
+     * @return True once the terrain is ready to render.
+     */
+    bool updateAsyncLoad(size_t maxUploadBytes);
+
+    /**
+     * @brief Returns the progress of the current load.
+     */
+    TerrainLoadState getLoadState() const;
+
+    /**
+     * @brief Returns true once heights can be queried (the GPU upload may still be running).
+     */
+    bool hasHeightData() const;
+
     /**
      * @brief Renders the terrain.
      * @param model Model matrix.
@@ -50,6 +121,25 @@ public:
      * @return Height value at the given position.
      */
     float getHeightAtPosition(float x, float z) const;
+
+    /**
+     * @brief Finds the first point where a ray hits the terrain surface, using the
+     *        min/max height pyramid. Safe to call from several threads once heights exist.
+     * @param origin Ray origin in world space.
+     * @param direction Ray direction in world space.
+     * @param hitPoint Receives the hit point.
+     * @param maxDistance Longest distance along the ray to search.
+     * @return True if the ray hits the terrain.
+     */
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, glm::vec3& hitPoint,
+                 float maxDistance = FLT_MAX) const;
+
+    /**
+     * @brief Times random picking rays through the height pyramid against fixed-step
+     *        marching with getHeightAtPosition and prints both.
+     * @param rayCount Number of rays.
+     */
+    void benchmarkRaycast(int rayCount) const;
     void cleanup();
 
     // Getters
@@ -65,10 +155,155 @@ public:
     float getMinHeight() const;  //
     float getMaxHeight() const;  //
     
-    void setShader(Shader* shader); // Accept a pointer
+    /**
+     * @brief Draws the terrain in chunks with their own vertices and 16-bit indices.
+     *        Must be set before loadTerrainData.
+     * @param enable True for 16-bit chunked indices, false for one 32-bit index buffer.
+     */
+    void setUse16BitIndices(bool enable);
+
+    /**
+     * @brief Selects triangle lists or primitive-restart strips for the terrain mesh.
+     *        Must be set before loadTerrainData.
+     * @param mode Topology of the terrain index buffer.
+     */
+    void setTopology(TerrainTopology mode);
+
+    /**
+     * @brief Replaces the regular grid with an adaptive (RTIN) mesh whose vertical error
+     *        stays below maxError. Adaptive meshes share the grid vertices and are drawn
+     *        as one 32-bit triangle list. Set before loading, it applies to the next load;
+     *        once the terrain is ready the mesh is rebuilt on the spot, whatever its index
+     *        layout. A negative value restores the regular grid in the layout chosen with
+     *        setUse16BitIndices() and setTopology().
+     * @param maxError Maximum error in world units, or a negative value for the regular grid.
+     * @return False, with nothing changed, while a load is in progress.
+     */
+    bool setAdaptiveMaxError(float maxError);
+
+    /**
+     * @brief Retrieves the adaptive mesher, building its error hierarchy on first use.
+     * @return Reference to the RTIN for the loaded heights.
+     */
+    const TerrainRTIN& getAdaptiveMesher();
+
+    /**
+     * @brief Slope, aspect and curvature per sample, computed once while loading.
+     */
+    const TerrainAnalysis& getAnalysis() const;
+
+    /**
+     * @brief Sets the post-transform cache size the index order is optimised for.
+     * @param entries Number of cache entries (0 keeps the original row-major order).
+     */
+    void setVertexCacheSize(int entries);
+
+    /**
+     * @brief Runs droplet hydraulic erosion over the heights while loading. The eroded
+     *        heights are cached next to the heightmap. Must be set before loadTerrainData.
+     * @param droplets Number of droplets, or 0 to skip erosion.
+     */
+    void setErosionDroplets(int droplets);
+
+    /**
+     * @brief Generates the heights procedurally instead of reading the heightmap file,
+     *        which then only names the bake caches. Must be set before loadTerrainData.
+     * @param settings Noise parameters.
+     * @param size Samples per side, or 0 to read the heightmap again.
+     */
+    void setProceduralSource(const ProceduralSettings& settings, int size);
+
+    /**
+     * @brief Simulates a FIFO post-transform cache over the current index buffer and the
+     *        row-major order, and prints ACMR/ATVR for both.
+     * @param cacheSize Number of simulated cache entries.
+     * @return Statistics for the current index buffer.
+     */
+    VertexCacheStats benchmarkVertexCache(int cacheSize) const;
+
+    /**
+     * @brief Sets the terrain shader and assigns each of its samplers a texture unit
+     *        once. Must be called on the render thread.
+     * @param shader Compiled terrain shader.
+     */
+    void setShader(Shader* shader);
+
+    /**
+     * @brief Turns off every optional per-sample texture of the terrain shader. Renderers
+     *        sharing the shader call this first and then enable what they bind, so a
+     *        feature added to the shader only has to clear its use* flag here.
+     * @param shader Terrain shader, in use.
+     */
+    static void resetShaderFeatures(Shader& shader);
     Shader* getShader() const;      // Return a pointer
+    GLuint getTextureID() const;
+
+    /**
+     * @brief Row-major height samples in world units, valid once hasHeightData() is true.
+     */
+    const std::vector<float>& getHeights() const;
+
+    /**
+     * @brief Converts a world (x, z) position to unclamped sample coordinates.
+     */
+    glm::vec2 getSampleCoordinates(float x, float z) const;
+
+    /**
+     * @brief Tints the terrain with a per-sample visibility mask (R8, one texel per
+     *        sample, 255 = visible), e.g. a viewshed.
+     * @param texture Mask texture, or 0 to disable the tint.
+     */
+    void setVisibilityMask(GLuint texture);
+
+    /**
+     * @brief Paints rivers from a per-sample overlay (R8, one texel per sample, 0 off
+     *        the rivers, brighter for larger rivers), e.g. Hydrology's.
+     * @param texture Overlay texture, or 0 to disable it.
+     */
+    void setRiverOverlay(GLuint texture);
+
+    /**
+     * @brief Drapes a virtual texture (e.g. satellite imagery) over the ground in place
+     *        of the layer albedos. The caller keeps it alive and updates it per frame.
+     * @param colorMap Open virtual texture, or nullptr to disable it.
+     */
+    void setColorMap(const VirtualTexture* colorMap);
+
+    /**
+     * @brief Lights the terrain with a sun at the given time of day instead of the fixed
+     *        light. Self-shadowing comes from the sun horizon map, which is only baked
+     *        if the time of day is enabled before the terrain is loaded.
+     * @param hours Hour of the day (0 to 24), or a negative value for the fixed light.
+     */
+    void setTimeOfDay(float hours);
+    float getTimeOfDay() const;
+
+    /**
+     * @brief Unit direction toward the sun at the current time of day. The sun rises
+     *        along +x, passes +z at noon and sets along -x.
+     */
+    glm::vec3 getSunDirection() const;
 
     bool loadTexture(const std::string& textureFile);
+
+    /**
+     * @brief Encodes a terrain texture, with its daylight adjustments and mips, to a
+     *        block-compressed container next to the image (textureFile + ".bct") that
+     *        loadTexture() uploads in place of the image.
+     * @param textureFile Image loaded with loadTexture().
+     * @param format Block format to encode.
+     * @return True if successful, false otherwise.
+     */
+    static bool compressTexture(const std::string& textureFile, BlockFormat format);
+
+    /**
+     * @brief Loads the ground layer albedos into one texture array, in splat map
+     *        order: grass, rock, scree, snow. Images are resampled to a common size;
+     *        missing scree and snow layers are tinted copies of the last image.
+     * @param layerFiles One to four image files.
+     * @return True if every file loaded.
+     */
+    bool loadTextureLayers(const std::vector<std::string>& layerFiles);
 //    void generateTerrain(int size, float roughness);
     void diamondStep(int stepSize, float scale);
     void squareStep(int stepSize, float scale);
@@ -80,10 +315,28 @@ public:
 //    GLuint waterVAO, waterVBO; // Add for water plane
     float waterHeight;         // Height of the water plane
 
+    /**
+     * @brief Uploads the lake mesh found while loading and adds one water plane per lake.
+     *        Must be called on the render thread once the heights are available.
+     */
     void setupWaterPlane();
+    /**
+     * @brief Draws the visible water planes front to back in one multi-draw call.
+     */
     void renderWater(const glm::mat4& model, const glm::mat4& view,
                          const glm::mat4& projection, const glm::vec3& cameraPosition, Shader& waterShader);
+    /**
+     * @brief Adds a rectangular water plane, e.g. a tarn placed by hand.
+     * @param position Centre of the plane; only x and z are used.
+     * @param size Width and depth of the plane.
+     * @param height Height of the water surface.
+     */
     void addWaterPlane(const glm::vec3& position, const glm::vec2& size, float height);
+
+    /**
+     * @brief Number of water planes drawn in the last renderWater call.
+     */
+    size_t getVisibleWaterPlanes() const;
     
 
 
@@ -93,11 +346,25 @@ private:
     GLuint terrainVAO, terrainVBO, terrainEBO; ///< OpenGL objects.
     Shader* terrainShader;                      ///< Shader used for terrain rendering.
     GLuint textureID;
+    std::shared_ptr<Texture> sharedTexture;     ///< Holds textureID, shared with loads of the same image.
+    GLuint visibilityTexture;                   ///< Optional visibility tint, 0 if unused.
+    GLuint riverTexture;                        ///< Optional river overlay, 0 if unused.
+    const VirtualTexture* colorMap;             ///< Optional draped imagery, nullptr if unused.
+    GLuint occlusionTexture;                    ///< Baked sky visibility, one texel per sample.
+    GLuint analysisTexture;                     ///< Slope, aspect and curvature, one texel per sample.
+    GLuint splatTexture;                        ///< Ground layer weights, one texel per sample.
+    GLuint layerTexture;                        ///< Ground layer albedos, RGBA8 array.
+    std::shared_ptr<Texture> sharedLayers;      ///< Holds layerTexture, shared like sharedTexture.
+    GLuint sunHorizonTexture;                   ///< Sun horizon elevations, RGBA8 array.
+    float timeOfDay;                            ///< Hours, negative for the fixed light.
     float RandomFloatRange(float min, float max);
+    std::mt19937 noiseGenerator;                ///< Heightmap roughening, seeded from the image so loads repeat.
 
     int width, height;                         ///< Dimensions of the terrain.
     float heightScale;                         ///< Scaling factor for terrain height.
     float horizontalScale;                     ///< Scaling factor for terrain width and depth.
+    float surveyHeightScale;                   ///< True height of one height unit in horizontal units;
+                                               ///< not 1 when survey heights were rescaled for display.
     float minHeight; // Stores the minimum height value
     float maxHeight; // Stores the maximum height value
     ///<
@@ -110,12 +377,160 @@ private:
     std::vector<glm::vec3> normals;            ///< Vertex normals.
     std::vector<glm::vec2> texCoords;
     std::vector<GLuint> indices;               ///< Indices for rendering.
+    bool use16BitIndices;                      ///< Draw per chunk with 16-bit indices.
+    TerrainTopology topology;                  ///< Triangle list or strips.
+    bool gridUse16BitIndices;                  ///< Index layout requested for the regular grid.
+    TerrainTopology gridTopology;              ///< Topology requested for the regular grid.
+    int chunkSize;                             ///< Cells per chunk side in 16-bit mode.
+    int vertexCacheSize;                       ///< Cache size the index order targets.
+    int erosionDroplets;                       ///< Droplets of the erosion stage, 0 if off.
+    LakeDetector lakeDetector;                 ///< Lakes below waterHeight or in depressions.
+    std::vector<glm::vec3> waterVertices;      ///< Vertices of all water planes.
+    std::vector<GLuint> waterIndices;          ///< Triangles of all water planes, grouped per plane.
+    bool waterBuffersDirty;                    ///< Water geometry changed since the last upload.
+    std::vector<std::pair<float, size_t>> waterDrawOrder; ///< Visible planes by camera distance.
+    std::vector<GLsizei> waterDrawCounts;      ///< Per-frame multi-draw index counts.
+    std::vector<const void*> waterDrawOffsets; ///< Per-frame multi-draw index byte offsets.
+    size_t visibleWaterPlanes;                 ///< Planes drawn in the last frame.
+    ProceduralTerrain procedural;              ///< Height generator when proceduralSize > 0.
+    int proceduralSize;                        ///< Samples per side of procedural heights.
+    GLsizei terrainVertexCount;                ///< Vertices uploaded to the VBO.
+    std::vector<GLushort> chunkIndices;        ///< Local indices of all chunks.
+    std::vector<TerrainChunk> chunks;          ///< Chunk draw ranges.
+    float adaptiveMaxError;                    ///< RTIN error threshold, negative for the grid.
+    TerrainRTIN rtin;                          ///< Error hierarchy for adaptive meshes.
+    HeightPyramid heightPyramid;               ///< Min/max pyramid for ray casts.
+    HorizonAO horizonAO;                       ///< Baked sky visibility for ambient light.
+    SunHorizonMap sunHorizon;                  ///< Horizon per sun azimuth for shadows.
+    TerrainAnalysis analysis;                  ///< Slope, aspect and curvature grids.
+    SplatMap splatMap;                         ///< Ground layer weights from slope and altitude.
+    ImagePipeline texturePipeline;             ///< Daylight adjustment and mips of loaded textures.
+    std::vector<TerrainVertex> vertexData;     ///< Vertices waiting to be uploaded.
+    std::atomic<TerrainLoadState> loadState;   ///< Progress of the current load.
+    std::future<bool> pendingBuild;            ///< Background CPU stage.
+    GLuint stagingBuffer;                      ///< Staging buffer for streamed uploads.
+    size_t uploadedBytes;                      ///< Bytes of vertices + indices uploaded so far.
     ///<
    
     /**
      * @brief Sets up the VAO, VBO, and EBO for the terrain.
      */
     void setupTerrainVAO();
+
+    /**
+     * @brief CPU stage of a load: decodes the heightmap and builds heights, normals,
+     *        vertices and indices. Does not touch OpenGL.
+     * @param heightmapFile Path to the heightmap image.
+     * @param withSunHorizon Also bake the sun horizon map for time-of-day lighting.
+     * @return True if successful, false otherwise.
+     */
+    bool buildTerrainData(const std::string& heightmapFile, bool withSunHorizon);
+
+    /**
+     * @brief Decodes an 8-bit heightmap image and roughens it with noise and
+     *        diamond-square steps. The noise is seeded from the image bytes, so the
+     *        same image always gives the same heights and its bake caches stay valid.
+     * @param heightmapFile Path to the heightmap image.
+     * @return True if successful, false otherwise.
+     */
+    bool loadImageHeights(const std::string& heightmapFile);
+
+    /**
+     * @brief Reads a memory-mapped raw 16/32-bit or SRTM .hgt DEM at full precision.
+     *        Heights are rescaled to 0..heightScale for display; when the format implies
+     *        its sample spacing, the rescaling is recorded so the analysis uses true slopes.
+     * @param demFile Path to the DEM.
+     * @return True if successful, false otherwise.
+     */
+    bool loadDEMHeights(const std::string& demFile);
+
+    /**
+     * @brief Generates the heights with the procedural source, rows in parallel.
+     * @return True if successful, false otherwise.
+     */
+    bool loadProceduralHeights();
+
+    /**
+     * @brief Path of a bake cache for the current source. Procedural terrain gets its
+     *        own file per seed and size, so it never overwrites an image's cache.
+     * @param heightmapFile Path to the heightmap image or DEM.
+     * @param extension Extension of the bake, e.g. ".ao".
+     * @return Cache file path.
+     */
+    std::string bakeCachePath(const std::string& heightmapFile, const std::string& extension) const;
+
+    /**
+     * @brief Appends a mesh to the water geometry as one water plane.
+     * @param vertices World-space vertices.
+     * @param indices Triangles, relative to the first vertex.
+     * @param boundsMin Smallest corner of the plane in x and z.
+     * @param boundsMax Largest corner of the plane in x and z.
+     * @param height Height of the water surface.
+     */
+    void appendWaterMesh(const std::vector<glm::vec3>& vertices, const std::vector<GLuint>& indices,
+                         const glm::vec2& boundsMin, const glm::vec2& boundsMax, float height);
+
+    /**
+     * @brief Uploads the water geometry if it changed.
+     */
+    void uploadWaterBuffers();
+
+    /**
+     * @brief Builds the interleaved vertices and indices from positions and normals.
+     */
+    void buildMeshData();
+
+    /**
+     * @brief Replaces the contents of the live VBO and EBO with the current mesh data.
+     */
+    void reuploadMeshData();
+
+    /**
+     * @brief Creates the VAO, VBO and EBO.
+     * @param streamed Allocate empty buffers for uploadTerrainSlice instead of uploading.
+     */
+    void createTerrainBuffers(bool streamed);
+
+    /**
+     * @brief Uploads the baked sky visibility (R8) and sun horizons (RGBA8 array).
+     */
+    void createLightingTextures();
+
+    /**
+     * @brief Sun azimuth (x/z plane, from +x toward +z) and elevation in radians.
+     */
+    void getSunAngles(float& azimuth, float& elevation) const;
+
+    /**
+     * @brief Uploads the next slice of vertices/indices through the staging buffer.
+     * @param maxBytes Upload budget for this call.
+     * @return True when everything has been uploaded.
+     */
+    bool uploadTerrainSlice(size_t maxBytes);
+
+    /**
+     * @brief Size in bytes of the index buffer.
+     */
+    size_t indexDataSize() const;
+
+    /**
+     * @brief Frees the CPU copy of the vertex data once it is on the GPU.
+     */
+    void releaseMeshData();
+
+    /**
+     * @brief Appends the indices of a grid block in the current topology and order.
+     * @param columns Number of vertices per row.
+     * @param rows Number of vertex rows.
+     * @param restart Primitive restart index for strips.
+     * @param out Index buffer to append to.
+     */
+    void appendTerrainIndices(int columns, int rows, GLuint restart, std::vector<GLuint>& out) const;
+
+    /**
+     * @brief Primitive restart index for the current index type.
+     */
+    GLuint restartIndex() const;
     
         
     /**
@@ -0,0 +1,108 @@
+#include "terrainAnalysis.h"
+#include "horizonAO.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const float kSlopeUnits = 65535.0f / 90.0f;              // Quantisation steps per degree
+const float kAspectUnits = 256.0f / 6.28318530718f;      // Quantisation steps per radian
+const float kCurvatureScale = 1024.0f;                   // Stored steps per 1 / world unit
+const float kTexelCurvature = 4.0f;                      // Curvature that saturates the texture
+const float kRadiansToDegrees = 57.2957795131f;
+}
+
+TerrainAnalysis::TerrainAnalysis() : width(0), height(0), horizontalScale(1.0f) {}
+
+void TerrainAnalysis::build(const std::vector<float>& heights, int newWidth, int newHeight, float scale,
+                            float verticalScale) {
+    width = newWidth;
+    height = newHeight;
+    horizontalScale = scale;
+    size_t count = static_cast<size_t>(width) * height;
+    if (width < 1 || height < 1 || heights.size() < count) {
+        width = height = 0;
+        slopes.clear();
+        aspects.clear();
+        curvatures.clear();
+        return;
+    }
+    slopes.resize(count);
+    aspects.resize(count);
+    curvatures.resize(count);
+
+    const int stride = width + 2;
+    std::vector<float> padded = padHeightGrid(heights, width, height, 1);
+    const float gradientScale = verticalScale / (8.0f * scale);
+    const float laplacianScale = kCurvatureScale * verticalScale / (scale * scale);
+
+    ThreadPool::getInstance().parallelFor(0, height, [&](int z) {
+        // Rows above, at and below z, offset so index x is the sample itself
+        const float* up = padded.data() + static_cast<size_t>(z) * stride + 1;
+        const float* mid = up + stride;
+        const float* down = mid + stride;
+        std::vector<float> gradientX(width), gradientZ(width);
+        uint16_t* slopeRow = slopes.data() + static_cast<size_t>(z) * width;
+        uint8_t* aspectRow = aspects.data() + static_cast<size_t>(z) * width;
+        int16_t* curvatureRow = curvatures.data() + static_cast<size_t>(z) * width;
+
+        for (int x = 0; x < width; ++x) {
+            gradientX[x] = ((up[x + 1] + 2.0f * mid[x + 1] + down[x + 1]) -
+                            (up[x - 1] + 2.0f * mid[x - 1] + down[x - 1])) * gradientScale;
+            gradientZ[x] = ((down[x - 1] + 2.0f * down[x] + down[x + 1]) -
+                            (up[x - 1] + 2.0f * up[x] + up[x + 1])) * gradientScale;
+            float laplacian = (mid[x - 1] + mid[x + 1] + up[x] + down[x] - 4.0f * mid[x]) * laplacianScale;
+            curvatureRow[x] = static_cast<int16_t>(std::clamp(laplacian, -32767.0f, 32767.0f));
+        }
+        for (int x = 0; x < width; ++x) {
+            float steepness = std::sqrt(gradientX[x] * gradientX[x] + gradientZ[x] * gradientZ[x]);
+            slopeRow[x] = static_cast<uint16_t>(std::atan(steepness) * kRadiansToDegrees * kSlopeUnits + 0.5f);
+            // Downhill is against the gradient; 256 steps wrap to 0
+            float aspect = std::atan2(-gradientX[x], -gradientZ[x]);
+            aspectRow[x] = static_cast<uint8_t>(static_cast<int>(std::lround(aspect * kAspectUnits)) & 0xFF);
+        }
+    });
+}
+
+bool TerrainAnalysis::isBuilt() const {
+    return width > 0;
+}
+
+int TerrainAnalysis::getWidth() const {
+    return width;
+}
+
+int TerrainAnalysis::getHeight() const {
+    return height;
+}
+
+float TerrainAnalysis::getSlope(int x, int z) const {
+    return slopes[static_cast<size_t>(z) * width + x] / kSlopeUnits;
+}
+
+float TerrainAnalysis::getAspect(int x, int z) const {
+    return aspects[static_cast<size_t>(z) * width + x] / kAspectUnits;
+}
+
+float TerrainAnalysis::getCurvature(int x, int z) const {
+    return curvatures[static_cast<size_t>(z) * width + x] / kCurvatureScale;
+}
+
+float TerrainAnalysis::getSlopeAtPosition(float worldX, float worldZ) const {
+    if (!isBuilt()) return 0.0f;
+    int x = static_cast<int>(std::lround(worldX / horizontalScale + (width - 1) * 0.5f));
+    int z = static_cast<int>(std::lround(worldZ / horizontalScale + (height - 1) * 0.5f));
+    return getSlope(std::clamp(x, 0, width - 1), std::clamp(z, 0, height - 1));
+}
+
+std::vector<unsigned char> TerrainAnalysis::packTexels() const {
+    std::vector<unsigned char> texels(static_cast<size_t>(width) * height * 4);
+    const float curvatureToTexel = 127.5f / (kTexelCurvature * kCurvatureScale);
+    for (size_t i = 0; i < slopes.size(); ++i) {
+        texels[i * 4 + 0] = static_cast<unsigned char>(slopes[i] >> 8);
+        texels[i * 4 + 1] = aspects[i];
+        texels[i * 4 + 2] = static_cast<unsigned char>(std::clamp(127.5f + curvatures[i] * curvatureToTexel, 0.0f, 255.0f));
+        texels[i * 4 + 3] = 255;
+    }
+    return texels;
+}
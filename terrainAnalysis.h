@@ -0,0 +1,73 @@
+#ifndef TERRAIN_ANALYSIS_H
+#define TERRAIN_ANALYSIS_H
+
+#include <vector>
+#include <cstdint>
+
+/**
+ * @class TerrainAnalysis
+ * @brief Slope, aspect and curvature of every sample of a height grid.
+ *
+ * Gradients use Horn's 3 x 3 kernel and curvature the 5-point Laplacian, evaluated a
+ * row at a time over an edge-padded copy of the grid so the inner loops have no
+ * bounds checks and vectorise; rows run in parallel on the thread pool. The grids
+ * share the row-major layout of the heights and are quantised: slope to 16 bits,
+ * aspect to 8 bits and curvature to signed 16 bits.
+ */
+class TerrainAnalysis {
+public:
+    TerrainAnalysis();
+
+    /**
+     * @brief Computes the grids.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     * @param verticalScale True height of one height unit in world distance units, for
+     *        heights that were rescaled for display (such as survey DEMs).
+     */
+    void build(const std::vector<float>& heights, int width, int height, float horizontalScale,
+               float verticalScale = 1.0f);
+
+    bool isBuilt() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * @brief Slope of a sample in degrees, 0 (flat) to 90.
+     */
+    float getSlope(int x, int z) const;
+
+    /**
+     * @brief Direction the sample faces downhill in radians, clockwise from +z
+     *        (0 faces +z, pi / 2 faces +x). Meaningless on flat ground.
+     */
+    float getAspect(int x, int z) const;
+
+    /**
+     * @brief Laplacian of the true heights in 1 / world units: positive in hollows and
+     *        valleys, negative on ridges and summits.
+     */
+    float getCurvature(int x, int z) const;
+
+    /**
+     * @brief Slope in degrees at the sample nearest to a world position.
+     */
+    float getSlopeAtPosition(float worldX, float worldZ) const;
+
+    /**
+     * @brief Packs the grids into RGBA8 texels for shading: slope / 90 degrees,
+     *        aspect / 2 pi, curvature mapped around 0.5, and 255.
+     */
+    std::vector<unsigned char> packTexels() const;
+
+private:
+    int width, height;
+    float horizontalScale;
+    std::vector<uint16_t> slopes;      ///< Slope, 65535 = 90 degrees.
+    std::vector<uint8_t> aspects;      ///< Aspect, 256 steps per turn.
+    std::vector<int16_t> curvatures;   ///< Curvature times kCurvatureScale.
+};
+
+#endif // TERRAIN_ANALYSIS_H
@@ -0,0 +1,166 @@
+#include "terrainMesh.h"
+#include <algorithm>
+
+int vertexCacheBandWidth(int cacheSize) {
+    return std::max(1, cacheSize / 2 - 1);
+}
+
+void appendGridTriangles(int columns, int rows, int bandWidth, std::vector<GLuint>& out) {
+    int cellColumns = columns - 1;
+    int cellRows = rows - 1;
+    if (cellColumns <= 0 || cellRows <= 0) return;
+    if (bandWidth <= 0 || bandWidth > cellColumns) bandWidth = cellColumns;
+
+    out.reserve(out.size() + static_cast<size_t>(cellColumns) * cellRows * 6);
+    for (int bandStart = 0; bandStart < cellColumns; bandStart += bandWidth) {
+        int bandEnd = std::min(bandStart + bandWidth, cellColumns);
+        for (int z = 0; z < cellRows; ++z) {
+            for (int x = bandStart; x < bandEnd; ++x) {
+                GLuint i0 = z * columns + x;
+                GLuint i1 = z * columns + x + 1;
+                GLuint i2 = (z + 1) * columns + x;
+                GLuint i3 = (z + 1) * columns + x + 1;
+
+                // First triangle
+                out.push_back(i0);
+                out.push_back(i1);
+                out.push_back(i2);
+
+                // Second triangle
+                out.push_back(i1);
+                out.push_back(i3);
+                out.push_back(i2);
+            }
+        }
+    }
+}
+
+void appendGridStrips(int columns, int rows, int bandWidth, GLuint restartIndex, std::vector<GLuint>& out) {
+    int cellColumns = columns - 1;
+    int cellRows = rows - 1;
+    if (cellColumns <= 0 || cellRows <= 0) return;
+    if (bandWidth <= 0 || bandWidth > cellColumns) bandWidth = cellColumns;
+
+    int bands = (cellColumns + bandWidth - 1) / bandWidth;
+    out.reserve(out.size() + static_cast<size_t>(cellRows) * (2 * (cellColumns + bands) + 2 * bands));
+    for (int bandStart = 0; bandStart < cellColumns; bandStart += bandWidth) {
+        int bandEnd = std::min(bandStart + bandWidth, cellColumns);
+        for (int z = 0; z < cellRows; ++z) {
+            // Leading duplicate flips the strip parity to match the list winding
+            out.push_back(z * columns + bandStart);
+            for (int x = bandStart; x <= bandEnd; ++x) {
+                out.push_back(z * columns + x);
+                out.push_back((z + 1) * columns + x);
+            }
+            out.push_back(restartIndex);
+        }
+    }
+}
+
+void appendGridChunks(int columns, int rows, int chunkSize, int bandWidth, TerrainTopology topology,
+                      std::vector<GLushort>& out, std::vector<TerrainChunk>& chunks) {
+    if (chunkSize <= 0) return;
+    GLint baseVertex = chunks.empty() ? 0 : chunks.back().baseVertex + chunks.back().columns * chunks.back().rows;
+    std::vector<GLuint> localIndices;
+    for (int z0 = 0; z0 < rows - 1; z0 += chunkSize) {
+        for (int x0 = 0; x0 < columns - 1; x0 += chunkSize) {
+            TerrainChunk chunk;
+            chunk.firstColumn = x0;
+            chunk.firstRow = z0;
+            chunk.columns = std::min(chunkSize, columns - 1 - x0) + 1;
+            chunk.rows = std::min(chunkSize, rows - 1 - z0) + 1;
+            chunk.baseVertex = baseVertex;
+            chunk.indexOffset = out.size() * sizeof(GLushort);
+
+            localIndices.clear();
+            if (topology == TerrainTopology::TRIANGLE_STRIP) {
+                appendGridStrips(chunk.columns, chunk.rows, bandWidth, 0xFFFFu, localIndices);
+            } else {
+                appendGridTriangles(chunk.columns, chunk.rows, bandWidth, localIndices);
+            }
+            out.insert(out.end(), localIndices.begin(), localIndices.end());
+            chunk.indexCount = static_cast<GLsizei>(localIndices.size());
+            chunks.push_back(chunk);
+            baseVertex += chunk.columns * chunk.rows;
+        }
+    }
+}
+
+void expandTriangleStrips(const std::vector<GLuint>& strips, GLuint restartIndex, std::vector<GLuint>& out) {
+    size_t stripStart = 0;
+    for (size_t i = 0; i <= strips.size(); ++i) {
+        if (i < strips.size() && strips[i] != restartIndex) continue;
+
+        // Triangle k of a strip is (k, k+1, k+2), with the first two swapped when k is odd
+        for (size_t k = stripStart; k + 2 < i; ++k) {
+            GLuint a = strips[k], b = strips[k + 1], c = strips[k + 2];
+            if ((k - stripStart) % 2 == 1) std::swap(a, b);
+            if (a == b || b == c || a == c) continue;
+            out.push_back(a);
+            out.push_back(b);
+            out.push_back(c);
+        }
+        stripStart = i + 1;
+    }
+}
+
+bool stripsMatchTriangles(const std::vector<GLuint>& triangles, const std::vector<GLuint>& strips, GLuint restartIndex) {
+    struct Triangle {
+        GLuint v[3];
+        bool operator<(const Triangle& other) const {
+            return std::lexicographical_compare(v, v + 3, other.v, other.v + 3);
+        }
+        bool operator==(const Triangle& other) const {
+            return std::equal(v, v + 3, other.v);
+        }
+    };
+
+    // Rotate each triangle so its smallest index comes first; rotation keeps the winding
+    auto canonical = [](const std::vector<GLuint>& list) {
+        std::vector<Triangle> result;
+        result.reserve(list.size() / 3);
+        for (size_t i = 0; i + 2 < list.size(); i += 3) {
+            Triangle t = { { list[i], list[i + 1], list[i + 2] } };
+            std::rotate(t.v, std::min_element(t.v, t.v + 3), t.v + 3);
+            result.push_back(t);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    std::vector<GLuint> expanded;
+    expandTriangleStrips(strips, restartIndex, expanded);
+    return canonical(triangles) == canonical(expanded);
+}
+
+VertexCacheStats simulateVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize,
+                                     TerrainTopology topology, GLuint restartIndex) {
+    VertexCacheStats stats;
+    if (indices.empty() || vertexCount == 0 || cacheSize <= 0) return stats;
+
+    // A vertex is resident while fewer than cacheSize misses happened since it was inserted.
+    const size_t notCached = static_cast<size_t>(-1);
+    std::vector<size_t> insertedAt(vertexCount, notCached);
+
+    for (GLuint index : indices) {
+        if (index >= vertexCount) continue; // Primitive restart
+        size_t& stamp = insertedAt[index];
+        if (stamp == notCached) {
+            stats.uniqueVertices++;
+        } else if (stats.transforms - stamp < static_cast<size_t>(cacheSize)) {
+            continue; // Cache hit
+        }
+        stamp = stats.transforms++;
+    }
+
+    if (topology == TerrainTopology::TRIANGLE_STRIP) {
+        std::vector<GLuint> expanded;
+        expandTriangleStrips(indices, restartIndex, expanded);
+        stats.triangles = expanded.size() / 3;
+    } else {
+        stats.triangles = indices.size() / 3;
+    }
+    stats.acmr = stats.triangles ? static_cast<float>(stats.transforms) / stats.triangles : 0.0f;
+    stats.atvr = stats.uniqueVertices ? static_cast<float>(stats.transforms) / stats.uniqueVertices : 0.0f;
+    return stats;
+}
@@ -0,0 +1,124 @@
+#ifndef TERRAIN_MESH_H
+#define TERRAIN_MESH_H
+
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+
+/**
+ * @brief Primitive layout of the terrain index buffer.
+ */
+enum class TerrainTopology {
+    TRIANGLES,       ///< Independent triangles, 6 indices per cell.
+    TRIANGLE_STRIP   ///< One strip per row of a band, joined with primitive restart.
+};
+
+/**
+ * @brief Post-transform vertex cache statistics for an index buffer.
+ */
+struct VertexCacheStats {
+    size_t triangles = 0;       ///< Number of triangles in the index buffer.
+    size_t transforms = 0;      ///< Vertex shader invocations (cache misses).
+    size_t uniqueVertices = 0;  ///< Distinct vertices referenced by the index buffer.
+    float acmr = 0.0f;          ///< Average cache miss ratio (transforms per triangle).
+    float atvr = 0.0f;          ///< Average transform to vertex ratio (transforms per unique vertex).
+};
+
+/**
+ * @brief A block of the terrain grid with its own vertices, drawn with 16-bit indices.
+ */
+struct TerrainChunk {
+    GLint baseVertex;     ///< Index of the chunk's first vertex in the terrain VBO.
+    GLsizei indexCount;   ///< Number of indices in the chunk.
+    size_t indexOffset;   ///< Byte offset of the chunk's first index in the terrain EBO.
+    int firstColumn;      ///< Grid column of the chunk's first vertex.
+    int firstRow;         ///< Grid row of the chunk's first vertex.
+    int columns;          ///< Vertices per chunk row.
+    int rows;             ///< Vertex rows in the chunk.
+};
+
+/**
+ * @brief Returns the column band width that keeps a band row resident in a FIFO cache.
+ *
+ * A band of N cells touches N + 1 vertices per row; the previous row must survive
+ * the N + 1 new vertices of the next one, so N = cacheSize / 2 - 1.
+ * @param cacheSize Number of entries in the simulated post-transform cache.
+ */
+int vertexCacheBandWidth(int cacheSize);
+
+/**
+ * @brief Appends the triangle list for a grid of vertices.
+ *
+ * Cells are emitted in vertical bands of @p bandWidth columns, row by row inside each
+ * band, so the vertices shared with the previous row are still in the post-transform
+ * cache. A band width of 0 emits the whole row (the original row-major order).
+ * @param columns Number of vertices per row.
+ * @param rows Number of vertex rows.
+ * @param bandWidth Number of cells per band, or 0 for full rows.
+ * @param out Index buffer to append to.
+ */
+void appendGridTriangles(int columns, int rows, int bandWidth, std::vector<GLuint>& out);
+
+/**
+ * @brief Appends triangle strips covering the same triangles as appendGridTriangles.
+ *
+ * Each row of a band is one strip terminated by @p restartIndex. The first vertex of
+ * every strip is repeated so the strip's parity reproduces the list's winding and
+ * diagonal exactly.
+ * @param columns Number of vertices per row.
+ * @param rows Number of vertex rows.
+ * @param bandWidth Number of cells per band, or 0 for full rows.
+ * @param restartIndex Primitive restart index separating the strips.
+ * @param out Index buffer to append to.
+ */
+void appendGridStrips(int columns, int rows, int bandWidth, GLuint restartIndex, std::vector<GLuint>& out);
+
+/**
+ * @brief Splits a grid into chunks with their own vertices and appends their 16-bit indices.
+ *
+ * Chunks of up to @p chunkSize cells per side are laid out row by row. Each chunk's
+ * vertices are the block of the grid it covers, stored row-major after those of the
+ * previous chunk, so shared edges are duplicated and local indices fit in 16 bits.
+ * @param columns Number of vertices per grid row.
+ * @param rows Number of vertex rows in the grid.
+ * @param chunkSize Cells per chunk side; at most 254 so a chunk stays below the restart index.
+ * @param bandWidth Number of cells per band inside a chunk, or 0 for full rows.
+ * @param topology Triangle list, or strips separated by the 16-bit restart index 0xFFFF.
+ * @param out Chunk indices to append to.
+ * @param chunks Chunk draw ranges to append to; baseVertex counts the vertices of earlier chunks.
+ */
+void appendGridChunks(int columns, int rows, int chunkSize, int bandWidth, TerrainTopology topology,
+                      std::vector<GLushort>& out, std::vector<TerrainChunk>& chunks);
+
+/**
+ * @brief Expands triangle strips into a triangle list, dropping degenerate triangles.
+ * @param strips Strip indices separated by @p restartIndex.
+ * @param restartIndex Primitive restart index.
+ * @param out Triangle list to append to.
+ */
+void expandTriangleStrips(const std::vector<GLuint>& strips, GLuint restartIndex, std::vector<GLuint>& out);
+
+/**
+ * @brief Checks that a strip mesh covers exactly the triangles of a list mesh,
+ *        with the same winding.
+ * @param triangles Triangle list indices.
+ * @param strips Strip indices separated by @p restartIndex.
+ * @param restartIndex Primitive restart index.
+ * @return True if both meshes contain the same set of oriented triangles.
+ */
+bool stripsMatchTriangles(const std::vector<GLuint>& triangles, const std::vector<GLuint>& strips, GLuint restartIndex);
+
+/**
+ * @brief Simulates a FIFO post-transform cache over an index buffer.
+ * @param indices Triangle list, or strips separated by @p restartIndex.
+ * @param vertexCount Number of vertices addressed by the indices.
+ * @param cacheSize Number of cache entries.
+ * @param topology Primitive layout of @p indices.
+ * @param restartIndex Primitive restart index for strips.
+ * @return ACMR/ATVR statistics for the index buffer.
+ */
+VertexCacheStats simulateVertexCache(const std::vector<GLuint>& indices, size_t vertexCount, int cacheSize,
+                                     TerrainTopology topology = TerrainTopology::TRIANGLES,
+                                     GLuint restartIndex = 0xFFFFFFFFu);
+
+#endif // TERRAIN_MESH_H
@@ -0,0 +1,119 @@
+#include "test.h"
+#include "assetArchive.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace {
+void writeFile(const std::string& path, const std::vector<unsigned char>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+/// Repetitive text that LZ4 shrinks, like a shader
+std::vector<unsigned char> makeText() {
+    std::string text;
+    for (int i = 0; i < 400; ++i) {
+        text += "uniform sampler2D layer" + std::to_string(i % 7) + "; // sampled once per fragment\n";
+    }
+    return std::vector<unsigned char>(text.begin(), text.end());
+}
+
+/// Noise that LZ4 cannot shrink, like a raw DEM
+std::vector<unsigned char> makeNoise(size_t size) {
+    std::vector<unsigned char> bytes(size);
+    uint32_t state = 12345;
+    for (unsigned char& byte : bytes) {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<unsigned char>(state >> 24);
+    }
+    return bytes;
+}
+}
+
+TEST_CASE(archiveRoundTrip) {
+    std::vector<unsigned char> text = makeText(), noise = makeNoise(10000), empty;
+    writeFile("archiveTest.glsl", text);
+    writeFile("archiveTest.r16", noise);
+    writeFile("archiveTest.txt", empty);
+
+    std::vector<ArchiveSource> sources(3);
+    sources[0].name = "shaders/test.glsl";
+    sources[0].file = "archiveTest.glsl";
+    sources[0].compress = true;
+    sources[1].name = "resources/test.r16";
+    sources[1].file = "archiveTest.r16";
+    sources[1].alignment = 4096;
+    sources[2].name = "resources/empty.txt";
+    sources[2].file = "archiveTest.txt";
+    sources[2].compress = true;
+    CHECK(AssetArchive::pack(sources, "archiveTest.pack"));
+
+    AssetArchive archive;
+    CHECK(archive.open("archiveTest.pack"));
+    CHECK(archive.getEntryCount() == 3);
+    CHECK(archive.find("shaders/missing.glsl") == nullptr);
+
+    // Text is stored as an LZ4 block smaller than the file and decompresses exactly
+    const ArchiveEntry* shader = archive.find("shaders/test.glsl");
+    CHECK(shader != nullptr);
+    if (shader) {
+        CHECK(shader->compressed);
+        CHECK(shader->size == text.size());
+        CHECK(shader->storedSize < text.size());
+        std::vector<unsigned char> decompressed;
+        CHECK(archive.decompress(*shader, decompressed));
+        CHECK(decompressed == text);
+    }
+
+    // Binaries are stored as they are, on their alignment, and read in place
+    const ArchiveEntry* raw = archive.find("resources/test.r16");
+    CHECK(raw != nullptr);
+    if (raw) {
+        CHECK(!raw->compressed);
+        CHECK(raw->size == noise.size() && raw->storedSize == noise.size());
+        CHECK(raw->offset % 4096 == 0);
+        const unsigned char* stored = archive.storedData(*raw);
+        CHECK(stored != nullptr && std::vector<unsigned char>(stored, stored + raw->size) == noise);
+    }
+
+    const ArchiveEntry* none = archive.find("resources/empty.txt");
+    CHECK(none != nullptr && none->size == 0);
+    archive.close();
+
+    std::remove("archiveTest.glsl");
+    std::remove("archiveTest.r16");
+    std::remove("archiveTest.txt");
+    std::remove("archiveTest.pack");
+}
+
+TEST_CASE(archiveRejectsDamage) {
+    std::vector<unsigned char> text = makeText();
+    writeFile("archiveTest.glsl", text);
+    std::vector<ArchiveSource> sources(1);
+    sources[0].name = "shaders/test.glsl";
+    sources[0].file = "archiveTest.glsl";
+    sources[0].compress = true;
+    CHECK(AssetArchive::pack(sources, "archiveTest.pack"));
+
+    std::ifstream in("archiveTest.pack", std::ios::binary);
+    std::vector<unsigned char> packed((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // Cut into the table of contents
+    writeFile("archiveTest.pack", std::vector<unsigned char>(packed.begin(), packed.end() - 4));
+    AssetArchive archive;
+    CHECK(!archive.open("archiveTest.pack"));
+
+    // Wrong tag
+    std::vector<unsigned char> retagged = packed;
+    retagged[0] ^= 0xFF;
+    writeFile("archiveTest.pack", retagged);
+    CHECK(!archive.open("archiveTest.pack"));
+
+    CHECK(!archive.open("archiveTest.missing"));
+
+    std::remove("archiveTest.glsl");
+    std::remove("archiveTest.pack");
+}
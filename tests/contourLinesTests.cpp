@@ -0,0 +1,69 @@
+#include "test.h"
+#include "contourLines.h"
+#include <cmath>
+
+namespace {
+const int kSize = 201;              // Several 64-cell tiles, so lines cross tile borders
+const float kCentre = 100.0f;
+
+/// A cone rising 1 unit per sample from the centre; its contours are circles
+std::vector<float> makeCone() {
+    std::vector<float> heights(static_cast<size_t>(kSize) * kSize);
+    for (int z = 0; z < kSize; ++z) {
+        for (int x = 0; x < kSize; ++x) {
+            heights[static_cast<size_t>(z) * kSize + x] = std::hypot(x - kCentre, z - kCentre);
+        }
+    }
+    return heights;
+}
+
+/// Checks every line of a group and counts the closed ones
+int checkLines(const ContourSet& lines, const std::vector<GLint>& first, const std::vector<GLsizei>& counts) {
+    int closed = 0;
+    for (size_t line = 0; line < first.size(); ++line) {
+        CHECK(counts[line] >= 2);
+        const glm::vec3& start = lines.vertices[first[line]];
+        const glm::vec3& end = lines.vertices[first[line] + counts[line] - 1];
+        for (GLsizei v = 0; v < counts[line]; ++v) {
+            const glm::vec3& vertex = lines.vertices[first[line] + v];
+            // One height per line, and every vertex on the circle of that height
+            CHECK(vertex.y == start.y);
+            float radius = std::hypot(vertex.x, vertex.z);
+            CHECK(std::fabs(radius - (vertex.y - 0.2f)) < 0.1f);
+        }
+        if (start.x == end.x && start.z == end.z) ++closed;
+    }
+    return closed;
+}
+}
+
+TEST_CASE(marchingSquaresCircles) {
+    std::vector<float> heights = makeCone();
+    ContourLines contours;
+    contours.setHeightGrid(&heights, kSize, kSize, 1.0f);
+    contours.setMajorEvery(5);
+
+    ContourSet lines;
+    contours.generate(10.0f, lines);
+    CHECK(lines.minorFirst.size() == lines.minorCounts.size());
+    CHECK(lines.majorFirst.size() == lines.majorCounts.size());
+    int closed = checkLines(lines, lines.minorFirst, lines.minorCounts) +
+                 checkLines(lines, lines.majorFirst, lines.majorCounts);
+
+    // Circles of radius 10 to 100 fit the grid and join into one closed loop each,
+    // across tiles; 110 to 140 are cut by the border into open arcs
+    CHECK(closed == 10);
+    CHECK(lines.minorCounts.size() + lines.majorCounts.size() == 10 + 4 * 4);
+    // 50 and 100 are major, every fifth level
+    CHECK(lines.majorCounts.size() == 2);
+}
+
+TEST_CASE(marchingSquaresFlat) {
+    // A flat grid lies between levels and has no lines
+    std::vector<float> heights(static_cast<size_t>(kSize) * kSize, 12.5f);
+    ContourLines contours;
+    contours.setHeightGrid(&heights, kSize, kSize, 1.0f);
+    ContourSet lines;
+    contours.generate(5.0f, lines);
+    CHECK(lines.vertices.empty());
+}
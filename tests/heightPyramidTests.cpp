@@ -0,0 +1,158 @@
+#include "test.h"
+#include "heightPyramid.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+const int kSize = 33;
+const float kStep = 1e-3f;        // Brute-force march step along the (unit) ray
+const float kTolerance = 2e-3f;   // Allowed disagreement, a couple of march steps
+
+/**
+ * @brief Height of the triangulated grid at (x, z), split along u + v = 1 like the
+ *        terrain mesh. Coordinates must lie on the grid.
+ */
+float surfaceAt(const std::vector<float>& heights, float x, float z) {
+    int cx = std::min(static_cast<int>(x), kSize - 2);
+    int cz = std::min(static_cast<int>(z), kSize - 2);
+    float u = x - cx, v = z - cz;
+    float h00 = heights[cz * kSize + cx], h10 = heights[cz * kSize + cx + 1];
+    float h01 = heights[(cz + 1) * kSize + cx], h11 = heights[(cz + 1) * kSize + cx + 1];
+    return u + v <= 1.0f ? h00 + (h10 - h00) * u + (h01 - h00) * v
+                         : h11 + (h01 - h11) * (1.0f - u) + (h10 - h11) * (1.0f - v);
+}
+
+bool onGrid(const glm::vec3& p) {
+    const float last = static_cast<float>(kSize - 1);
+    return p.x >= 0.0f && p.z >= 0.0f && p.x <= last && p.z <= last;
+}
+
+/**
+ * @brief Marches a unit ray in small steps and refines the first step that ends below
+ *        the surface by bisection. Also reports the smallest clearance above the surface
+ *        before the hit (or along the whole ray), to recognise grazing rays.
+ */
+bool marchRay(const std::vector<float>& heights, const glm::vec3& origin, const glm::vec3& direction,
+              float maxT, float& tHit, float& clearance) {
+    clearance = INFINITY;
+    float previous = -1.0f;
+    for (float t = 0.0f; t <= maxT; t += kStep) {
+        glm::vec3 p = origin + direction * t;
+        if (!onGrid(p)) {
+            previous = -1.0f;
+            continue;
+        }
+        float above = p.y - surfaceAt(heights, p.x, p.z);
+        if (above <= 0.0f) {
+            float low = previous < 0.0f ? t : previous, high = t;
+            for (int i = 0; i < 30 && previous >= 0.0f; ++i) {
+                float middle = 0.5f * (low + high);
+                glm::vec3 q = origin + direction * middle;
+                (q.y - surfaceAt(heights, q.x, q.z) <= 0.0f ? high : low) = middle;
+            }
+            tHit = high;
+            return true;
+        }
+        clearance = std::min(clearance, above);
+        previous = t;
+    }
+    return false;
+}
+
+/**
+ * @brief Casts one ray through the pyramid and checks it against the march.
+ */
+void checkRay(const HeightPyramid& pyramid, const std::vector<float>& heights, const glm::vec3& origin,
+              glm::vec3 direction) {
+    direction = glm::normalize(direction);
+    const float maxT = 80.0f;
+    float tPyramid = 0.0f, tMarch = 0.0f, clearance = 0.0f;
+    bool hitPyramid = pyramid.intersect(origin, direction, maxT, tPyramid);
+    bool hitMarch = marchRay(heights, origin, direction, maxT, tMarch, clearance);
+    if (hitPyramid != hitMarch) {
+        // Only a ray that just touches the surface may be decided either way
+        CHECK(clearance < kTolerance);
+        return;
+    }
+    if (!hitPyramid) return;
+    // The hit is on the grid and not above the surface (below it only for rays that
+    // reach the grid underground), no later than the march found it, and earlier only
+    // where the march stepped over a graze
+    glm::vec3 p = origin + direction * tPyramid;
+    glm::vec3 clamped = glm::clamp(p, glm::vec3(0.0f, p.y, 0.0f), glm::vec3(kSize - 1.0f, p.y, kSize - 1.0f));
+    CHECK(glm::length(p - clamped) < kTolerance);
+    CHECK(clamped.y - surfaceAt(heights, clamped.x, clamped.z) < kTolerance);
+    CHECK(tPyramid <= tMarch + kTolerance);
+    if (tPyramid < tMarch - kTolerance) {
+        CHECK(clearance < kTolerance);
+    }
+}
+
+std::vector<float> makeRandomGrid(std::mt19937& random) {
+    std::uniform_real_distribution<float> heightDistribution(0.0f, 10.0f);
+    std::vector<float> heights(static_cast<size_t>(kSize) * kSize);
+    for (float& value : heights) value = heightDistribution(random);
+    return heights;
+}
+}
+
+TEST_CASE(raycastMatchesMarch) {
+    std::mt19937 random(20241);
+    std::vector<float> heights = makeRandomGrid(random);
+    HeightPyramid pyramid;
+    pyramid.build(heights, kSize, kSize);
+    CHECK(pyramid.isBuilt());
+
+    std::uniform_real_distribution<float> position(-8.0f, kSize + 8.0f);
+    std::uniform_real_distribution<float> altitude(0.0f, 20.0f);
+    std::uniform_real_distribution<float> heading(-1.0f, 1.0f);
+    for (int ray = 0; ray < 300; ++ray) {
+        glm::vec3 origin(position(random), altitude(random), position(random));
+        glm::vec3 direction(heading(random), heading(random) * 0.5f, heading(random));
+        if (glm::length(direction) < 1e-3f) continue;
+        checkRay(pyramid, heights, origin, direction);
+    }
+    // Straight down onto cell interiors, edges and corners
+    for (float x : { 0.0f, 3.5f, 7.0f, 12.25f, 32.0f }) {
+        checkRay(pyramid, heights, glm::vec3(x, 15.0f, 5.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    }
+}
+
+TEST_CASE(raycastGrazesDiagonal) {
+    std::mt19937 random(77);
+    std::vector<float> heights = makeRandomGrid(random);
+    HeightPyramid pyramid;
+    pyramid.build(heights, kSize, kSize);
+
+    // Rays running along the cell diagonals (x + z constant), exactly on them and just
+    // beside them, descending slowly so they skim the shared triangle edges
+    for (int line = 2; line < 2 * (kSize - 1) - 2; line += 3) {
+        for (float offset : { 0.0f, 1e-4f, -1e-4f, 0.5f }) {
+            float x = std::min(static_cast<float>(line), static_cast<float>(kSize - 1));
+            float z = line + offset - x;
+            glm::vec3 origin(x, 12.0f, z);
+            checkRay(pyramid, heights, origin, glm::vec3(-1.0f, -0.15f, 1.0f));
+            checkRay(pyramid, heights, origin, glm::vec3(-1.0f, -0.02f, 1.0f));
+        }
+    }
+    // Rays crossing the diagonals through cell corners
+    for (int start = 0; start < kSize - 1; start += 4) {
+        checkRay(pyramid, heights, glm::vec3(static_cast<float>(start), 12.0f, 0.0f), glm::vec3(1.0f, -0.2f, 1.0f));
+    }
+}
+
+TEST_CASE(raycastFlatGrid) {
+    // A plane at height 2: every downward ray over the grid hits it where it crosses y = 2
+    std::vector<float> heights(static_cast<size_t>(kSize) * kSize, 2.0f);
+    HeightPyramid pyramid;
+    pyramid.build(heights, kSize, kSize);
+    float t = 0.0f;
+    CHECK(pyramid.intersect(glm::vec3(4.0f, 10.0f, 4.0f), glm::vec3(1.0f, -1.0f, 1.0f), 100.0f, t));
+    CHECK(std::fabs(t - 8.0f) < 1e-4f);
+    // Parallel above it, or pointing away, never hits
+    CHECK(!pyramid.intersect(glm::vec3(4.0f, 3.0f, 4.0f), glm::vec3(1.0f, 0.0f, 0.0f), 100.0f, t));
+    CHECK(!pyramid.intersect(glm::vec3(4.0f, 3.0f, 4.0f), glm::vec3(0.0f, 1.0f, 0.0f), 100.0f, t));
+    // A hit beyond maxT is not reported
+    CHECK(!pyramid.intersect(glm::vec3(4.0f, 10.0f, 4.0f), glm::vec3(0.0f, -1.0f, 0.0f), 7.0f, t));
+}
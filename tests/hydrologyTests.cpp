@@ -0,0 +1,67 @@
+#include "test.h"
+#include "hydrology.h"
+#include <cmath>
+
+namespace {
+const int kWidth = 40, kHeight = 30;
+
+/// Upstream area draining off the grid; every cell must end up in exactly one outlet
+float outletArea(const Hydrology& hydrology) {
+    float area = 0.0f;
+    for (size_t cell = 0; cell < hydrology.getReceivers().size(); ++cell) {
+        if (hydrology.getReceivers()[cell] < 0) area += hydrology.getAccumulation()[cell];
+    }
+    return area;
+}
+}
+
+TEST_CASE(d8OnTiltedPlane) {
+    // Rising toward +x: every cell drains straight west, off the x = 0 edge
+    std::vector<float> heights(static_cast<size_t>(kWidth) * kHeight);
+    for (int z = 0; z < kHeight; ++z) {
+        for (int x = 0; x < kWidth; ++x) heights[static_cast<size_t>(z) * kWidth + x] = static_cast<float>(x);
+    }
+    Hydrology hydrology;
+    hydrology.compute(heights, kWidth, kHeight, 1.0f);
+    const std::vector<int32_t>& receivers = hydrology.getReceivers();
+    const std::vector<float>& accumulation = hydrology.getAccumulation();
+    CHECK(receivers.size() == heights.size() && accumulation.size() == heights.size());
+
+    for (int z = 0; z < kHeight && receivers.size() == heights.size(); ++z) {
+        for (int x = 0; x < kWidth; ++x) {
+            int cell = z * kWidth + x;
+            CHECK(receivers[cell] == (x == 0 ? -1 : cell - 1));
+            // A cell collects its own area and that of every cell east of it
+            CHECK(accumulation[cell] == static_cast<float>(kWidth - x));
+        }
+    }
+    CHECK(outletArea(hydrology) == static_cast<float>(kWidth * kHeight));
+}
+
+TEST_CASE(d8ValleyAndPit) {
+    // A V-shaped valley along x = 20 falling toward z = 0, with a pit dug into its floor
+    std::vector<float> heights(static_cast<size_t>(kWidth) * kHeight);
+    for (int z = 0; z < kHeight; ++z) {
+        for (int x = 0; x < kWidth; ++x) {
+            heights[static_cast<size_t>(z) * kWidth + x] = 2.0f * std::fabs(x - 20.0f) + 0.5f * z;
+        }
+    }
+    heights[15 * kWidth + 20] -= 5.0f;
+    Hydrology hydrology;
+    hydrology.compute(heights, kWidth, kHeight, 1.0f);
+    const std::vector<int32_t>& receivers = hydrology.getReceivers();
+    const std::vector<float>& accumulation = hydrology.getAccumulation();
+    CHECK(receivers.size() == heights.size());
+    if (receivers.size() != heights.size()) return;
+
+    // The pit is filled and drained, so all flow reaches an outlet and the valley
+    // mouth collects at least the whole valley floor
+    for (int32_t receiver : receivers) CHECK(receiver >= -1);
+    CHECK(outletArea(hydrology) == static_cast<float>(kWidth * kHeight));
+    CHECK(receivers[20] == -1);
+    CHECK(accumulation[20] >= static_cast<float>(kHeight));
+    // Flow along the floor grows downstream
+    for (int z = 1; z < kHeight; ++z) {
+        CHECK(accumulation[(z - 1) * kWidth + 20] > accumulation[z * kWidth + 20]);
+    }
+}
@@ -0,0 +1,88 @@
+#include "test.h"
+#include "imagePipeline.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+const int kWidth = 37, kHeight = 23, kChannels = 3;   // Odd sizes and unaligned RGB rows
+
+/// The per-byte loop the table replaced: contrast around mid-grey, then brightness.
+unsigned char adjustReference(unsigned char value, float brightness, float contrast) {
+    float pixel = value / 255.0f;
+    pixel = (pixel - 0.5f) * contrast + 0.5f;
+    pixel *= brightness;
+    return static_cast<unsigned char>(std::clamp(pixel, 0.0f, 1.0f) * 255.0f);
+}
+
+/// Fixed image holding every byte value, in an order that is not a simple ramp.
+std::vector<unsigned char> makeImage() {
+    std::vector<unsigned char> image(static_cast<size_t>(kWidth) * kHeight * kChannels);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = static_cast<unsigned char>((i * 73 + i / 256) & 0xFF);
+    }
+    return image;
+}
+
+/// Serial 2 x 2 box filter of one level, repeating the last row and column when odd.
+std::vector<unsigned char> downsampleReference(const std::vector<unsigned char>& source, int width, int height) {
+    int targetWidth = std::max(1, width / 2), targetHeight = std::max(1, height / 2);
+    std::vector<unsigned char> target(static_cast<size_t>(targetWidth) * targetHeight * kChannels);
+    auto at = [&](int x, int y, int c) {
+        return source[(static_cast<size_t>(std::min(y, height - 1)) * width + std::min(x, width - 1)) * kChannels + c];
+    };
+    for (int y = 0; y < targetHeight; ++y) {
+        for (int x = 0; x < targetWidth; ++x) {
+            for (int c = 0; c < kChannels; ++c) {
+                int sum = at(2 * x, 2 * y, c) + at(2 * x + 1, 2 * y, c) + at(2 * x, 2 * y + 1, c) + at(2 * x + 1, 2 * y + 1, c);
+                target[(static_cast<size_t>(y) * targetWidth + x) * kChannels + c] = static_cast<unsigned char>((sum + 2) >> 2);
+            }
+        }
+    }
+    return target;
+}
+}
+
+TEST_CASE(tableMatchesReference) {
+    const float settings[][2] = { { 1.2f, 1.1f }, { 1.0f, 1.0f }, { 0.7f, 1.6f }, { 1.5f, 0.4f } };
+    std::vector<unsigned char> image = makeImage();
+    for (const auto& setting : settings) {
+        ImagePipeline pipeline;
+        pipeline.setBrightness(setting[0]);
+        pipeline.setContrast(setting[1]);
+        // apply() covers the vector body and the scalar tail (the size is not a multiple of 16)
+        std::vector<unsigned char> adjusted = image;
+        pipeline.apply(adjusted.data(), adjusted.size());
+        bool identical = true;
+        for (size_t i = 0; i < image.size(); ++i) {
+            identical = identical && adjusted[i] == adjustReference(image[i], setting[0], setting[1]);
+        }
+        CHECK(identical);
+    }
+}
+
+TEST_CASE(processMatchesReference) {
+    ImagePipeline pipeline;
+    pipeline.setBrightness(1.2f);
+    pipeline.setContrast(1.1f);
+    std::vector<unsigned char> image = makeImage();
+
+    MipChain chain;
+    pipeline.process(image.data(), kWidth, kHeight, kChannels, true, chain);
+
+    // Reference: adjust every byte, then filter level by level
+    std::vector<unsigned char> level = image;
+    for (unsigned char& value : level) value = adjustReference(value, 1.2f, 1.1f);
+    int width = kWidth, height = kHeight;
+    CHECK(chain.getLevels() == 6);   // 37 x 23 down to 1 x 1
+    for (int i = 0; i < chain.getLevels(); ++i) {
+        CHECK(chain.levelWidth(i) == width && chain.levelHeight(i) == height);
+        CHECK(std::equal(level.begin(), level.end(), chain.levelData(i)));
+        level = downsampleReference(level, width, height);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    // Without adjustment level 0 is the image itself
+    pipeline.process(image.data(), kWidth, kHeight, kChannels, false, chain);
+    CHECK(std::equal(image.begin(), image.end(), chain.levelData(0)));
+}
@@ -0,0 +1,80 @@
+#include "test.h"
+#include "peakIndex.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const int kWidth = 81, kHeight = 41;
+
+/// Height of a cone of the given summit height and slope, or 0 past its foot
+float cone(int x, int z, int peakX, int peakZ, float summit, float slope) {
+    return std::max(0.0f, summit - slope * std::hypot(static_cast<float>(x - peakX), static_cast<float>(z - peakZ)));
+}
+
+/**
+ * @brief Three cones on a plain: a 100 high main summit, a 60 high neighbour joined
+ *        to it by a ridge at 30, and a lone 20 high hill.
+ */
+std::vector<float> makeRange() {
+    std::vector<float> heights(static_cast<size_t>(kWidth) * kHeight);
+    for (int z = 0; z < kHeight; ++z) {
+        for (int x = 0; x < kWidth; ++x) {
+            float ridge = (z == 20 && x >= 20 && x <= 50) ? 30.0f : 0.0f;
+            heights[static_cast<size_t>(z) * kWidth + x] =
+                std::max({ cone(x, z, 20, 20, 100.0f, 5.0f), cone(x, z, 50, 20, 60.0f, 5.0f),
+                           cone(x, z, 72, 10, 20.0f, 4.0f), ridge });
+        }
+    }
+    return heights;
+}
+
+const Peak* findPeak(const std::vector<Peak>& peaks, int x, int z) {
+    for (const Peak& peak : peaks) {
+        if (peak.x == x && peak.z == z) return &peak;
+    }
+    return nullptr;
+}
+}
+
+TEST_CASE(prominenceOfSummits) {
+    std::vector<float> heights = makeRange();
+    PeakIndex index;
+    index.setMinimumProminence(1.0f);
+    index.build(heights, kWidth, kHeight, 1.0f);
+    const std::vector<Peak>& peaks = index.getPeaks();
+    CHECK(peaks.size() == 3);
+
+    // The highest summit stands above the lowest point of the grid
+    const Peak* main = findPeak(peaks, 20, 20);
+    CHECK(main != nullptr && main->prominence == 100.0f);
+    // The neighbour's col is the ridge, not the plain
+    const Peak* neighbour = findPeak(peaks, 50, 20);
+    CHECK(neighbour != nullptr && neighbour->prominence == 30.0f);
+    // The lone hill's col is the plain
+    const Peak* hill = findPeak(peaks, 72, 10);
+    CHECK(hill != nullptr && hill->prominence == 20.0f);
+
+    // Most prominent first, at world positions centred on the grid
+    CHECK(peaks.size() == 3 && peaks[0].x == 20 && peaks[1].x == 50 && peaks[2].x == 72);
+    if (main) {
+        CHECK(main->position == glm::vec3(20.0f - 40.0f, 100.0f, 0.0f));
+    }
+}
+
+TEST_CASE(prominenceThresholdAndQuery) {
+    std::vector<float> heights = makeRange();
+    PeakIndex index;
+    index.setMinimumProminence(25.0f);
+    index.build(heights, kWidth, kHeight, 1.0f);
+    CHECK(index.getPeaks().size() == 2);
+
+    // Around the neighbour, only summits inside the radius, most prominent first
+    std::vector<Peak> nearby;
+    index.setMinimumProminence(1.0f);
+    index.build(heights, kWidth, kHeight, 1.0f);
+    index.query(glm::vec3(50.0f - 40.0f, 0.0f, 0.0f), 25.0f, 10, nearby);
+    CHECK(nearby.size() == 2);
+    CHECK(nearby.size() == 2 && nearby[0].x == 50 && nearby[1].x == 72);
+    index.query(glm::vec3(50.0f - 40.0f, 0.0f, 0.0f), 25.0f, 1, nearby);
+    CHECK(nearby.size() == 1 && nearby[0].x == 50);
+}
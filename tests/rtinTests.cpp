@@ -0,0 +1,106 @@
+#include "test.h"
+#include "rtin.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+/// Rolling hills with a sharp ridge, so the mesh refines unevenly
+std::vector<float> makeHills(int width, int height) {
+    std::vector<float> heights(static_cast<size_t>(width) * height);
+    for (int z = 0; z < height; ++z) {
+        for (int x = 0; x < width; ++x) {
+            heights[static_cast<size_t>(z) * width + x] =
+                10.0f * std::sin(x * 0.21f) * std::cos(z * 0.17f) + 6.0f * std::fabs(std::sin((x + z) * 0.05f)) + 0.3f * x;
+        }
+    }
+    return heights;
+}
+
+/**
+ * @brief Largest error of a triangle's subtree, recomputed from the heights: each
+ *        split point against the midpoint of the hypotenuse it splits.
+ */
+float subtreeError(const std::vector<float>& heights, int width, int ax, int ay, int bx, int by, int cx, int cy) {
+    if (std::abs(ax - cx) + std::abs(ay - cy) <= 1) return 0.0f;
+    int mx = (ax + bx) / 2, my = (ay + by) / 2;
+    float interpolated = (heights[ay * width + ax] + heights[by * width + bx]) * 0.5f;
+    float error = std::fabs(interpolated - heights[my * width + mx]);
+    error = std::max(error, subtreeError(heights, width, cx, cy, ax, ay, mx, my));
+    return std::max(error, subtreeError(heights, width, bx, by, cx, cy, mx, my));
+}
+
+/**
+ * @brief Checks that the triangles' areas add up to the grid's. RTIN triangles never
+ *        overlap, so this means the mesh covers the grid without holes.
+ */
+void checkCoverage(const std::vector<GLuint>& indices, int width, int height) {
+    double area = 0.0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        int x[3], z[3];
+        for (int v = 0; v < 3; ++v) {
+            x[v] = static_cast<int>(indices[t + v] % width);
+            z[v] = static_cast<int>(indices[t + v] / width);
+        }
+        area += std::fabs(static_cast<double>((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0]))) * 0.5;
+    }
+    CHECK(std::fabs(area - static_cast<double>(width - 1) * (height - 1)) < 1e-6);
+}
+}
+
+TEST_CASE(rtinErrorBound) {
+    const int size = 65;
+    std::vector<float> heights = makeHills(size, size);
+    TerrainRTIN rtin;
+    rtin.build(heights, size, size);
+    CHECK(rtin.isBuilt());
+
+    for (float maxError : { 0.05f, 0.5f, 2.0f }) {
+        std::vector<GLuint> indices;
+        rtin.extract(maxError, indices);
+        CHECK(indices.size() % 3 == 0);
+        CHECK(indices.size() / 3 == rtin.countTriangles(maxError));
+        checkCoverage(indices, size, size);
+        // Every emitted triangle stands in for a subtree whose error is within the bound
+        for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+            int ax = indices[t] % size, ay = indices[t] / size;
+            int cx = indices[t + 1] % size, cy = indices[t + 1] / size;
+            int bx = indices[t + 2] % size, by = indices[t + 2] / size;
+            CHECK(subtreeError(heights, size, ax, ay, bx, by, cx, cy) <= maxError);
+        }
+    }
+    // A looser bound never needs more triangles
+    CHECK(rtin.countTriangles(2.0f) <= rtin.countTriangles(0.5f));
+    CHECK(rtin.countTriangles(0.5f) <= rtin.countTriangles(0.05f));
+}
+
+TEST_CASE(rtinFlatAndFull) {
+    const int size = 33;
+    // A plane is represented exactly by the two root triangles
+    std::vector<float> plane(static_cast<size_t>(size) * size);
+    for (int z = 0; z < size; ++z) {
+        for (int x = 0; x < size; ++x) plane[static_cast<size_t>(z) * size + x] = 0.5f * x - 0.25f * z;
+    }
+    TerrainRTIN rtin;
+    rtin.build(plane, size, size);
+    CHECK(rtin.countTriangles(0.0f) == 2);
+
+    // With no error allowed, rough terrain refines down to the full grid
+    std::vector<float> hills = makeHills(size, size);
+    rtin.build(hills, size, size);
+    CHECK(rtin.countTriangles(0.0f) == static_cast<size_t>(2 * (size - 1) * (size - 1)));
+}
+
+TEST_CASE(rtinPaddedGrid) {
+    // Not 2^k + 1: triangles in the padding must not be emitted
+    const int width = 50, height = 37;
+    std::vector<float> heights = makeHills(width, height);
+    TerrainRTIN rtin;
+    rtin.build(heights, width, height);
+    for (float maxError : { 0.0f, 1.0f }) {
+        std::vector<GLuint> indices;
+        rtin.extract(maxError, indices);
+        CHECK(!indices.empty());
+        CHECK(*std::max_element(indices.begin(), indices.end()) < static_cast<GLuint>(width * height));
+        checkCoverage(indices, width, height);
+    }
+}
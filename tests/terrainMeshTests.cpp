@@ -0,0 +1,109 @@
+#include "test.h"
+#include "terrainMesh.h"
+#include <algorithm>
+
+namespace {
+/// Grid column and row of the cell a list triangle belongs to
+void cellOf(const std::vector<GLuint>& indices, size_t triangle, int columns, int& x, int& z) {
+    x = columns;
+    z = static_cast<int>(indices[triangle * 3] / columns);
+    for (int v = 0; v < 3; ++v) {
+        x = std::min(x, static_cast<int>(indices[triangle * 3 + v] % columns));
+        z = std::min(z, static_cast<int>(indices[triangle * 3 + v] / columns));
+    }
+}
+}
+
+TEST_CASE(bandOrdering) {
+    const int columns = 41, rows = 9, bandWidth = 15;
+    std::vector<GLuint> indices;
+    appendGridTriangles(columns, rows, bandWidth, indices);
+    CHECK(indices.size() == static_cast<size_t>(columns - 1) * (rows - 1) * 6);
+
+    // Two triangles per cell, cells by band, then row, then column; the last band is narrower
+    for (size_t triangle = 0; triangle + 1 < indices.size() / 3; ++triangle) {
+        int x0, z0, x1, z1;
+        cellOf(indices, triangle, columns, x0, z0);
+        cellOf(indices, triangle + 1, columns, x1, z1);
+        if (triangle % 2 == 0) {
+            CHECK(x0 == x1 && z0 == z1);
+            continue;
+        }
+        int band0 = x0 / bandWidth, band1 = x1 / bandWidth;
+        bool sameRow = band1 == band0 && z1 == z0 && x1 == x0 + 1;
+        bool nextRow = band1 == band0 && z1 == z0 + 1 && x1 == band0 * bandWidth &&
+                       x0 == std::min(band0 * bandWidth + bandWidth, columns - 1) - 1;
+        bool nextBand = band1 == band0 + 1 && z0 == rows - 2 && z1 == 0 && x1 == band1 * bandWidth;
+        CHECK(sameRow || nextRow || nextBand);
+    }
+
+    // A band width of 0 is the original row-major order
+    std::vector<GLuint> rowMajor;
+    appendGridTriangles(columns, rows, 0, rowMajor);
+    for (size_t triangle = 0; triangle < rowMajor.size() / 3; ++triangle) {
+        int x, z;
+        cellOf(rowMajor, triangle, columns, x, z);
+        CHECK(static_cast<size_t>(z * (columns - 1) + x) == triangle / 2);
+    }
+}
+
+TEST_CASE(bandsReduceCacheMisses) {
+    // A band row stays resident, so each vertex is transformed about once
+    const int size = 257, cacheSize = 32;
+    CHECK(vertexCacheBandWidth(cacheSize) == 15);
+    std::vector<GLuint> rowMajor, banded;
+    appendGridTriangles(size, size, 0, rowMajor);
+    appendGridTriangles(size, size, vertexCacheBandWidth(cacheSize), banded);
+    const size_t vertexCount = static_cast<size_t>(size) * size;
+    VertexCacheStats before = simulateVertexCache(rowMajor, vertexCount, cacheSize);
+    VertexCacheStats after = simulateVertexCache(banded, vertexCount, cacheSize);
+    CHECK(before.triangles == after.triangles);
+    CHECK(before.atvr > 1.9f);
+    CHECK(after.atvr < 1.15f);
+    CHECK(after.acmr < before.acmr);
+}
+
+TEST_CASE(chunksFit16BitIndices) {
+    const int columns = 300, rows = 140, chunkSize = 128;
+    for (TerrainTopology topology : { TerrainTopology::TRIANGLES, TerrainTopology::TRIANGLE_STRIP }) {
+        std::vector<GLushort> indices;
+        std::vector<TerrainChunk> chunks;
+        appendGridChunks(columns, rows, chunkSize, 15, topology, indices, chunks);
+        // 3 x 2 chunks, the last column and row of chunks cut short
+        CHECK(chunks.size() == 6);
+
+        GLint baseVertex = 0;
+        size_t indexCount = 0;
+        long long cells = 0;
+        for (const TerrainChunk& chunk : chunks) {
+            CHECK(chunk.baseVertex == baseVertex);
+            CHECK(chunk.indexOffset == indexCount * sizeof(GLushort));
+            CHECK(chunk.columns == std::min(chunkSize, columns - 1 - chunk.firstColumn) + 1);
+            CHECK(chunk.rows == std::min(chunkSize, rows - 1 - chunk.firstRow) + 1);
+            cells += static_cast<long long>(chunk.columns - 1) * (chunk.rows - 1);
+
+            // Every index addresses one of the chunk's own vertices, below the restart index
+            const int vertexCount = chunk.columns * chunk.rows;
+            CHECK(vertexCount < 0xFFFF);
+            size_t first = chunk.indexOffset / sizeof(GLushort);
+            std::vector<GLuint> local;
+            for (GLsizei i = 0; i < chunk.indexCount; ++i) {
+                GLushort index = indices[first + i];
+                CHECK(index == 0xFFFFu || index < vertexCount);
+                local.push_back(index == 0xFFFFu ? 0xFFFFFFFFu : index);
+            }
+            if (topology == TerrainTopology::TRIANGLES) {
+                CHECK(chunk.indexCount == (chunk.columns - 1) * (chunk.rows - 1) * 6);
+            } else {
+                std::vector<GLuint> list;
+                appendGridTriangles(chunk.columns, chunk.rows, 15, list);
+                CHECK(stripsMatchTriangles(list, local, 0xFFFFFFFFu));
+            }
+            baseVertex += vertexCount;
+            indexCount += chunk.indexCount;
+        }
+        CHECK(indexCount == indices.size());
+        // Together the chunks cover every cell of the grid exactly once
+        CHECK(cells == static_cast<long long>(columns - 1) * (rows - 1));
+    }
+}
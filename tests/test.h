@@ -0,0 +1,49 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief A registered test: a name and the function that runs its checks.
+ */
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+/**
+ * @brief Every test case linked into the executable, in registration order.
+ */
+std::vector<TestCase>& testRegistry();
+
+/**
+ * @brief Number of failed checks so far.
+ */
+int& testFailures();
+
+/**
+ * @brief Adds a test case to the registry during static initialisation.
+ */
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) {
+        testRegistry().push_back({ name, run });
+    }
+};
+
+/// Defines and registers a test case, e.g. TEST_CASE(roundTrip) { CHECK(...); }
+#define TEST_CASE(name) \
+    static void name(); \
+    static TestRegistrar name##Registrar(#name, name); \
+    static void name()
+
+/// Records a failure with its location if the condition is false and carries on.
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ++testFailures(); \
+            std::cerr << "FAILED: " << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl; \
+        } \
+    } while (0)
+
+#endif // TEST_H
@@ -0,0 +1,21 @@
+#include "test.h"
+
+std::vector<TestCase>& testRegistry() {
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+int main() {
+    for (const TestCase& test : testRegistry()) {
+        int before = testFailures();
+        test.run();
+        std::cout << (testFailures() == before ? "PASSED: " : "FAILED: ") << test.name << std::endl;
+    }
+    std::cout << testRegistry().size() << " tests, " << testFailures() << " failed checks" << std::endl;
+    return testFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+#include "test.h"
+#include "textureCompression.h"
+#include "imagePipeline.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+const int kSize = 64;
+
+struct DecodeError {
+    int maxError = 0;   ///< Largest per-channel difference.
+    double rmse = 0.0;  ///< Root mean square over every channel compared.
+};
+
+void expand565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Reference decoders written from the format specifications, independent of the encoder
+
+void decodeColorBlock(const unsigned char* in, unsigned char out[16][4]) {
+    uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8)), c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    int palette[4][3];
+    expand565(c0, palette[0]);
+    expand565(c1, palette[1]);
+    for (int c = 0; c < 3; ++c) {
+        if (c0 > c1) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    uint32_t indices = static_cast<uint32_t>(in[4]) | (in[5] << 8) | (in[6] << 16) | (static_cast<uint32_t>(in[7]) << 24);
+    for (int i = 0; i < 16; ++i) {
+        int index = (indices >> (2 * i)) & 3;
+        for (int c = 0; c < 3; ++c) out[i][c] = static_cast<unsigned char>(palette[index][c]);
+        out[i][3] = 255;
+    }
+}
+
+void decodeAlphaBlock(const unsigned char* in, unsigned char out[16][4]) {
+    int a0 = in[0], a1 = in[1];
+    int palette[8] = { a0, a1 };
+    if (a0 > a1) {
+        for (int p = 2; p < 8; ++p) palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+    } else {
+        for (int p = 2; p < 6; ++p) palette[p] = ((6 - p) * a0 + (p - 1) * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    uint64_t indices = 0;
+    for (int b = 0; b < 6; ++b) indices |= static_cast<uint64_t>(in[2 + b]) << (8 * b);
+    for (int i = 0; i < 16; ++i) {
+        out[i][3] = static_cast<unsigned char>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+/// BC7 mode 6 only, the one mode the encoder writes
+bool decodeBC7Block(const unsigned char* in, unsigned char out[16][4]) {
+    uint64_t words[2];
+    std::memcpy(words, in, 16);
+    int position = 0;
+    auto read = [&](int bits) {
+        uint32_t value = 0;
+        for (int b = 0; b < bits; ++b, ++position) {
+            value |= static_cast<uint32_t>((words[position >> 6] >> (position & 63)) & 1) << b;
+        }
+        return value;
+    };
+    if (read(7) != (1u << 6)) return false;
+    int endpoint[2][4];
+    for (int c = 0; c < 4; ++c) {
+        endpoint[0][c] = static_cast<int>(read(7));
+        endpoint[1][c] = static_cast<int>(read(7));
+    }
+    int pbit0 = static_cast<int>(read(1)), pbit1 = static_cast<int>(read(1));
+    static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+    for (int i = 0; i < 16; ++i) {
+        int index = static_cast<int>(read(i == 0 ? 3 : 4));
+        for (int c = 0; c < 4; ++c) {
+            int e0 = (endpoint[0][c] << 1) | pbit0, e1 = (endpoint[1][c] << 1) | pbit1;
+            out[i][c] = static_cast<unsigned char>(((64 - weights[index]) * e0 + weights[index] * e1 + 32) >> 6);
+        }
+    }
+    return true;
+}
+
+/// Encodes an RGBA image and compares level 0 decoded with the reference decoders.
+DecodeError roundTrip(const std::vector<unsigned char>& rgba, BlockFormat format, bool compareAlpha) {
+    MipChain chain;
+    ImagePipeline().process(rgba.data(), kSize, kSize, 4, false, chain);
+    CompressedTexture texture;
+    TextureCompressor::encode(chain, format, texture);
+    CHECK(texture.getLevels() == chain.getLevels());
+    CHECK(texture.levelSizes[0] == TextureCompressor::levelBytes(format, kSize, kSize));
+
+    DecodeError result;
+    double squared = 0.0;
+    size_t compared = 0;
+    const size_t blockSize = format == BlockFormat::BC1 ? 8 : 16;
+    const int blocks = kSize / 4;
+    for (int by = 0; by < blocks; ++by) {
+        for (int bx = 0; bx < blocks; ++bx) {
+            const unsigned char* block = texture.data.data() + (static_cast<size_t>(by) * blocks + bx) * blockSize;
+            unsigned char decoded[16][4];
+            if (format == BlockFormat::BC1) {
+                decodeColorBlock(block, decoded);
+            } else if (format == BlockFormat::BC3) {
+                decodeColorBlock(block + 8, decoded);
+                decodeAlphaBlock(block, decoded);
+            } else {
+                CHECK(decodeBC7Block(block, decoded));
+            }
+            for (int i = 0; i < 16; ++i) {
+                const unsigned char* source = &rgba[((static_cast<size_t>(by) * 4 + i / 4) * kSize + bx * 4 + i % 4) * 4];
+                for (int c = 0; c < (compareAlpha ? 4 : 3); ++c) {
+                    int difference = std::abs(decoded[i][c] - source[c]);
+                    result.maxError = std::max(result.maxError, difference);
+                    squared += static_cast<double>(difference) * difference;
+                    ++compared;
+                }
+            }
+        }
+    }
+    result.rmse = std::sqrt(squared / static_cast<double>(compared));
+    return result;
+}
+
+/**
+ * @brief A ramp whose channels all vary along one line, (2, -2, 1, -1) per texel
+ *        step. The one-line palette of every format can represent it, so its error
+ *        is only quantisation.
+ */
+std::vector<unsigned char> makeRamp() {
+    std::vector<unsigned char> rgba(static_cast<size_t>(kSize) * kSize * 4);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            unsigned char* texel = &rgba[(static_cast<size_t>(y) * kSize + x) * 4];
+            int step = x + y;
+            texel[0] = static_cast<unsigned char>(2 * step);
+            texel[1] = static_cast<unsigned char>(255 - 2 * step);
+            texel[2] = static_cast<unsigned char>(step);
+            texel[3] = static_cast<unsigned char>(255 - step);
+        }
+    }
+    return rgba;
+}
+
+/**
+ * @brief Independent ramps in x and y, so each block's colours span a plane. A
+ *        one-line palette cannot fit it, which bounds the error from below.
+ */
+std::vector<unsigned char> makeGradient() {
+    std::vector<unsigned char> rgba(static_cast<size_t>(kSize) * kSize * 4);
+    for (int y = 0; y < kSize; ++y) {
+        for (int x = 0; x < kSize; ++x) {
+            unsigned char* texel = &rgba[(static_cast<size_t>(y) * kSize + x) * 4];
+            texel[0] = static_cast<unsigned char>(x * 4);
+            texel[1] = static_cast<unsigned char>(y * 4);
+            texel[2] = static_cast<unsigned char>((x + y) * 2);
+            texel[3] = static_cast<unsigned char>(255 - x * 3);
+        }
+    }
+    return rgba;
+}
+
+std::vector<unsigned char> makeSolid(unsigned char r, unsigned char g, unsigned char b, unsigned char a) {
+    std::vector<unsigned char> rgba(static_cast<size_t>(kSize) * kSize * 4);
+    for (size_t i = 0; i < rgba.size(); i += 4) {
+        rgba[i] = r;
+        rgba[i + 1] = g;
+        rgba[i + 2] = b;
+        rgba[i + 3] = a;
+    }
+    return rgba;
+}
+}
+
+TEST_CASE(bc1ErrorBound) {
+    // 5:6:5 end points and four palette entries
+    DecodeError ramp = roundTrip(makeRamp(), BlockFormat::BC1, false);
+    CHECK(ramp.rmse < 2.0);
+    CHECK(ramp.maxError <= 6);
+    DecodeError gradient = roundTrip(makeGradient(), BlockFormat::BC1, false);
+    CHECK(gradient.rmse < 3.5);
+    CHECK(gradient.maxError <= 12);
+    // A flat block only loses the 5:6:5 quantisation of its colour
+    DecodeError solid = roundTrip(makeSolid(200, 117, 31, 255), BlockFormat::BC1, false);
+    CHECK(solid.maxError <= 4);
+}
+
+TEST_CASE(bc3ErrorBound) {
+    DecodeError ramp = roundTrip(makeRamp(), BlockFormat::BC3, true);
+    CHECK(ramp.rmse < 2.0);
+    CHECK(ramp.maxError <= 6);
+    DecodeError gradient = roundTrip(makeGradient(), BlockFormat::BC3, true);
+    CHECK(gradient.rmse < 3.0);
+    CHECK(gradient.maxError <= 12);
+    // Alpha end points are stored at full precision
+    DecodeError solid = roundTrip(makeSolid(200, 117, 31, 77), BlockFormat::BC3, true);
+    CHECK(solid.maxError <= 4);
+}
+
+TEST_CASE(bc7ErrorBound) {
+    // 7-bit end points with a shared bit and sixteen palette entries: a line is near exact
+    DecodeError ramp = roundTrip(makeRamp(), BlockFormat::BC7, true);
+    CHECK(ramp.rmse < 0.5);
+    CHECK(ramp.maxError <= 1);
+    DecodeError gradient = roundTrip(makeGradient(), BlockFormat::BC7, true);
+    CHECK(gradient.rmse < 2.75);
+    CHECK(gradient.maxError <= 8);
+    DecodeError solid = roundTrip(makeSolid(200, 117, 31, 77), BlockFormat::BC7, true);
+    CHECK(solid.maxError <= 1);
+}
+
+TEST_CASE(levelSizes) {
+    CHECK(TextureCompressor::levelBytes(BlockFormat::BC1, 4, 4) == 8);
+    CHECK(TextureCompressor::levelBytes(BlockFormat::BC3, 4, 4) == 16);
+    CHECK(TextureCompressor::levelBytes(BlockFormat::BC7, 5, 3) == 32);
+    CHECK(TextureCompressor::levelBytes(BlockFormat::BC1, 1, 1) == 8);
+}
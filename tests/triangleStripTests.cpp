@@ -0,0 +1,65 @@
+#include "test.h"
+#include "terrainMesh.h"
+#include <algorithm>
+
+namespace {
+const GLuint kRestart = 0xFFFFFFFFu;
+}
+
+TEST_CASE(stripsMatchList) {
+    // Band widths that divide the row, leave a narrow last band, or exceed it; even and odd row counts
+    for (int rows : { 2, 3, 8, 9 }) {
+        for (int bandWidth : { 0, 1, 4, 7, 15, 100 }) {
+            const int columns = 29;
+            std::vector<GLuint> list, strips;
+            appendGridTriangles(columns, rows, bandWidth, list);
+            appendGridStrips(columns, rows, bandWidth, kRestart, strips);
+            CHECK(stripsMatchTriangles(list, strips, kRestart));
+
+            // One strip per row of every band, each ended by the restart index
+            int bands = bandWidth <= 0 || bandWidth > columns - 1 ? 1 : (columns - 1 + bandWidth - 1) / bandWidth;
+            size_t restarts = 0;
+            for (GLuint index : strips) restarts += index == kRestart;
+            CHECK(restarts == static_cast<size_t>(bands) * (rows - 1));
+            CHECK(!strips.empty() && strips.back() == kRestart);
+        }
+    }
+}
+
+TEST_CASE(expandDropsDegenerates) {
+    // Two 3 x 2 cells as strips: the leading duplicate gives one degenerate triangle,
+    // dropped, and odd triangles swap their first two indices to keep the winding
+    std::vector<GLuint> strips = { 0, 0, 3, 1, 4, kRestart, 1, 1, 4, 2, 5, kRestart };
+    std::vector<GLuint> triangles;
+    expandTriangleStrips(strips, kRestart, triangles);
+    std::vector<GLuint> expected = { 3, 0, 1, 3, 1, 4, 4, 1, 2, 4, 2, 5 };
+    CHECK(triangles == expected);
+    std::vector<GLuint> list;
+    appendGridTriangles(3, 2, 0, list);
+    CHECK(stripsMatchTriangles(list, strips, kRestart));
+
+    // No triangle spans a restart, and a strip shorter than three indices adds nothing
+    std::vector<GLuint> shortStrips = { 0, 1, kRestart, 2, kRestart, 3, 4, 5 };
+    triangles.clear();
+    expandTriangleStrips(shortStrips, kRestart, triangles);
+    CHECK(triangles == std::vector<GLuint>({ 3, 4, 5 }));
+}
+
+TEST_CASE(stripMismatchDetected) {
+    std::vector<GLuint> list, strips;
+    appendGridTriangles(6, 5, 3, list);
+    appendGridStrips(6, 5, 3, kRestart, strips);
+
+    // Reversed winding of one triangle
+    std::vector<GLuint> flipped = list;
+    std::swap(flipped[0], flipped[1]);
+    CHECK(!stripsMatchTriangles(flipped, strips, kRestart));
+    // The last strip missing: a leading duplicate, two rows of four vertices and the restart
+    const size_t stripLength = 1 + 2 * 4 + 1;
+    std::vector<GLuint> missingStrip(strips.begin(), strips.end() - stripLength);
+    CHECK(!stripsMatchTriangles(list, missingStrip, kRestart));
+    // Two rows joined into one strip by dropping the restart between them
+    std::vector<GLuint> joined = strips;
+    joined.erase(std::find(joined.begin(), joined.end(), kRestart));
+    CHECK(!stripsMatchTriangles(list, joined, kRestart));
+}
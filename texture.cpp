@@ -0,0 +1,13 @@
+#include "texture.h"
+
+Texture::Texture(GLuint id) : textureID(id) {}
+
+Texture::~Texture() {
+    if (textureID != 0) {
+        glDeleteTextures(1, &textureID);
+    }
+}
+
+GLuint Texture::getID() const {
+    return textureID;
+}
@@ -0,0 +1,30 @@
+#ifndef TEXTURE_H
+#define TEXTURE_H
+
+#include <GL/glew.h>
+
+/**
+ * @class Texture
+ * @brief Owns a GL texture name and deletes it when destroyed. Held through the
+ *        AssetManager, so a texture built from the same content is uploaded once and
+ *        lives until its last holder releases it.
+ */
+class Texture {
+public:
+    /**
+     * @brief Takes ownership of a texture name from glGenTextures.
+     */
+    explicit Texture(GLuint textureID);
+    ~Texture();
+
+    // Owns the name, so copies would delete it twice
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    GLuint getID() const;
+
+private:
+    GLuint textureID;
+};
+
+#endif // TEXTURE_H
@@ -0,0 +1,462 @@
+#include "textureCompression.h"
+#include "threadPool.h"
+#include "assetManager.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+const char kContainerTag[4] = { 'B', 'C', 'T', 'X' };
+const uint32_t kContainerVersion = 1;
+const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct ContainerHeader {
+    char tag[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width, height, levels;
+    uint64_t sourceKey;
+};
+
+/// Gathers a 4 x 4 block as RGBA, repeating edge texels past the image.
+void fetchBlock(const unsigned char* data, int width, int height, int channels, int bx, int by, int block[16][4]) {
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            const unsigned char* texel = data + (static_cast<size_t>(sy) * width + sx) * channels;
+            int* out = block[y * 4 + x];
+            out[0] = texel[0];
+            out[1] = channels >= 3 ? texel[1] : texel[0];
+            out[2] = channels >= 3 ? texel[2] : texel[0];
+            out[3] = channels == 4 ? texel[3] : (channels == 2 ? texel[1] : 255);
+        }
+    }
+}
+
+/**
+ * @brief End points of the block's extent along the principal axis of its first
+ *        dims channels, pulled in by 1/16 of the range against quantisation error.
+ */
+void fitEndpoints(const int block[16][4], int dims, float low[4], float high[4]) {
+    float mean[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < dims; ++c) mean[c] += block[i][c] / 16.0f;
+    }
+    float covariance[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        for (int a = 0; a < dims; ++a) {
+            for (int b = 0; b < dims; ++b) {
+                covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+            }
+        }
+    }
+    // Power iteration from the column of the most varying channel. A fixed start such as
+    // the diagonal is orthogonal to axes like (1, -1, 1, -1) and never leaves them.
+    int widest = 0;
+    for (int c = 1; c < dims; ++c) {
+        if (covariance[c][c] > covariance[widest][widest]) widest = c;
+    }
+    float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    if (covariance[widest][widest] > 1e-6f) {
+        for (int a = 0; a < dims; ++a) axis[a] = covariance[a][widest];
+    }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float length = 0.0f;
+        for (int a = 0; a < dims; ++a) {
+            for (int b = 0; b < dims; ++b) next[a] += covariance[a][b] * axis[b];
+            length = std::max(length, std::abs(next[a]));
+        }
+        if (length < 1e-6f) break;
+        for (int a = 0; a < dims; ++a) axis[a] = next[a] / length;
+    }
+    float axisLength = 0.0f;
+    for (int a = 0; a < dims; ++a) axisLength += axis[a] * axis[a];
+    axisLength = std::sqrt(axisLength);
+    for (int a = 0; a < dims; ++a) axis[a] /= axisLength;
+
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < dims; ++c) t += (block[i][c] - mean[c]) * axis[c];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    float inset = (maxT - minT) / 16.0f;
+    minT += inset;
+    maxT -= inset;
+    for (int c = 0; c < dims; ++c) {
+        low[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+        high[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+    }
+}
+
+uint16_t packRGB565(const float color[4]) {
+    int r = static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRGB565(uint16_t packed, int color[3]) {
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+/// Four-colour BC1 block; also the colour half of BC3.
+void encodeColorBlock(const int block[16][4], unsigned char* out) {
+    float low[4], high[4];
+    fitEndpoints(block, 3, low, high);
+    uint16_t c0 = packRGB565(high), c1 = packRGB565(low);
+    if (c0 < c1) std::swap(c0, c1);
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        unpackRGB565(c0, palette[0]);
+        unpackRGB565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestError = INT32_MAX;
+            for (int p = 0; p < 4; ++p) {
+                int error = 0;
+                for (int c = 0; c < 3; ++c) {
+                    int d = block[i][c] - palette[p][c];
+                    error += d * d;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+    }
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    std::memcpy(out + 4, &indices, 4);
+}
+
+/// Eight-value interpolated alpha half of a BC3 block.
+void encodeAlphaBlock(const int block[16][4], unsigned char* out) {
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i) {
+        a0 = std::max(a0, block[i][3]);
+        a1 = std::min(a1, block[i][3]);
+    }
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        int palette[8] = { a0, a1 };
+        for (int p = 2; p < 8; ++p) {
+            palette[p] = ((8 - p) * a0 + (p - 1) * a1) / 7;
+        }
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestError = INT32_MAX;
+            for (int p = 0; p < 8; ++p) {
+                int error = std::abs(block[i][3] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (3 * i);
+        }
+    }
+    out[0] = static_cast<unsigned char>(a0);
+    out[1] = static_cast<unsigned char>(a1);
+    for (int b = 0; b < 6; ++b) {
+        out[2 + b] = static_cast<unsigned char>(indices >> (8 * b));
+    }
+}
+
+/// Appends bits to a 128-bit block, least significant first.
+struct BlockWriter {
+    uint64_t words[2] = { 0, 0 };
+    int position = 0;
+
+    void write(uint32_t value, int bits) {
+        for (int b = 0; b < bits; ++b, ++position) {
+            words[position >> 6] |= static_cast<uint64_t>((value >> b) & 1) << (position & 63);
+        }
+    }
+};
+
+/// BC7 mode 6: one subset, 7-bit RGBA end points with a shared-per-end-point p-bit.
+void encodeBC7Block(const int block[16][4], unsigned char* out) {
+    float low[4], high[4];
+    fitEndpoints(block, 4, low, high);
+    int endpoint[2][4], pbit[2];
+    const float* ends[2] = { low, high };
+    for (int e = 0; e < 2; ++e) {
+        // Pick the p-bit that reproduces the end point best
+        int bestError = INT32_MAX;
+        for (int p = 0; p < 2; ++p) {
+            int error = 0, quantised[4];
+            for (int c = 0; c < 4; ++c) {
+                quantised[c] = std::clamp(static_cast<int>(std::lround((ends[e][c] - p) / 2.0f)), 0, 127);
+                int d = ((quantised[c] << 1) | p) - static_cast<int>(ends[e][c] + 0.5f);
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                pbit[e] = p;
+                std::copy(quantised, quantised + 4, endpoint[e]);
+            }
+        }
+    }
+    int palette[16][4];
+    for (int p = 0; p < 16; ++p) {
+        for (int c = 0; c < 4; ++c) {
+            int e0 = (endpoint[0][c] << 1) | pbit[0];
+            int e1 = (endpoint[1][c] << 1) | pbit[1];
+            palette[p][c] = ((64 - kBC7Weights[p]) * e0 + kBC7Weights[p] * e1 + 32) >> 6;
+        }
+    }
+    int indices[16];
+    for (int i = 0; i < 16; ++i) {
+        int best = 0, bestError = INT32_MAX;
+        for (int p = 0; p < 16; ++p) {
+            int error = 0;
+            for (int c = 0; c < 4; ++c) {
+                int d = block[i][c] - palette[p][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = p;
+            }
+        }
+        indices[i] = best;
+    }
+    // The first index is stored without its top bit, which must be 0
+    if (indices[0] >= 8) {
+        std::swap(endpoint[0], endpoint[1]);
+        std::swap(pbit[0], pbit[1]);
+        for (int& index : indices) index = 15 - index;
+    }
+
+    BlockWriter writer;
+    writer.write(1u << 6, 7);
+    for (int c = 0; c < 4; ++c) {
+        writer.write(endpoint[0][c], 7);
+        writer.write(endpoint[1][c], 7);
+    }
+    writer.write(pbit[0], 1);
+    writer.write(pbit[1], 1);
+    writer.write(indices[0], 3);
+    for (int i = 1; i < 16; ++i) {
+        writer.write(indices[i], 4);
+    }
+    std::memcpy(out, writer.words, 16);
+}
+
+bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
+
+}
+
+int CompressedTexture::getLevels() const {
+    return static_cast<int>(levelSizes.size());
+}
+
+int CompressedTexture::levelWidth(int level) const {
+    return std::max(1, width >> level);
+}
+
+int CompressedTexture::levelHeight(int level) const {
+    return std::max(1, height >> level);
+}
+
+size_t TextureCompressor::levelBytes(BlockFormat format, int width, int height) {
+    size_t blocks = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4);
+    return blocks * (format == BlockFormat::BC1 ? 8 : 16);
+}
+
+GLenum TextureCompressor::internalFormat(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+bool TextureCompressor::isValidFormat(uint32_t value) {
+    BlockFormat format = static_cast<BlockFormat>(value);
+    return format == BlockFormat::BC1 || format == BlockFormat::BC3 || format == BlockFormat::BC7;
+}
+
+void TextureCompressor::encode(const MipChain& chain, BlockFormat format, CompressedTexture& texture) {
+    texture.format = format;
+    texture.width = chain.width;
+    texture.height = chain.height;
+    texture.levelOffsets.clear();
+    texture.levelSizes.clear();
+    size_t total = 0;
+    for (int level = 0; level < chain.getLevels(); ++level) {
+        texture.levelOffsets.push_back(total);
+        texture.levelSizes.push_back(levelBytes(format, chain.levelWidth(level), chain.levelHeight(level)));
+        total += texture.levelSizes.back();
+    }
+    texture.data.resize(total);
+
+    const size_t blockSize = levelBytes(format, 4, 4);
+    for (int level = 0; level < chain.getLevels(); ++level) {
+        const int width = chain.levelWidth(level), height = chain.levelHeight(level);
+        const int blocksX = (width + 3) / 4;
+        const unsigned char* source = chain.levelData(level);
+        unsigned char* target = texture.data.data() + texture.levelOffsets[level];
+        ThreadPool::getInstance().parallelFor(0, (height + 3) / 4, [&](int by) {
+            int block[16][4];
+            for (int bx = 0; bx < blocksX; ++bx) {
+                fetchBlock(source, width, height, chain.channels, bx, by, block);
+                unsigned char* out = target + (static_cast<size_t>(by) * blocksX + bx) * blockSize;
+                if (format == BlockFormat::BC1) {
+                    encodeColorBlock(block, out);
+                } else if (format == BlockFormat::BC3) {
+                    encodeAlphaBlock(block, out);
+                    encodeColorBlock(block, out + 8);
+                } else {
+                    encodeBC7Block(block, out);
+                }
+            }
+        });
+    }
+}
+
+bool TextureCompressor::compressFile(const std::string& imageFile, const std::string& containerFile,
+                                     BlockFormat format, const ImagePipeline& pipeline) {
+    auto start = std::chrono::steady_clock::now();
+    AssetData encoded = AssetManager::getInstance().readFile(imageFile);
+    int width, height, channels;
+    unsigned char* data = !encoded ? nullptr
+        : stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size), &width, &height, &channels, 0);
+    if (!data) {
+        std::cerr << "ERROR::TEXTURE_COMPRESSION::FAILED_TO_LOAD_IMAGE: " << imageFile << std::endl;
+        return false;
+    }
+    MipChain chain;
+    pipeline.process(data, width, height, channels, true, chain);
+    stbi_image_free(data);
+
+    CompressedTexture texture;
+    encode(chain, format, texture);
+    texture.sourceKey = pipeline.keyFor(encoded.data, encoded.size);
+    if (!writeContainer(containerFile, texture)) {
+        std::cerr << "ERROR::TEXTURE_COMPRESSION::FAILED_TO_WRITE: " << containerFile << std::endl;
+        return false;
+    }
+    double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: " << imageFile << " -> BC" << static_cast<uint32_t>(format) << ", " << texture.getLevels()
+              << " levels, " << chain.texels.size() / 1024 << " KB -> " << texture.data.size() / 1024 << " KB in "
+              << encodeMs << " ms" << std::endl;
+    return true;
+}
+
+bool TextureCompressor::writeContainer(const std::string& containerFile, const CompressedTexture& texture) {
+    std::ofstream file(containerFile, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    ContainerHeader header;
+    std::memcpy(header.tag, kContainerTag, sizeof(header.tag));
+    header.version = kContainerVersion;
+    header.format = static_cast<uint32_t>(texture.format);
+    header.width = texture.width;
+    header.height = texture.height;
+    header.levels = texture.getLevels();
+    header.sourceKey = texture.sourceKey;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t size : texture.levelSizes) {
+        uint64_t bytes = size;
+        file.write(reinterpret_cast<const char*>(&bytes), sizeof(bytes));
+    }
+    file.write(reinterpret_cast<const char*>(texture.data.data()), static_cast<std::streamsize>(texture.data.size()));
+    return static_cast<bool>(file);
+}
+
+bool TextureCompressor::readContainer(const std::string& containerFile, uint64_t sourceKey, CompressedTexture& texture) {
+    // Packed containers are parsed in place from the asset archive; a missing loose
+    // file is the normal case for textures that were never compressed
+    AssetData archived;
+    std::vector<unsigned char> loose;
+    if (!AssetManager::getInstance().findArchived(containerFile, archived)) {
+        std::ifstream file(containerFile, std::ios::binary);
+        if (!file) return false;
+        loose.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const unsigned char* bytes = archived ? archived.data : loose.data();
+    const size_t byteCount = archived ? archived.size : loose.size();
+
+    ContainerHeader header;
+    if (byteCount < sizeof(header)) return false;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (std::memcmp(header.tag, kContainerTag, sizeof(header.tag)) != 0 || header.version != kContainerVersion ||
+        header.sourceKey != sourceKey || header.levels == 0 || header.levels > 32) {
+        return false;
+    }
+    if (!isValidFormat(header.format)) return false;
+    BlockFormat format = static_cast<BlockFormat>(header.format);
+
+    texture.format = format;
+    texture.width = static_cast<int>(header.width);
+    texture.height = static_cast<int>(header.height);
+    texture.sourceKey = header.sourceKey;
+    texture.levelOffsets.clear();
+    texture.levelSizes.clear();
+    size_t cursor = sizeof(header) + header.levels * sizeof(uint64_t);
+    if (byteCount < cursor) return false;
+    size_t total = 0;
+    for (uint32_t level = 0; level < header.levels; ++level) {
+        uint64_t stored;
+        std::memcpy(&stored, bytes + sizeof(header) + level * sizeof(uint64_t), sizeof(stored));
+        size_t expected = levelBytes(format, texture.levelWidth(level), texture.levelHeight(level));
+        if (stored != expected) return false;
+        texture.levelOffsets.push_back(total);
+        texture.levelSizes.push_back(expected);
+        total += expected;
+    }
+    if (byteCount - cursor != total) return false;
+    texture.data.assign(bytes + cursor, bytes + cursor + total);
+    return true;
+}
+
+bool TextureCompressor::isSupported(BlockFormat format) {
+    if (format == BlockFormat::BC7) {
+        return hasExtension("GL_ARB_texture_compression_bptc");
+    }
+    return hasExtension("GL_EXT_texture_compression_s3tc");
+}
+
+void TextureCompressor::upload(const CompressedTexture& texture, GLenum target) {
+    GLenum format = internalFormat(texture.format);
+    for (int level = 0; level < texture.getLevels(); ++level) {
+        glCompressedTexImage2D(target, level, format, texture.levelWidth(level), texture.levelHeight(level), 0,
+                               static_cast<GLsizei>(texture.levelSizes[level]), texture.data.data() + texture.levelOffsets[level]);
+    }
+}
+
+bool TextureCompressor::parseFormat(const std::string& name, BlockFormat& format) {
+    if (name == "bc1") format = BlockFormat::BC1;
+    else if (name == "bc3") format = BlockFormat::BC3;
+    else if (name == "bc7") format = BlockFormat::BC7;
+    else return false;
+    return true;
+}
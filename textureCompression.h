@@ -0,0 +1,115 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <GL/glew.h>
+#include "imagePipeline.h"
+
+/**
+ * @brief Block-compressed formats, 4 x 4 texels per block.
+ */
+enum class BlockFormat : uint32_t {
+    BC1 = 1,   ///< Opaque RGB, 8 bytes per block (8x smaller than RGBA8).
+    BC3 = 3,   ///< RGB plus interpolated alpha, 16 bytes per block.
+    BC7 = 7    ///< RGBA at higher quality, 16 bytes per block (mode 6).
+};
+
+/**
+ * @brief A block-compressed image with its mip chain, finest level first.
+ */
+struct CompressedTexture {
+    BlockFormat format = BlockFormat::BC1;
+    int width = 0;
+    int height = 0;
+    uint64_t sourceKey = 0;               ///< ImagePipeline key of the source image.
+    std::vector<unsigned char> data;      ///< Every level's blocks, tightly packed.
+    std::vector<size_t> levelOffsets;     ///< Start of each level in data.
+    std::vector<size_t> levelSizes;       ///< Bytes of each level.
+
+    int getLevels() const;
+    int levelWidth(int level) const;
+    int levelHeight(int level) const;
+};
+
+/**
+ * @class TextureCompressor
+ * @brief CPU encoder, container files and upload of block-compressed textures.
+ *
+ * Blocks are fitted along the principal axis of their colours and every level is
+ * encoded a block row per task on the thread pool. The container is a small header
+ * with the format, size and the key of the source image, followed by the levels, so
+ * a stale container is detected without decoding the image.
+ */
+class TextureCompressor {
+public:
+    /**
+     * @brief Encodes every level of a mip chain.
+     * @param chain Source levels with 1, 3 or 4 channels.
+     * @param format Block format to encode.
+     * @param texture Receives the blocks.
+     */
+    static void encode(const MipChain& chain, BlockFormat format, CompressedTexture& texture);
+
+    /**
+     * @brief Processes an image with a pipeline, encodes it and writes a container.
+     * @param imageFile Source image.
+     * @param containerFile Container to write.
+     * @param format Block format to encode.
+     * @param pipeline Adjustments the texture is loaded with at run time.
+     * @return True if successful, false otherwise.
+     */
+    static bool compressFile(const std::string& imageFile, const std::string& containerFile,
+                             BlockFormat format, const ImagePipeline& pipeline);
+
+    /**
+     * @brief Reads a container if it was built from the current source image.
+     * @param containerFile Container file.
+     * @param sourceKey Expected ImagePipeline key of the source image.
+     * @param texture Receives the blocks.
+     * @return True if the container exists, is valid and matches the key.
+     */
+    static bool readContainer(const std::string& containerFile, uint64_t sourceKey, CompressedTexture& texture);
+
+    /**
+     * @brief Writes a container, replacing any existing file.
+     * @return True if successful, false otherwise.
+     */
+    static bool writeContainer(const std::string& containerFile, const CompressedTexture& texture);
+
+    /**
+     * @brief Whether the current OpenGL context can sample a format.
+     */
+    static bool isSupported(BlockFormat format);
+
+    /**
+     * @brief Uploads every level with glCompressedTexImage2D to the bound texture.
+     * @param target Texture target, e.g. GL_TEXTURE_2D or a cube map face.
+     */
+    static void upload(const CompressedTexture& texture, GLenum target);
+
+    /**
+     * @brief Bytes of a width x height level in a format.
+     */
+    static size_t levelBytes(BlockFormat format, int width, int height);
+
+    /**
+     * @brief OpenGL internal format of a block format.
+     */
+    static GLenum internalFormat(BlockFormat format);
+
+    /**
+     * @brief Whether a value read from a file is a known block format.
+     */
+    static bool isValidFormat(uint32_t value);
+
+    /**
+     * @brief Parses "bc1", "bc3" or "bc7".
+     * @return False if the name is unknown.
+     */
+    static bool parseFormat(const std::string& name, BlockFormat& format);
+};
+
+#endif // TEXTURE_COMPRESSION_H
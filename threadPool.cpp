@@ -0,0 +1,116 @@
+#include "threadPool.h"
+#include <atomic>
+#include <algorithm>
+
+namespace {
+thread_local bool onWorkerThread = false;   // Set by workerLoop for the thread's lifetime
+}
+
+/**
+ * @brief Retrieves the singleton instance of the ThreadPool.
+ */
+ThreadPool& ThreadPool::getInstance() {
+    static ThreadPool instance;
+    return instance;
+}
+
+// Constructor: one worker per hardware thread besides the caller
+ThreadPool::ThreadPool() : stopping(false) {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    unsigned int workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    for (unsigned int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+// Destructor
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        tasks.push(std::move(task));
+    }
+    queueCondition.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    onWorkerThread = true;
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int)>& body) {
+    if (end <= begin) return;
+    if (end - begin == 1) {
+        body(begin);
+        return;
+    }
+
+    struct Range {
+        std::atomic<int> next;
+        int end;
+        const std::function<void(int)>* body;
+        std::mutex mutex;
+        std::condition_variable done;
+        int active = 0;
+    };
+    auto range = std::make_shared<Range>();
+    range->next = begin;
+    range->end = end;
+    range->body = &body;
+
+    auto run = [](Range& r) {
+        for (int i = r.next++; i < r.end; i = r.next++) {
+            (*r.body)(i);
+        }
+    };
+
+    // Helpers that start after the work is gone return without touching body
+    int helpers = std::min(static_cast<int>(workers.size()), end - begin - 1);
+    for (int h = 0; h < helpers; ++h) {
+        enqueue([range, run]() {
+            {
+                std::lock_guard<std::mutex> lock(range->mutex);
+                if (range->next >= range->end) return;
+                range->active++;
+            }
+            run(*range);
+            {
+                std::lock_guard<std::mutex> lock(range->mutex);
+                range->active--;
+            }
+            range->done.notify_all();
+        });
+    }
+
+    run(*range);
+    std::unique_lock<std::mutex> lock(range->mutex);
+    range->done.wait(lock, [&range] { return range->active == 0; });
+}
+
+int ThreadPool::getThreadCount() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+bool ThreadPool::isWorkerThread() const {
+    return onWorkerThread;
+}
@@ -0,0 +1,80 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+/**
+ * @class ThreadPool
+ * @brief Shared worker threads for CPU-side terrain processing.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Retrieves the singleton instance of the ThreadPool.
+     * @return Reference to the ThreadPool instance.
+     */
+    static ThreadPool& getInstance();
+
+    /**
+     * @brief Queues a task on the worker threads.
+     * @param task Callable to run.
+     * @return Future holding the task's result.
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<decltype(task())> {
+        using Result = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged]() { (*packaged)(); });
+        return result;
+    }
+
+    /**
+     * @brief Runs body(i) for every i in [begin, end) and waits for completion.
+     *
+     * The calling thread takes part in the work, so nested calls from inside a
+     * task cannot deadlock the pool.
+     * @param begin First index.
+     * @param end One past the last index.
+     * @param body Work for a single index.
+     */
+    void parallelFor(int begin, int end, const std::function<void(int)>& body);
+
+    /**
+     * @brief Number of threads that run parallelFor work, including the caller.
+     */
+    int getThreadCount() const;
+
+    /**
+     * @brief Returns true on one of the pool's worker threads, where waiting for a
+     *        queued task could wait for the thread itself.
+     */
+    bool isWorkerThread() const;
+
+private:
+    // Private Constructor and Destructor for Singleton
+    ThreadPool();
+    ~ThreadPool();
+
+    // Delete copy constructor and assignment operator
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> workers;          ///< Worker threads.
+    std::queue<std::function<void()>> tasks;   ///< Pending tasks.
+    std::mutex queueMutex;                     ///< Guards tasks and stopping.
+    std::condition_variable queueCondition;    ///< Signals new tasks.
+    bool stopping;                             ///< Set when the pool shuts down.
+};
+
+#endif // THREAD_POOL_H
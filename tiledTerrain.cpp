@@ -0,0 +1,506 @@
+#include "tiledTerrain.h"
+#include "terrainMesh.h"
+#include "threadPool.h"
+#include "stb_image.h"
+#include "demLoader.h"
+#include "assetManager.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+// Same texture tiling as the single-heightmap terrain
+const float kTextureRepeat = 10.0f;
+// GPU uploads per update, to keep frame times flat while tiles stream in
+const int kMaxTileUploadsPerFrame = 4;
+// Prefetches are skipped while this many loads are queued
+const size_t kMaxPendingTiles = 16;
+// Tiles around each predicted hiker position
+const int kPrefetchRadius = 1;
+}
+
+TiledTerrain::TiledTerrain()
+    : tileSize(128),
+    tilesX(0), tilesZ(0),
+    horizontalScale(1.0f),
+    memoryBudget(256 * 1024 * 1024),
+    viewRadius(2),
+    terrainShader(nullptr),
+    textureID(0),
+    frame(0),
+    focusTile(-1) {}
+
+TiledTerrain::~TiledTerrain() {
+    cleanup();
+}
+
+TileSource TiledTerrain::imageSource(const std::string& heightmapFile, float heightScale) {
+    TileSource result;
+    int imageWidth = 0, imageHeight = 0, nrComponents = 0;
+    AssetData encoded = AssetManager::getInstance().readFile(heightmapFile);
+    unsigned char* data = !encoded ? nullptr
+        : stbi_load_from_memory(encoded.data, static_cast<int>(encoded.size), &imageWidth, &imageHeight, &nrComponents, 1);
+    if (!data) {
+        std::cerr << "ERROR::TILED_TERRAIN::FAILED_TO_LOAD_HEIGHTMAP: " << heightmapFile << std::endl;
+        return result;
+    }
+    auto pixels = std::make_shared<std::vector<unsigned char>>(data, data + imageWidth * imageHeight);
+    stbi_image_free(data);
+
+    result.width = imageWidth;
+    result.height = imageHeight;
+    result.minHeight = 0.0f;
+    result.maxHeight = heightScale;
+    result.read = [pixels, imageWidth, imageHeight, heightScale](int x0, int z0, int columns, int rows, float* out) {
+        for (int z = 0; z < rows; ++z) {
+            int sz = std::clamp(z0 + z, 0, imageHeight - 1);
+            for (int x = 0; x < columns; ++x) {
+                int sx = std::clamp(x0 + x, 0, imageWidth - 1);
+                out[z * columns + x] = (*pixels)[sz * imageWidth + sx] / 255.0f * heightScale;
+            }
+        }
+    };
+    return result;
+}
+
+TileSource TiledTerrain::demSource(const std::string& demFile, float heightScale) {
+    TileSource result;
+    auto dem = std::make_shared<DEMFile>();
+    if (!dem->open(demFile)) {
+        std::cerr << "ERROR::TILED_TERRAIN::FAILED_TO_LOAD_DEM: " << demFile << std::endl;
+        return result;
+    }
+    float low, high;
+    dem->adviseAccess(true);
+    dem->computeRange(low, high);
+    dem->adviseAccess(false);  // Tiles read scattered windows from here on
+    float scale = high > low ? heightScale / (high - low) : 0.0f;
+
+    result.width = dem->getWidth();
+    result.height = dem->getHeight();
+    result.minHeight = 0.0f;
+    result.maxHeight = heightScale;
+    result.read = [dem, low, scale](int x0, int z0, int columns, int rows, float* out) {
+        dem->readWindow(x0, z0, columns, rows, out);
+        for (int i = 0; i < columns * rows; ++i) {
+            out[i] = (out[i] - low) * scale;
+        }
+    };
+    return result;
+}
+
+TileSource TiledTerrain::proceduralSource(const ProceduralSettings& settings, int size) {
+    TileSource result;
+    auto generator = std::make_shared<ProceduralTerrain>(settings);
+    float center = (size - 1) * 0.5f;
+    result.width = size;
+    result.height = size;
+    result.minHeight = 0.0f;
+    result.maxHeight = settings.heightScale;
+    result.read = [generator, center](int x0, int z0, int columns, int rows, float* out) {
+        generator->fill(x0 - center, z0 - center, columns, rows, out);
+    };
+    return result;
+}
+
+bool TiledTerrain::setSource(const TileSource& newSource) {
+    cleanup();
+    if (newSource.width < 2 || newSource.height < 2 || !newSource.read) {
+        std::cerr << "ERROR::TILED_TERRAIN::INVALID_SOURCE" << std::endl;
+        source = TileSource();
+        tilesX = tilesZ = 0;
+        return false;
+    }
+    source = newSource;
+    tilesX = (source.width - 2) / tileSize + 1;
+    tilesZ = (source.height - 2) / tileSize + 1;
+    std::cout << "INFO: Tiled terrain " << source.width << " x " << source.height << " in "
+              << tilesX << " x " << tilesZ << " tiles." << std::endl;
+    return true;
+}
+
+void TiledTerrain::setTileSize(int cells) {
+    // (cells + 1)^2 vertices must be addressable with 16-bit indices
+    tileSize = std::clamp(cells, 2, 255);
+}
+
+void TiledTerrain::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+}
+
+void TiledTerrain::setViewRadius(int tiles) {
+    viewRadius = std::max(0, tiles);
+}
+
+void TiledTerrain::setHorizontalScale(float scale) {
+    horizontalScale = scale;
+}
+
+void TiledTerrain::setShader(Shader* shader) {
+    terrainShader = shader;
+}
+
+void TiledTerrain::setTexture(GLuint texture) {
+    textureID = texture;
+}
+
+int64_t TiledTerrain::tileKey(int tileX, int tileZ) {
+    return (static_cast<int64_t>(tileZ) << 32) | static_cast<uint32_t>(tileX);
+}
+
+bool TiledTerrain::requestTile(int tileX, int tileZ) {
+    if (tileX < 0 || tileZ < 0 || tileX >= tilesX || tileZ >= tilesZ) return false;
+    int64_t key = tileKey(tileX, tileZ);
+    if (tiles.count(key) || pending.count(key)) return false;
+
+    pending[key] = ThreadPool::getInstance().submit([this, tileX, tileZ]() {
+        return buildTile(tileX, tileZ);
+    });
+    return true;
+}
+
+std::unique_ptr<TiledTerrain::TileData> TiledTerrain::buildTile(int tileX, int tileZ) const {
+    auto tile = std::make_unique<TileData>();
+    int x0 = tileX * tileSize;
+    int z0 = tileZ * tileSize;
+    tile->tileX = tileX;
+    tile->tileZ = tileZ;
+    tile->columns = std::min(tileSize, source.width - 1 - x0) + 1;
+    tile->rows = std::min(tileSize, source.height - 1 - z0) + 1;
+
+    // Read the tile with a one-sample apron so edge normals see the neighbouring tiles
+    int apronColumns = tile->columns + 2;
+    int apronRows = tile->rows + 2;
+    std::vector<float> apron(static_cast<size_t>(apronColumns) * apronRows);
+    source.read(x0 - 1, z0 - 1, apronColumns, apronRows, apron.data());
+
+    float halfWidth = (source.width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (source.height - 1) * horizontalScale * 0.5f;
+    std::vector<glm::vec3> positions(apron.size());
+    for (int z = 0; z < apronRows; ++z) {
+        for (int x = 0; x < apronColumns; ++x) {
+            positions[z * apronColumns + x] = glm::vec3(
+                (x0 - 1 + x) * horizontalScale - halfWidth,
+                apron[z * apronColumns + x],
+                (z0 - 1 + z) * horizontalScale - halfDepth
+            );
+        }
+    }
+
+    // Same face-weighted normals as Terrain::calculateNormals
+    std::vector<glm::vec3> normals(apron.size(), glm::vec3(0.0f));
+    for (int z = 0; z < apronRows - 1; ++z) {
+        for (int x = 0; x < apronColumns - 1; ++x) {
+            int i0 = z * apronColumns + x;
+            int i1 = i0 + 1;
+            int i2 = i0 + apronColumns;
+            int i3 = i2 + 1;
+            glm::vec3 normal1 = glm::normalize(glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]));
+            glm::vec3 normal2 = glm::normalize(glm::cross(positions[i3] - positions[i1], positions[i2] - positions[i1]));
+            normals[i0] += normal1;
+            normals[i1] += normal1 + normal2;
+            normals[i2] += normal1 + normal2;
+            normals[i3] += normal2;
+        }
+    }
+
+    tile->heights.resize(static_cast<size_t>(tile->columns) * tile->rows);
+    tile->vertices.resize(tile->heights.size());
+    for (int z = 0; z < tile->rows; ++z) {
+        for (int x = 0; x < tile->columns; ++x) {
+            int a = (z + 1) * apronColumns + (x + 1);
+            int i = z * tile->columns + x;
+            tile->heights[i] = apron[a];
+            tile->vertices[i].Position = positions[a];
+            tile->vertices[i].Normal = glm::normalize(normals[a]);
+            tile->vertices[i].TexCoords = glm::vec2(
+                static_cast<float>(x0 + x) / (source.width - 1) * kTextureRepeat,
+                static_cast<float>(z0 + z) / (source.height - 1) * kTextureRepeat
+            );
+        }
+    }
+    return tile;
+}
+
+const TiledTerrain::TileIndexBuffer& TiledTerrain::indexBufferFor(int columns, int rows) {
+    int64_t key = tileKey(columns, rows);
+    auto found = indexBuffers.find(key);
+    if (found != indexBuffers.end()) return found->second;
+
+    std::vector<GLuint> indices;
+    appendGridTriangles(columns, rows, vertexCacheBandWidth(32), indices);
+    std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+
+    // Uploaded through the copy target; the tile VAOs bind it as their element buffer
+    TileIndexBuffer buffer;
+    glGenBuffers(1, &buffer.ebo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.ebo);
+    glBufferData(GL_COPY_WRITE_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    buffer.count = static_cast<GLsizei>(shortIndices.size());
+    return indexBuffers.emplace(key, buffer).first->second;
+}
+
+void TiledTerrain::insertTile(std::unique_ptr<TileData> data) {
+    int64_t key = tileKey(data->tileX, data->tileZ);
+    const TileIndexBuffer& indexBuffer = indexBufferFor(data->columns, data->rows);
+
+    Tile tile;
+    glGenVertexArrays(1, &tile.vao);
+    glGenBuffers(1, &tile.vbo);
+    glBindVertexArray(tile.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, tile.vbo);
+    glBufferData(GL_ARRAY_BUFFER, data->vertices.size() * sizeof(TerrainVertex), data->vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer.ebo);
+
+    // Same layout as the single-heightmap terrain
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, Normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(TerrainVertex), (void*)offsetof(TerrainVertex, TexCoords));
+    glBindVertexArray(0);
+
+    tile.bytes = data->heights.size() * sizeof(float) + data->vertices.size() * sizeof(TerrainVertex);
+    data->vertices.clear();
+    data->vertices.shrink_to_fit();
+
+#ifdef DEBUG
+    // Shared edges must hold identical samples in both tiles
+    auto checkSeam = [&](const TileData& left, const TileData& right, bool alongX) {
+        int count = alongX ? std::min(left.rows, right.rows) : std::min(left.columns, right.columns);
+        for (int i = 0; i < count; ++i) {
+            float a = alongX ? left.heights[i * left.columns + left.columns - 1]
+                             : left.heights[(left.rows - 1) * left.columns + i];
+            float b = alongX ? right.heights[i * right.columns] : right.heights[i];
+            if (a != b) {
+                std::cerr << "ERROR::TILED_TERRAIN::SEAM_MISMATCH between tiles (" << left.tileX << ", "
+                          << left.tileZ << ") and (" << right.tileX << ", " << right.tileZ << ")" << std::endl;
+                return;
+            }
+        }
+    };
+    auto neighbour = [&](int tileX, int tileZ) -> const TileData* {
+        auto found = tiles.find(tileKey(tileX, tileZ));
+        return found != tiles.end() ? found->second.data.get() : nullptr;
+    };
+    if (const TileData* left = neighbour(data->tileX - 1, data->tileZ)) checkSeam(*left, *data, true);
+    if (const TileData* right = neighbour(data->tileX + 1, data->tileZ)) checkSeam(*data, *right, true);
+    if (const TileData* top = neighbour(data->tileX, data->tileZ - 1)) checkSeam(*top, *data, false);
+    if (const TileData* bottom = neighbour(data->tileX, data->tileZ + 1)) checkSeam(*data, *bottom, false);
+#endif
+
+    tile.data = std::move(data);
+    lru.push_front(key);
+    tile.lruEntry = lru.begin();
+    tile.lastUsedFrame = 0;
+    stats.residentTiles++;
+    stats.residentBytes += tile.bytes;
+    tiles.emplace(key, std::move(tile));
+}
+
+void TiledTerrain::touchTile(Tile& tile) {
+    tile.lastUsedFrame = frame;
+    lru.splice(lru.begin(), lru, tile.lruEntry);
+}
+
+void TiledTerrain::releaseTile(Tile& tile) {
+    glDeleteVertexArrays(1, &tile.vao);
+    glDeleteBuffers(1, &tile.vbo);
+    stats.residentTiles--;
+    stats.residentBytes -= tile.bytes;
+}
+
+void TiledTerrain::evictTiles() {
+    while (stats.residentBytes > memoryBudget && !lru.empty()) {
+        auto found = tiles.find(lru.back());
+        if (found->second.lastUsedFrame == frame) {
+            break;  // Everything left is in use this frame
+        }
+        releaseTile(found->second);
+        tiles.erase(found);
+        lru.pop_back();
+        stats.evicted++;
+    }
+}
+
+void TiledTerrain::update(const glm::vec3& focus, const std::vector<glm::vec3>& lookahead) {
+    frame++;
+    visible.clear();
+    if (tilesX == 0) return;
+
+    // Upload a bounded number of finished tiles
+    int uploads = 0;
+    for (auto it = pending.begin(); it != pending.end() && uploads < kMaxTileUploadsPerFrame;) {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        insertTile(it->second.get());
+        it = pending.erase(it);
+        uploads++;
+    }
+
+    auto tileAt = [this](const glm::vec3& position) {
+        glm::vec2 sample = toSample(position.x, position.z);
+        return glm::ivec2(std::min(static_cast<int>(sample.x) / tileSize, tilesX - 1),
+                          std::min(static_cast<int>(sample.y) / tileSize, tilesZ - 1));
+    };
+
+    // Visible tiles, nearest ring first so they are queued before farther ones
+    glm::ivec2 center = tileAt(focus);
+    focusTile = tileKey(center.x, center.y);
+    for (int ring = 0; ring <= viewRadius; ++ring) {
+        for (int dz = -ring; dz <= ring; ++dz) {
+            for (int dx = -ring; dx <= ring; ++dx) {
+                if (std::max(std::abs(dx), std::abs(dz)) != ring) continue;
+                int tileX = center.x + dx, tileZ = center.y + dz;
+                if (tileX < 0 || tileZ < 0 || tileX >= tilesX || tileZ >= tilesZ) continue;
+                int64_t key = tileKey(tileX, tileZ);
+                auto found = tiles.find(key);
+                if (found != tiles.end()) {
+                    touchTile(found->second);
+                    visible.push_back(key);
+                    stats.hits++;
+                } else if (requestTile(tileX, tileZ)) {
+                    stats.misses++;
+                }
+            }
+        }
+    }
+
+    // Tiles the hiker is about to walk into
+    for (const glm::vec3& position : lookahead) {
+        glm::ivec2 ahead = tileAt(position);
+        for (int dz = -kPrefetchRadius; dz <= kPrefetchRadius; ++dz) {
+            for (int dx = -kPrefetchRadius; dx <= kPrefetchRadius; ++dx) {
+                auto found = tiles.find(tileKey(ahead.x + dx, ahead.y + dz));
+                if (found != tiles.end()) {
+                    touchTile(found->second);
+                } else if (pending.size() < kMaxPendingTiles && requestTile(ahead.x + dx, ahead.y + dz)) {
+                    stats.prefetched++;
+                }
+            }
+        }
+    }
+
+    evictTiles();
+}
+
+bool TiledTerrain::isReady() const {
+    return focusTile >= 0 && tiles.count(focusTile) != 0;
+}
+
+void TiledTerrain::render(const glm::mat4& model, const glm::mat4& view,
+    const glm::mat4& projection, const glm::vec3& cameraPosition) {
+    if (visible.empty() || !terrainShader) {
+        return;
+    }
+    if (!terrainShader->isLoaded()) {
+        std::cerr << "ERROR: Failed to compile and link terrain shader!" << std::endl;
+        std::cerr << terrainShader->getErrorLog() << std::endl;
+        return;
+    }
+    terrainShader->use();
+    terrainShader->setMat4("model", model);
+    terrainShader->setMat4("view", view);
+    terrainShader->setMat4("projection", projection);
+    terrainShader->setVec3("viewPos", cameraPosition);
+    terrainShader->setVec3("lightPos", glm::vec3(100.0f, 100.0f, 500.0f)); // Sunlight position
+    terrainShader->setVec3("lightColor", glm::vec3(1.0f, 1.0f, 0.9f));
+    terrainShader->setFloat("shininess", 24.0f);
+    terrainShader->setFloat("minHeight", source.minHeight);
+    terrainShader->setFloat("maxHeight", source.maxHeight);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    terrainShader->setInt("terrainTexture", 0);
+    // The shader is shared with Terrain; its per-sample textures do not cover tiles
+    Terrain::resetShaderFeatures(*terrainShader);
+
+    for (int64_t key : visible) {
+        const Tile& tile = tiles.at(key);
+        const TileIndexBuffer& indexBuffer = indexBuffers.at(tileKey(tile.data->columns, tile.data->rows));
+        glBindVertexArray(tile.vao);
+        glDrawElements(GL_TRIANGLES, indexBuffer.count, GL_UNSIGNED_SHORT, 0);
+    }
+    glBindVertexArray(0);
+}
+
+glm::vec2 TiledTerrain::toSample(float x, float z) const {
+    float halfWidth = (source.width - 1) * horizontalScale * 0.5f;
+    float halfDepth = (source.height - 1) * horizontalScale * 0.5f;
+    float localX = (x + halfWidth) / horizontalScale;
+    float localZ = (z + halfDepth) / horizontalScale;
+    return glm::vec2(std::clamp(localX, 0.0f, static_cast<float>(source.width - 1)),
+                     std::clamp(localZ, 0.0f, static_cast<float>(source.height - 1)));
+}
+
+float TiledTerrain::getHeightAtPosition(float x, float z) const {
+    if (tilesX == 0) {
+        return 0.0f;
+    }
+    glm::vec2 sample = toSample(x, z);
+    int sampleX = static_cast<int>(sample.x);
+    int sampleZ = static_cast<int>(sample.y);
+    float fx = sample.x - sampleX;
+    float fz = sample.y - sampleZ;
+
+    // The tile owning the cell; its last row/column is shared with the next tile
+    int tileX = std::min(sampleX / tileSize, tilesX - 1);
+    int tileZ = std::min(sampleZ / tileSize, tilesZ - 1);
+    float h[4];
+    auto found = tiles.find(tileKey(tileX, tileZ));
+    if (found != tiles.end()) {
+        const TileData& tile = *found->second.data;
+        int x0 = sampleX - tileX * tileSize;
+        int z0 = sampleZ - tileZ * tileSize;
+        int x1 = std::min(x0 + 1, tile.columns - 1);
+        int z1 = std::min(z0 + 1, tile.rows - 1);
+        h[0] = tile.heights[z0 * tile.columns + x0];
+        h[1] = tile.heights[z0 * tile.columns + x1];
+        h[2] = tile.heights[z1 * tile.columns + x0];
+        h[3] = tile.heights[z1 * tile.columns + x1];
+    } else {
+        source.read(sampleX, sampleZ, 2, 2, h);
+    }
+
+    float h0 = h[0] * (1.0f - fx) + h[1] * fx;
+    float h1 = h[2] * (1.0f - fx) + h[3] * fx;
+    return h0 * (1.0f - fz) + h1 * fz;
+}
+
+int TiledTerrain::getWidth() const {
+    return source.width;
+}
+
+int TiledTerrain::getHeight() const {
+    return source.height;
+}
+
+float TiledTerrain::getHorizontalScale() const {
+    return horizontalScale;
+}
+
+TileCacheStats TiledTerrain::getStats() const {
+    return stats;
+}
+
+void TiledTerrain::cleanup() {
+    for (auto& entry : pending) {
+        entry.second.wait();
+    }
+    pending.clear();
+    for (auto& entry : tiles) {
+        releaseTile(entry.second);
+    }
+    tiles.clear();
+    lru.clear();
+    visible.clear();
+    focusTile = -1;
+    for (auto& entry : indexBuffers) {
+        glDeleteBuffers(1, &entry.second.ebo);
+    }
+    indexBuffers.clear();
+}
@@ -0,0 +1,235 @@
+#ifndef TILED_TERRAIN_H
+#define TILED_TERRAIN_H
+
+#include <vector>
+#include <string>
+#include <list>
+#include <memory>
+#include <future>
+#include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "shader.h"
+#include "terrain.h"
+#include "heightField.h"
+#include "proceduralTerrain.h"
+
+/**
+ * @brief Supplies world height samples to the tiled terrain.
+ */
+struct TileSource {
+    int width = 0;            ///< Samples along x.
+    int height = 0;           ///< Samples along z.
+    float minHeight = 0.0f;   ///< Lowest height the source produces.
+    float maxHeight = 0.0f;   ///< Highest height the source produces.
+    /// Reads a columns x rows window starting at sample (x0, z0) into out, row-major.
+    /// Coordinates outside the world are clamped to its edge. Called from worker threads.
+    std::function<void(int x0, int z0, int columns, int rows, float* out)> read;
+};
+
+/**
+ * @brief Counters of the tile cache.
+ */
+struct TileCacheStats {
+    size_t hits = 0;            ///< Visible tiles that were already resident.
+    size_t misses = 0;          ///< Visible tiles that had to be requested.
+    size_t prefetched = 0;      ///< Tiles requested ahead of the hiker.
+    size_t evicted = 0;         ///< Tiles dropped to stay within the memory budget.
+    size_t residentTiles = 0;   ///< Tiles currently in memory.
+    size_t residentBytes = 0;   ///< CPU + GPU bytes of the resident tiles.
+};
+
+/**
+ * @class TiledTerrain
+ * @brief Terrain world split into independently loaded height tiles.
+ *
+ * Tiles are built on the thread pool, kept in an LRU cache bounded by a memory budget
+ * and drawn with one shared 16-bit index buffer. Neighbouring tiles share their edge
+ * samples and build normals from a one-sample apron, so seams match exactly.
+ */
+class TiledTerrain : public HeightField {
+public:
+    TiledTerrain();
+    ~TiledTerrain();
+
+    /**
+     * @brief Creates a source that serves windows of an 8-bit heightmap image.
+     * @param heightmapFile Path to the heightmap image.
+     * @param heightScale Height of a full-white sample.
+     * @return Source with width/height 0 if the image could not be loaded.
+     */
+    static TileSource imageSource(const std::string& heightmapFile, float heightScale);
+
+    /**
+     * @brief Creates a source that reads windows lazily from a memory-mapped raw DEM.
+     *        Heights are normalised to 0..heightScale like Terrain's DEM loader.
+     * @param demFile Path to the DEM (.r16/.raw, .r32/.f32, .hgt).
+     * @param heightScale Height of the highest sample.
+     * @return Source with width/height 0 if the DEM could not be mapped.
+     */
+    static TileSource demSource(const std::string& demFile, float heightScale);
+
+    /**
+     * @brief Creates a source that generates procedural heights on demand, so the world
+     *        needs no stored heightmap. Reads past the edge continue the noise.
+     * @param settings Noise parameters; the same seed always gives the same world.
+     * @param size Samples per world side.
+     * @return Source of size x size samples centred like Terrain's grid.
+     */
+    static TileSource proceduralSource(const ProceduralSettings& settings, int size);
+
+    /**
+     * @brief Sets the world to stream from and drops every cached tile.
+     * @param source Height source.
+     * @return True if the source has a valid size.
+     */
+    bool setSource(const TileSource& source);
+
+    /**
+     * @brief Sets the number of cells per tile side. Must be set before setSource.
+     * @param cells Cells per side; clamped so tile vertices fit 16-bit indices.
+     */
+    void setTileSize(int cells);
+
+    /**
+     * @brief Sets the memory budget of the tile cache.
+     * @param bytes CPU + GPU bytes the resident tiles may use.
+     */
+    void setMemoryBudget(size_t bytes);
+
+    /**
+     * @brief Sets how many tiles around the focus are kept visible.
+     * @param tiles Radius in tiles.
+     */
+    void setViewRadius(int tiles);
+
+    void setHorizontalScale(float scale);
+    void setShader(Shader* shader);
+    void setTexture(GLuint texture);
+
+    /**
+     * @brief Requests the tiles around the focus, prefetches tiles around the predicted
+     *        positions, uploads finished tiles and evicts tiles over the budget.
+     *        Must be called on the render thread, typically once per frame.
+     * @param focus Current hiker (or camera) position.
+     * @param lookahead Predicted positions, nearest first.
+     */
+    void update(const glm::vec3& focus, const std::vector<glm::vec3>& lookahead);
+
+    /**
+     * @brief Returns true once the tile under the last focus is resident, so the ground
+     *        the hiker stands on can be drawn.
+     */
+    bool isReady() const;
+
+    /**
+     * @brief Renders the resident tiles around the last focus.
+     * @param model Model matrix.
+     * @param view View matrix.
+     * @param projection Projection matrix.
+     * @param cameraPosition Camera position for lighting calculations.
+     */
+    void render(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection, const glm::vec3& cameraPosition);
+
+    /**
+     * @brief Retrieves the height at a world (x, z) position using bilinear interpolation.
+     *        Reads the source directly if the tile is not resident.
+     * @param x X-coordinate.
+     * @param z Z-coordinate.
+     * @return Height value at the given position.
+     */
+    float getHeightAtPosition(float x, float z) const;
+
+    int getWidth() const;
+    int getHeight() const;
+    float getHorizontalScale() const;
+    TileCacheStats getStats() const;
+
+    /**
+     * @brief Waits for pending loads and releases every tile.
+     */
+    void cleanup();
+
+private:
+    /// CPU side of a tile, built on a worker thread.
+    struct TileData {
+        int tileX, tileZ;
+        int columns, rows;                    ///< Samples per side (cells + 1).
+        std::vector<float> heights;           ///< columns x rows heights.
+        std::vector<TerrainVertex> vertices;  ///< Vertices waiting to be uploaded.
+    };
+
+    struct Tile {
+        std::unique_ptr<TileData> data;
+        GLuint vao, vbo;
+        size_t bytes;                         ///< CPU + GPU memory of the tile.
+        uint64_t lastUsedFrame;
+        std::list<int64_t>::iterator lruEntry;
+    };
+
+    struct TileIndexBuffer {
+        GLuint ebo;
+        GLsizei count;
+    };
+
+    TileSource source;
+    int tileSize;                             ///< Cells per tile side.
+    int tilesX, tilesZ;                       ///< Tiles covering the world.
+    float horizontalScale;
+    size_t memoryBudget;
+    int viewRadius;
+    Shader* terrainShader;
+    GLuint textureID;
+    uint64_t frame;
+    std::vector<int64_t> visible;             ///< Tiles drawn this frame.
+    int64_t focusTile;                        ///< Tile under the last focus, or -1.
+    std::unordered_map<int64_t, Tile> tiles;  ///< Resident tiles.
+    std::list<int64_t> lru;                   ///< Resident tiles, most recently used first.
+    std::unordered_map<int64_t, std::future<std::unique_ptr<TileData>>> pending;
+    std::unordered_map<int64_t, TileIndexBuffer> indexBuffers;  ///< Shared per tile shape.
+    TileCacheStats stats;
+
+    static int64_t tileKey(int tileX, int tileZ);
+
+    /**
+     * @brief Queues a tile load on the thread pool unless it is resident or pending.
+     * @return True if a load was queued.
+     */
+    bool requestTile(int tileX, int tileZ);
+
+    /**
+     * @brief Reads the heights of a tile and builds its vertices. Runs on a worker thread.
+     */
+    std::unique_ptr<TileData> buildTile(int tileX, int tileZ) const;
+
+    /**
+     * @brief Uploads a finished tile and adds it to the cache.
+     */
+    void insertTile(std::unique_ptr<TileData> data);
+
+    /**
+     * @brief Marks a tile as used this frame.
+     */
+    void touchTile(Tile& tile);
+
+    /**
+     * @brief Drops least recently used tiles until the cache fits the budget.
+     *        Tiles used this frame are never dropped.
+     */
+    void evictTiles();
+
+    void releaseTile(Tile& tile);
+
+    /**
+     * @brief Index buffer for tiles of the given shape, created on first use.
+     */
+    const TileIndexBuffer& indexBufferFor(int columns, int rows);
+
+    /**
+     * @brief Converts a world position to clamped sample coordinates.
+     */
+    glm::vec2 toSample(float x, float z) const;
+};
+
+#endif // TILED_TERRAIN_H
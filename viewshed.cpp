@@ -0,0 +1,307 @@
+#include "viewshed.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <chrono>
+#include <climits>
+#include <iostream>
+
+namespace {
+// Fixed angular sectors around the observer; a cell's owning sector fits in a byte
+const int kSectorCount = 64;
+const uint8_t kNoOwner = 0xFF;
+const float kTwoPi = 6.28318530718f;
+// Bounds of a sector that marked no cells
+const glm::ivec4 kEmptyBounds(INT_MAX, INT_MAX, INT_MIN, INT_MIN);
+
+void extendBounds(glm::ivec4& bounds, const glm::ivec4& other) {
+    bounds = glm::ivec4(std::min(bounds.x, other.x), std::min(bounds.y, other.y),
+                        std::max(bounds.z, other.z), std::max(bounds.w, other.w));
+}
+}
+
+Viewshed::Viewshed()
+    : heights(nullptr),
+    gridWidth(0), gridHeight(0),
+    horizontalScale(1.0f),
+    eyeHeight(1.8f),        // Same eye level as the first-person camera
+    radius(0),
+    updateDistance(4.0f),
+    sectorsPerUpdate(kSectorCount / 4),   // A full refresh over four updates
+    maskWords(0),
+    nextSector(0),
+    dirtyRegion(kEmptyBounds),
+    hasResult(false),
+    texture(0) {}
+
+Viewshed::~Viewshed() {
+    if (pending.valid()) pending.wait();
+}
+
+void Viewshed::setHeightGrid(const std::vector<float>* grid, int width, int height, float scale) {
+    if (pending.valid()) pending.wait();
+    heights = grid;
+    gridWidth = width;
+    gridHeight = height;
+    horizontalScale = scale;
+    hasResult = false;
+
+    size_t cells = static_cast<size_t>(width) * height;
+    maskWords = (cells + 31) / 32;
+    mask.reset(new std::atomic<uint32_t>[maskWords]);
+    for (size_t i = 0; i < maskWords; ++i) mask[i].store(0, std::memory_order_relaxed);
+    owners.reset(new std::atomic<uint8_t>[cells]);
+    for (size_t i = 0; i < cells; ++i) owners[i].store(kNoOwner, std::memory_order_relaxed);
+    texels.assign(cells, 0);
+    sectorBounds.assign(kSectorCount, kEmptyBounds);
+    sectorObservers.assign(kSectorCount, glm::vec2(0.0f));
+    sectorCast.assign(kSectorCount, false);
+    nextSector = 0;
+    dirtyRegion = kEmptyBounds;
+}
+
+void Viewshed::setEyeHeight(float height) {
+    eyeHeight = height;
+}
+
+void Viewshed::setRadius(int samples) {
+    radius = std::max(0, samples);
+}
+
+void Viewshed::setUpdateDistance(float samples) {
+    updateDistance = samples;
+}
+
+void Viewshed::setSectorsPerUpdate(int sectors) {
+    sectorsPerUpdate = std::clamp(sectors, 1, kSectorCount);
+}
+
+int Viewshed::getSectorCount() {
+    return kSectorCount;
+}
+
+float Viewshed::sampleHeight(float x, float z) const {
+    x = std::clamp(x, 0.0f, static_cast<float>(gridWidth - 1));
+    z = std::clamp(z, 0.0f, static_cast<float>(gridHeight - 1));
+    int x0 = static_cast<int>(x), z0 = static_cast<int>(z);
+    int x1 = std::min(x0 + 1, gridWidth - 1), z1 = std::min(z0 + 1, gridHeight - 1);
+    float fx = x - x0, fz = z - z0;
+    const std::vector<float>& h = *heights;
+    float top = h[z0 * gridWidth + x0] * (1.0f - fx) + h[z0 * gridWidth + x1] * fx;
+    float bottom = h[z1 * gridWidth + x0] * (1.0f - fx) + h[z1 * gridWidth + x1] * fx;
+    return top * (1.0f - fz) + bottom * fz;
+}
+
+int Viewshed::sectorOf(float dx, float dz) const {
+    int sector = static_cast<int>((std::atan2(dz, dx) + kTwoPi * 0.5f) / kTwoPi * kSectorCount);
+    return std::clamp(sector, 0, kSectorCount - 1);
+}
+
+void Viewshed::markVisible(int x, int z, int sector, glm::ivec4& bounds) {
+    size_t cell = static_cast<size_t>(z) * gridWidth + x;
+    mask[cell / 32].fetch_or(1u << (cell % 32), std::memory_order_relaxed);
+    owners[cell].store(static_cast<uint8_t>(sector), std::memory_order_relaxed);
+    extendBounds(bounds, glm::ivec4(x, z, x, z));
+}
+
+void Viewshed::clearSector(int sector) {
+    // Cells marked since by another sector stay; that sector clears them when it is recast
+    const glm::ivec4 bounds = sectorBounds[sector];
+    for (int z = bounds.y; z <= bounds.w; ++z) {
+        for (int x = bounds.x; x <= bounds.z; ++x) {
+            size_t cell = static_cast<size_t>(z) * gridWidth + x;
+            if (owners[cell].load(std::memory_order_relaxed) == sector) {
+                owners[cell].store(kNoOwner, std::memory_order_relaxed);
+                mask[cell / 32].fetch_and(~(1u << (cell % 32)), std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+void Viewshed::castSector(int sector, const std::vector<glm::ivec2>& targets, const glm::ivec2& observerCell,
+                          const glm::vec2& observer, float eyeElevation) {
+    glm::ivec4 bounds = kEmptyBounds;
+    markVisible(observerCell.x, observerCell.y, sector, bounds);
+    for (const glm::ivec2& target : targets) {
+        float dx = target.x - observer.x;
+        float dz = target.y - observer.y;
+        bool alongX = std::fabs(dx) >= std::fabs(dz);
+        float major = alongX ? dx : dz;
+        if (major == 0.0f) continue;
+
+        // Step one column (or row) at a time along the major axis, interpolating
+        // the height between the two cells straddling the ray on the minor axis
+        float start = alongX ? observer.x : observer.y;
+        float end = alongX ? static_cast<float>(target.x) : static_cast<float>(target.y);
+        int step = major > 0.0f ? 1 : -1;
+        int firstLine = major > 0.0f ? static_cast<int>(std::floor(start)) + 1 : static_cast<int>(std::ceil(start)) - 1;
+        float rayLength = std::sqrt(dx * dx + dz * dz) * horizontalScale;
+        float maxSlope = -INFINITY;
+        for (int line = firstLine; step > 0 ? line <= end : line >= end; line += step) {
+            float t = (line - start) / major;
+            float x = alongX ? static_cast<float>(line) : observer.x + t * dx;
+            float z = alongX ? observer.y + t * dz : static_cast<float>(line);
+            float slope = (sampleHeight(x, z) - eyeElevation) / (t * rayLength);
+            if (slope >= maxSlope) {
+                markVisible(static_cast<int>(std::lround(x)), static_cast<int>(std::lround(z)), sector, bounds);
+                maxSlope = slope;
+            }
+        }
+    }
+    sectorBounds[sector] = bounds;
+}
+
+void Viewshed::compute(const glm::vec2& observer) {
+    std::fill(sectorCast.begin(), sectorCast.end(), false);
+    refresh(observer, kSectorCount);
+}
+
+int Viewshed::refresh(const glm::vec2& observer, int maxSectors) {
+    if (!heights || gridWidth < 2 || gridHeight < 2) return 0;
+
+    // Sectors never cast or cast from too far away, round-robin from the last refresh
+    int limit = hasResult ? std::clamp(maxSectors, 1, kSectorCount) : kSectorCount;
+    std::vector<int> stale;
+    std::vector<bool> selected(kSectorCount, false);
+    for (int i = 0; i < kSectorCount && static_cast<int>(stale.size()) < limit; ++i) {
+        int sector = (nextSector + i) % kSectorCount;
+        if (!hasResult || !sectorCast[sector] || glm::distance(sectorObservers[sector], observer) >= updateDistance) {
+            stale.push_back(sector);
+            selected[sector] = true;
+        }
+    }
+    if (stale.empty()) return 0;
+    nextSector = (stale.back() + 1) % kSectorCount;
+
+    // Search square around the observer
+    int ox = std::clamp(static_cast<int>(std::lround(observer.x)), 0, gridWidth - 1);
+    int oz = std::clamp(static_cast<int>(std::lround(observer.y)), 0, gridHeight - 1);
+    glm::ivec4 square(0, 0, gridWidth - 1, gridHeight - 1);
+    if (radius > 0) {
+        square = glm::ivec4(std::max(0, ox - radius), std::max(0, oz - radius),
+                            std::min(gridWidth - 1, ox + radius), std::min(gridHeight - 1, oz + radius));
+    }
+    glm::vec2 clamped(std::clamp(observer.x, 0.0f, static_cast<float>(gridWidth - 1)),
+                      std::clamp(observer.y, 0.0f, static_cast<float>(gridHeight - 1)));
+    float eyeElevation = sampleHeight(clamped.x, clamped.y) + eyeHeight;
+
+    // Border cells of the square, binned by their angle around the observer
+    std::vector<std::vector<glm::ivec2>> targets(kSectorCount);
+    auto addTarget = [&](int x, int z) {
+        int sector = sectorOf(x - clamped.x, z - clamped.y);
+        if (selected[sector]) targets[sector].push_back({ x, z });
+    };
+    for (int x = square.x; x < square.z; ++x) addTarget(x, square.y);
+    for (int z = square.y; z < square.w; ++z) addTarget(square.z, z);
+    for (int x = square.z; x > square.x; --x) addTarget(x, square.w);
+    for (int z = square.w; z > square.y; --z) addTarget(square.x, z);
+
+    // Clear every stale sector before casting any, so no new mark is cleared again
+    glm::ivec4 dirty = kEmptyBounds;
+    for (int sector : stale) extendBounds(dirty, sectorBounds[sector]);
+    ThreadPool& pool = ThreadPool::getInstance();
+    int count = static_cast<int>(stale.size());
+    pool.parallelFor(0, count, [&](int i) { clearSector(stale[i]); });
+    pool.parallelFor(0, count, [&](int i) {
+        castSector(stale[i], targets[stale[i]], glm::ivec2(ox, oz), clamped, eyeElevation);
+    });
+    for (int sector : stale) {
+        extendBounds(dirty, sectorBounds[sector]);
+        sectorObservers[sector] = observer;
+        sectorCast[sector] = true;
+    }
+
+    // Expand the cells of the old and new casts into texels for upload
+    dirtyRegion = dirty;
+    if (dirty.x <= dirty.z) {
+        pool.parallelFor(dirty.y, dirty.w + 1, [this, &dirty](int z) {
+            for (int x = dirty.x; x <= dirty.z; ++x) {
+                texels[static_cast<size_t>(z) * gridWidth + x] = isVisible(x, z) ? 255 : 0;
+            }
+        });
+    }
+    hasResult = true;
+    return count;
+}
+
+bool Viewshed::update(const glm::vec2& observer) {
+    if (!heights) return false;
+
+    if (pending.valid()) {
+        if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return texture != 0;
+        }
+        pending.get();
+        uploadTexture();
+    }
+
+    // Keep showing the current viewshed; recast a few stale sectors per update
+    bool stale = !hasResult;
+    for (int sector = 0; !stale && sector < kSectorCount; ++sector) {
+        stale = !sectorCast[sector] || glm::distance(sectorObservers[sector], observer) >= updateDistance;
+    }
+    if (stale) {
+        int sectors = sectorsPerUpdate;
+        pending = ThreadPool::getInstance().submit([this, observer, sectors]() { refresh(observer, sectors); });
+    }
+    return texture != 0;
+}
+
+void Viewshed::uploadTexture() {
+    if (texture == 0) {
+        // The whole grid once, so texels no refresh has touched yet are defined
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, gridWidth, gridHeight, 0, GL_RED, GL_UNSIGNED_BYTE, texels.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return;
+    }
+    if (dirtyRegion.x > dirtyRegion.z) return;
+
+    // Only the rows and columns touched by the last refresh
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, gridWidth);
+    const unsigned char* first = texels.data() + static_cast<size_t>(dirtyRegion.y) * gridWidth + dirtyRegion.x;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, dirtyRegion.x, dirtyRegion.y,
+                    dirtyRegion.z - dirtyRegion.x + 1, dirtyRegion.w - dirtyRegion.y + 1,
+                    GL_RED, GL_UNSIGNED_BYTE, first);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool Viewshed::isVisible(int x, int z) const {
+    if (x < 0 || z < 0 || x >= gridWidth || z >= gridHeight) return false;
+    size_t cell = static_cast<size_t>(z) * gridWidth + x;
+    return (mask[cell / 32].load(std::memory_order_relaxed) >> (cell % 32)) & 1u;
+}
+
+size_t Viewshed::countVisible() const {
+    size_t count = 0;
+    for (size_t i = 0; i < maskWords; ++i) {
+        count += static_cast<size_t>(std::popcount(mask[i].load(std::memory_order_relaxed)));
+    }
+    return count;
+}
+
+GLuint Viewshed::getTexture() const {
+    return texture;
+}
+
+void Viewshed::cleanup() {
+    if (pending.valid()) {
+        pending.wait();
+        pending = std::future<void>();
+    }
+    if (texture) glDeleteTextures(1, &texture);
+    texture = 0;
+    hasResult = false;
+}
@@ -0,0 +1,155 @@
+#ifndef VIEWSHED_H
+#define VIEWSHED_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <future>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/**
+ * @class Viewshed
+ * @brief Cells of a height grid visible from an observer, as a bitmask and an R8 texture.
+ *
+ * Uses R2 ray casting: one ray per cell on the border of the search square, each
+ * tracking the steepest line of sight so far. Rays are grouped into fixed angular
+ * sectors around the observer that run in parallel on the thread pool. Updates are
+ * incremental: once the observer has moved far enough, each update recasts only a few
+ * of the sectors cast from an older position, in the background, so the cost of a
+ * full recomputation is spread over several frames. Every cell remembers the sector
+ * that last marked it, so a recast sector clears only its own cells, and only the
+ * area of the recast sectors is re-uploaded.
+ */
+class Viewshed {
+public:
+    Viewshed();
+    ~Viewshed();
+
+    /**
+     * @brief Sets the grid to analyse. The heights must outlive the viewshed.
+     * @param heights Row-major heights in world units.
+     * @param width Number of columns.
+     * @param height Number of rows.
+     * @param horizontalScale World distance between neighbouring samples.
+     */
+    void setHeightGrid(const std::vector<float>* heights, int width, int height, float horizontalScale);
+
+    /**
+     * @brief Sets the observer's eye height above the ground.
+     * @param eyeHeight Height in world units.
+     */
+    void setEyeHeight(float eyeHeight);
+
+    /**
+     * @brief Limits the analysis to a square around the observer.
+     * @param samples Half the side of the square in samples, or 0 for the whole grid.
+     */
+    void setRadius(int samples);
+
+    /**
+     * @brief Sets how far the observer must move before a sector is recast.
+     * @param samples Distance in samples.
+     */
+    void setUpdateDistance(float samples);
+
+    /**
+     * @brief Sets how many sectors an update recasts at most.
+     * @param sectors Sectors per update, 1 to getSectorCount().
+     */
+    void setSectorsPerUpdate(int sectors);
+
+    /**
+     * @brief Uploads a finished refresh and starts recasting the next stale sectors if
+     *        the observer has moved far enough. Must be called on the render thread.
+     * @param observer Observer position in sample coordinates.
+     * @return True once the texture holds a viewshed.
+     */
+    bool update(const glm::vec2& observer);
+
+    /**
+     * @brief Computes the whole viewshed on the calling thread (plus the pool) and waits.
+     * @param observer Observer position in sample coordinates.
+     */
+    void compute(const glm::vec2& observer);
+
+    /**
+     * @brief Recasts up to maxSectors of the sectors last cast from farther than the
+     *        update distance, on the calling thread (plus the pool), and waits. Before
+     *        the first computation every sector is cast.
+     * @param observer Observer position in sample coordinates.
+     * @param maxSectors Most sectors to recast.
+     * @return Number of sectors recast.
+     */
+    int refresh(const glm::vec2& observer, int maxSectors);
+
+    /**
+     * @brief Number of angular sectors around the observer.
+     */
+    static int getSectorCount();
+
+    /**
+     * @brief Returns true if a cell was visible in the last computation.
+     */
+    bool isVisible(int x, int z) const;
+
+    /**
+     * @brief Number of visible cells in the last computation.
+     */
+    size_t countVisible() const;
+
+    /**
+     * @brief R8 texture of the last uploaded viewshed (255 = visible), or 0.
+     */
+    GLuint getTexture() const;
+
+    /**
+     * @brief Waits for a running computation and releases the texture.
+     */
+    void cleanup();
+
+private:
+    const std::vector<float>* heights;
+    int gridWidth, gridHeight;
+    float horizontalScale;
+    float eyeHeight;
+    int radius;
+    float updateDistance;
+    int sectorsPerUpdate;
+
+    std::unique_ptr<std::atomic<uint32_t>[]> mask;  ///< One bit per cell, set by any ray.
+    std::unique_ptr<std::atomic<uint8_t>[]> owners; ///< Sector that last marked each cell.
+    size_t maskWords;
+    std::vector<unsigned char> texels;              ///< Texture staging, 0 or 255 per cell.
+    std::vector<glm::ivec4> sectorBounds;           ///< Cells marked by each sector's last cast (x0, z0, x1, z1).
+    std::vector<glm::vec2> sectorObservers;         ///< Observer of each sector's last cast.
+    std::vector<bool> sectorCast;                   ///< Whether each sector has been cast.
+    int nextSector;                                 ///< Where the search for stale sectors starts.
+    glm::ivec4 dirtyRegion;                         ///< Texels changed by the last refresh.
+    std::future<void> pending;
+    bool hasResult;
+    GLuint texture;
+
+    /**
+     * @brief Casts the rays of one angular sector and records the cells it marks.
+     */
+    void castSector(int sector, const std::vector<glm::ivec2>& targets, const glm::ivec2& observerCell,
+                    const glm::vec2& observer, float eyeElevation);
+
+    /**
+     * @brief Clears the cells still owned by a sector from its last cast.
+     */
+    void clearSector(int sector);
+
+    void markVisible(int x, int z, int sector, glm::ivec4& bounds);
+    float sampleHeight(float x, float z) const;
+    int sectorOf(float dx, float dz) const;
+
+    /**
+     * @brief Uploads the dirty region of the texels.
+     */
+    void uploadTexture();
+};
+
+#endif // VIEWSHED_H
@@ -0,0 +1,484 @@
+#include "virtualTexture.h"
+#include "threadPool.h"
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+const char kPageTag[4] = { 'V', 'T', 'P', 'G' };
+const uint32_t kPageVersion = 1;
+const int kBorder = 1;                 // Texels repeated around each page for bilinear filtering
+const size_t kMaxPendingReads = 64;    // Page reads in flight on the thread pool
+const int kUploadsPerFrame = 16;       // Pages copied into the cache per update
+
+struct PageFileHeader {
+    char tag[4];
+    uint32_t version;
+    uint32_t imageWidth, imageHeight;
+    uint32_t pageSize, border;
+    uint32_t pagesX, pagesY;
+    uint32_t levels;
+};
+
+int nextPowerOfTwo(int value) {
+    int power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+
+int log2Floor(int value) {
+    int bits = 0;
+    while (value > 1) {
+        value >>= 1;
+        ++bits;
+    }
+    return bits;
+}
+}
+
+VirtualTexture::VirtualTexture()
+    : imageWidth(0), imageHeight(0), pageSize(0), border(0), slotSize(0), pagesX(0), pagesY(0), levels(0),
+      headerBytes(0), indirectionTexture(0), cacheTexture(0), slotsPerSide(0),
+      worldMin(0.0f), worldMax(1.0f), groundHeight(0.0f), frame(0) {}
+
+VirtualTexture::~VirtualTexture() {
+    cleanup();
+}
+
+bool VirtualTexture::buildPageFile(const std::string& imageFile, const std::string& pageFile, int pageSize) {
+    auto start = std::chrono::steady_clock::now();
+    int width, height, channels;
+    unsigned char* data = stbi_load(imageFile.c_str(), &width, &height, &channels, 4);
+    if (!data) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::FAILED_TO_LOAD_IMAGE: " << imageFile << std::endl;
+        return false;
+    }
+    pageSize = std::max(pageSize, 8);
+    const int pagesX = nextPowerOfTwo((width + pageSize - 1) / pageSize);
+    const int pagesY = nextPowerOfTwo((height + pageSize - 1) / pageSize);
+    // Levels halve both sides until the shorter one is a single page
+    const int levels = log2Floor(std::min(pagesX, pagesY)) + 1;
+    const int slotSize = pageSize + 2 * kBorder;
+
+    // Finest level: the image padded by repeating its last row and column
+    int levelWidth = pagesX * pageSize;
+    int levelHeight = pagesY * pageSize;
+    std::vector<uint32_t> level(static_cast<size_t>(levelWidth) * levelHeight);
+    for (int y = 0; y < levelHeight; ++y) {
+        const unsigned char* row = data + static_cast<size_t>(std::min(y, height - 1)) * width * 4;
+        for (int x = 0; x < levelWidth; ++x) {
+            std::memcpy(&level[static_cast<size_t>(y) * levelWidth + x], row + std::min(x, width - 1) * 4, 4);
+        }
+    }
+    stbi_image_free(data);
+
+    std::ofstream file(pageFile, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::FAILED_TO_WRITE: " << pageFile << std::endl;
+        return false;
+    }
+    PageFileHeader header;
+    std::memcpy(header.tag, kPageTag, sizeof(header.tag));
+    header.version = kPageVersion;
+    header.imageWidth = width;
+    header.imageHeight = height;
+    header.pageSize = pageSize;
+    header.border = kBorder;
+    header.pagesX = pagesX;
+    header.pagesY = pagesY;
+    header.levels = levels;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<uint32_t> slot(static_cast<size_t>(slotSize) * slotSize);
+    size_t pageCount = 0;
+    for (int l = 0; l < levels; ++l) {
+        for (int py = 0; py < (pagesY >> l); ++py) {
+            for (int px = 0; px < (pagesX >> l); ++px) {
+                // Borders repeat the neighbouring pages, or the level's edge
+                for (int sy = 0; sy < slotSize; ++sy) {
+                    int y = std::clamp(py * pageSize + sy - kBorder, 0, levelHeight - 1);
+                    for (int sx = 0; sx < slotSize; ++sx) {
+                        int x = std::clamp(px * pageSize + sx - kBorder, 0, levelWidth - 1);
+                        slot[static_cast<size_t>(sy) * slotSize + sx] = level[static_cast<size_t>(y) * levelWidth + x];
+                    }
+                }
+                file.write(reinterpret_cast<const char*>(slot.data()), static_cast<std::streamsize>(slot.size() * 4));
+                ++pageCount;
+            }
+        }
+        if (l + 1 == levels) break;
+
+        // Next level: 2 x 2 box filter, rows in parallel
+        int nextWidth = levelWidth / 2;
+        int nextHeight = levelHeight / 2;
+        std::vector<uint32_t> next(static_cast<size_t>(nextWidth) * nextHeight);
+        ThreadPool::getInstance().parallelFor(0, nextHeight, [&](int y) {
+            const unsigned char* top = reinterpret_cast<const unsigned char*>(&level[static_cast<size_t>(2 * y) * levelWidth]);
+            const unsigned char* bottom = top + static_cast<size_t>(levelWidth) * 4;
+            unsigned char* out = reinterpret_cast<unsigned char*>(&next[static_cast<size_t>(y) * nextWidth]);
+            for (int x = 0; x < nextWidth; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    int sum = top[8 * x + c] + top[8 * x + 4 + c] + bottom[8 * x + c] + bottom[8 * x + 4 + c];
+                    out[4 * x + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        });
+        level.swap(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+    if (!file) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::FAILED_TO_WRITE: " << pageFile << std::endl;
+        return false;
+    }
+    double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "INFO: Page file " << pageFile << ": " << width << " x " << height << " in " << pageCount
+              << " pages of " << pageSize << " texels over " << levels << " levels, built in " << buildMs << " ms"
+              << std::endl;
+    return true;
+}
+
+bool VirtualTexture::open(const std::string& pageFile, int cacheSlots) {
+    cleanup();
+    if (!pages.open(pageFile)) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::FAILED_TO_OPEN: " << pageFile << std::endl;
+        return false;
+    }
+    PageFileHeader header;
+    if (pages.size() < sizeof(header)) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::INVALID_PAGE_FILE: " << pageFile << std::endl;
+        pages.close();
+        return false;
+    }
+    std::memcpy(&header, pages.data(), sizeof(header));
+    if (std::memcmp(header.tag, kPageTag, sizeof(header.tag)) != 0 || header.version != kPageVersion ||
+        header.pageSize == 0 || header.levels == 0 || header.levels > 16) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::INVALID_PAGE_FILE: " << pageFile << std::endl;
+        pages.close();
+        return false;
+    }
+    imageWidth = static_cast<int>(header.imageWidth);
+    imageHeight = static_cast<int>(header.imageHeight);
+    pageSize = static_cast<int>(header.pageSize);
+    border = static_cast<int>(header.border);
+    slotSize = pageSize + 2 * border;
+    pagesX = static_cast<int>(header.pagesX);
+    pagesY = static_cast<int>(header.pagesY);
+    levels = static_cast<int>(header.levels);
+    headerBytes = sizeof(header);
+    levelStart.assign(levels + 1, 0);
+    for (int l = 0; l < levels; ++l) {
+        levelStart[l + 1] = levelStart[l] + static_cast<size_t>(pagesX >> l) * (pagesY >> l);
+    }
+    if (pages.size() < headerBytes + levelStart[levels] * pageBytes()) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::TRUNCATED_PAGE_FILE: " << pageFile << std::endl;
+        pages.close();
+        return false;
+    }
+    pages.adviseRandom();
+
+    // The coarsest level stays resident, so the cache needs room beyond it
+    int coarsePages = static_cast<int>(levelStart[levels] - levelStart[levels - 1]);
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    int maxSlotsPerSide = std::min(255, std::max(1, static_cast<int>(maxTextureSize) / slotSize));
+    slotsPerSide = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(std::max(cacheSlots, coarsePages + 4)))));
+    slotsPerSide = std::min(slotsPerSide, maxSlotsPerSide);
+    int slotCount = slotsPerSide * slotsPerSide;
+    if (slotCount <= coarsePages) {
+        std::cerr << "ERROR::VIRTUAL_TEXTURE::CACHE_TOO_SMALL: " << pageFile << std::endl;
+        pages.close();
+        return false;
+    }
+    freeSlots.resize(slotCount);
+    for (int s = 0; s < slotCount; ++s) {
+        freeSlots[s] = slotCount - 1 - s;
+    }
+    stats = VirtualTextureStats();
+    stats.cacheSlots = static_cast<size_t>(slotCount);
+
+    glGenTextures(1, &cacheTexture);
+    glBindTexture(GL_TEXTURE_2D, cacheTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, slotsPerSide * slotSize, slotsPerSide * slotSize, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenTextures(1, &indirectionTexture);
+    glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, pagesX, pagesY, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for (int py = 0; py < (pagesY >> (levels - 1)); ++py) {
+        for (int px = 0; px < (pagesX >> (levels - 1)); ++px) {
+            std::vector<unsigned char> texels = readPage(levels - 1, px, py);
+            uploadPage(pageKey(levels - 1, px, py), texels.data(), true);
+        }
+    }
+    wantedLevels.assign(static_cast<size_t>(pagesX) * pagesY, static_cast<uint8_t>(levels - 1));
+    indirection.clear();
+    refreshIndirection();
+    std::cout << "INFO: Virtual texture " << imageWidth << " x " << imageHeight << " with a " << slotCount
+              << "-page cache (" << (static_cast<size_t>(slotsPerSide) * slotSize * slotsPerSide * slotSize * 4 >> 20)
+              << " MB)" << std::endl;
+    return true;
+}
+
+void VirtualTexture::setWorldRect(const glm::vec2& minXZ, const glm::vec2& maxXZ, float height) {
+    worldMin = minXZ;
+    worldMax = maxXZ;
+    groundHeight = height;
+}
+
+uint64_t VirtualTexture::pageKey(int level, int x, int y) {
+    return (static_cast<uint64_t>(level) << 48) | (static_cast<uint64_t>(y) << 24) | static_cast<uint64_t>(x);
+}
+
+size_t VirtualTexture::pageBytes() const {
+    return static_cast<size_t>(slotSize) * slotSize * 4;
+}
+
+std::vector<unsigned char> VirtualTexture::readPage(int level, int x, int y) const {
+    size_t index = levelStart[level] + static_cast<size_t>(y) * (pagesX >> level) + x;
+    const unsigned char* source = pages.data() + headerBytes + index * pageBytes();
+    return std::vector<unsigned char>(source, source + pageBytes());
+}
+
+void VirtualTexture::touch(uint64_t key) {
+    ResidentPage& page = resident[key];
+    if (page.lastUsedFrame == frame) return;
+    page.lastUsedFrame = frame;
+    if (!page.locked) {
+        lru.splice(lru.begin(), lru, page.lruEntry);
+    }
+}
+
+bool VirtualTexture::uploadPage(uint64_t key, const unsigned char* texels, bool locked) {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        // Only pages no part of the ground used this frame may be replaced
+        if (lru.empty() || resident[lru.back()].lastUsedFrame == frame) return false;
+        auto victim = resident.find(lru.back());
+        slot = victim->second.slot;
+        resident.erase(victim);
+        lru.pop_back();
+        stats.evicted++;
+    }
+    glBindTexture(GL_TEXTURE_2D, cacheTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % slotsPerSide) * slotSize, (slot / slotsPerSide) * slotSize,
+                    slotSize, slotSize, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    ResidentPage page;
+    page.slot = slot;
+    page.lastUsedFrame = frame;
+    page.locked = locked;
+    if (!locked) {
+        lru.push_front(key);
+        page.lruEntry = lru.begin();
+    }
+    resident[key] = page;
+    stats.uploaded++;
+    return true;
+}
+
+void VirtualTexture::update(const glm::vec3& cameraPosition, float pixelsPerRadian) {
+    if (!isOpen()) return;
+    ++frame;
+
+    // World size of a finest-level page and of one finest texel
+    glm::vec2 worldSize = worldMax - worldMin;
+    glm::vec2 pageWorld = worldSize * (static_cast<float>(pageSize) / glm::vec2(imageWidth, imageHeight));
+    float texelWorld = std::max(std::abs(worldSize.x) / imageWidth, std::abs(worldSize.y) / imageHeight);
+    float texelsPerPixel = 1.0f / (std::max(pixelsPerRadian, 1.0f) * std::max(texelWorld, 1e-6f));
+
+    // Level per finest page at one texel per pixel
+    std::vector<float> distances(wantedLevels.size(), 0.0f);
+    std::vector<uint8_t> detailLevels(wantedLevels.size(), static_cast<uint8_t>(levels - 1));
+    for (int py = 0; py < pagesY; ++py) {
+        for (int px = 0; px < pagesX; ++px) {
+            // Padding pages outside the image only ever show the coarsest level
+            if (px * pageSize >= imageWidth || py * pageSize >= imageHeight) continue;
+            glm::vec2 pageMin = worldMin + glm::vec2(px, py) * pageWorld;
+            glm::vec2 pageMax = pageMin + pageWorld;
+            float dx = cameraPosition.x - std::clamp(cameraPosition.x, std::min(pageMin.x, pageMax.x), std::max(pageMin.x, pageMax.x));
+            float dz = cameraPosition.z - std::clamp(cameraPosition.z, std::min(pageMin.y, pageMax.y), std::max(pageMin.y, pageMax.y));
+            float dy = cameraPosition.y - groundHeight;
+            size_t index = static_cast<size_t>(py) * pagesX + px;
+            distances[index] = std::sqrt(dx * dx + dy * dy + dz * dz);
+            float ratio = std::max(distances[index] * texelsPerPixel, 1.0f);
+            detailLevels[index] = static_cast<uint8_t>(std::min(levels - 1, static_cast<int>(std::floor(std::log2(ratio)))));
+        }
+    }
+    // Coarsen everything until the pages wanted at once fit the cache, so a view that
+    // needs more detail than the cache holds loses sharpness instead of thrashing
+    const size_t capacity = stats.cacheSlots;
+    std::vector<uint64_t> keys(wantedLevels.size());
+    for (int bias = 0; bias < levels; ++bias) {
+        for (int py = 0; py < pagesY; ++py) {
+            for (int px = 0; px < pagesX; ++px) {
+                size_t index = static_cast<size_t>(py) * pagesX + px;
+                int level = std::min(levels - 1, detailLevels[index] + bias);
+                wantedLevels[index] = static_cast<uint8_t>(level);
+                keys[index] = pageKey(level, px >> level, py >> level);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        if (static_cast<size_t>(std::unique(keys.begin(), keys.end()) - keys.begin()) <= capacity) break;
+    }
+
+    struct Request {
+        int level;
+        float distance;
+        uint64_t key;
+    };
+    std::vector<Request> requests;
+    for (int py = 0; py < pagesY; ++py) {
+        for (int px = 0; px < pagesX; ++px) {
+            size_t index = static_cast<size_t>(py) * pagesX + px;
+            int wanted = wantedLevels[index];
+            uint64_t key = pageKey(wanted, px >> wanted, py >> wanted);
+            if (resident.count(key)) {
+                touch(key);
+                continue;
+            }
+            if (!pending.count(key)) {
+                requests.push_back({ wanted, distances[index], key });
+            }
+            // Keep the fallback the shader samples meanwhile
+            for (int l = wanted + 1; l < levels; ++l) {
+                uint64_t fallback = pageKey(l, px >> l, py >> l);
+                if (resident.count(fallback)) {
+                    touch(fallback);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Queue reads, coarse and near pages first
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+        return a.key < b.key || (a.key == b.key && a.distance < b.distance);
+    });
+    requests.erase(std::unique(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+        return a.key == b.key;
+    }), requests.end());
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+        return a.level != b.level ? a.level > b.level : a.distance < b.distance;
+    });
+    for (const Request& request : requests) {
+        if (pending.size() >= kMaxPendingReads) break;
+        int level = static_cast<int>(request.key >> 48);
+        int x = static_cast<int>(request.key & 0xFFFFFF);
+        int y = static_cast<int>((request.key >> 24) & 0xFFFFFF);
+        pending[request.key] = ThreadPool::getInstance().submit([this, level, x, y]() {
+            return readPage(level, x, y);
+        });
+        stats.requested++;
+    }
+
+    // Upload finished reads within the per-frame budget
+    int uploads = 0;
+    for (auto it = pending.begin(); it != pending.end() && uploads < kUploadsPerFrame;) {
+        if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        std::vector<unsigned char> texels = it->second.get();
+        // A full cache drops the page; it is requested again while still wanted
+        uploadPage(it->first, texels.data(), false);
+        it = pending.erase(it);
+        ++uploads;
+    }
+    stats.residentPages = resident.size();
+    refreshIndirection();
+}
+
+void VirtualTexture::refreshIndirection() {
+    std::vector<unsigned char> entries(static_cast<size_t>(pagesX) * pagesY * 4);
+    for (int py = 0; py < pagesY; ++py) {
+        for (int px = 0; px < pagesX; ++px) {
+            size_t index = static_cast<size_t>(py) * pagesX + px;
+            // Finest resident page at or above the wanted level; the coarsest always is
+            for (int l = wantedLevels[index]; l < levels; ++l) {
+                auto found = resident.find(pageKey(l, px >> l, py >> l));
+                if (found == resident.end()) continue;
+                entries[index * 4 + 0] = static_cast<unsigned char>(found->second.slot % slotsPerSide);
+                entries[index * 4 + 1] = static_cast<unsigned char>(found->second.slot / slotsPerSide);
+                entries[index * 4 + 2] = static_cast<unsigned char>(l);
+                entries[index * 4 + 3] = 255;
+                break;
+            }
+        }
+    }
+    if (entries == indirection) return;
+    indirection.swap(entries);
+    glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pagesX, pagesY, GL_RGBA, GL_UNSIGNED_BYTE, indirection.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void VirtualTexture::bind(Shader& shader, int firstUnit) const {
+    glm::vec2 worldSize = worldMax - worldMin;
+    glm::vec2 virtualTexels(static_cast<float>(pagesX * pageSize), static_cast<float>(pagesY * pageSize));
+    shader.setVec2("colorWorldScale", 1.0f / worldSize);
+    shader.setVec2("colorWorldOffset", -worldMin / worldSize);
+    shader.setVec2("colorImageFraction", glm::vec2(imageWidth, imageHeight) / virtualTexels);
+    shader.setVec2("colorVirtualPages", glm::vec2(pagesX, pagesY));
+    shader.setFloat("colorPageTexels", static_cast<float>(pageSize));
+    shader.setFloat("colorSlotTexels", static_cast<float>(slotSize));
+    shader.setFloat("colorBorder", static_cast<float>(border));
+    shader.setFloat("colorCacheTexels", static_cast<float>(slotsPerSide * slotSize));
+    glActiveTexture(GL_TEXTURE0 + firstUnit);
+    glBindTexture(GL_TEXTURE_2D, indirectionTexture);
+    shader.setInt("colorIndirection", firstUnit);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+    glBindTexture(GL_TEXTURE_2D, cacheTexture);
+    shader.setInt("colorPages", firstUnit + 1);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool VirtualTexture::isOpen() const {
+    return cacheTexture != 0;
+}
+
+int VirtualTexture::getLevels() const {
+    return levels;
+}
+
+VirtualTextureStats VirtualTexture::getStats() const {
+    return stats;
+}
+
+void VirtualTexture::cleanup() {
+    // Reads copy out of the mapping, which must outlive them
+    for (auto& entry : pending) {
+        entry.second.wait();
+    }
+    pending.clear();
+    if (indirectionTexture != 0) glDeleteTextures(1, &indirectionTexture);
+    if (cacheTexture != 0) glDeleteTextures(1, &cacheTexture);
+    indirectionTexture = cacheTexture = 0;
+    resident.clear();
+    lru.clear();
+    freeSlots.clear();
+    wantedLevels.clear();
+    indirection.clear();
+    levelStart.clear();
+    pages.close();
+}
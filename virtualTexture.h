@@ -0,0 +1,152 @@
+#ifndef VIRTUAL_TEXTURE_H
+#define VIRTUAL_TEXTURE_H
+
+#include <vector>
+#include <string>
+#include <list>
+#include <future>
+#include <unordered_map>
+#include <cstdint>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "shader.h"
+#include "mappedFile.h"
+
+/**
+ * @brief Counters of the physical page cache.
+ */
+struct VirtualTextureStats {
+    size_t requested = 0;       ///< Page reads queued on the thread pool.
+    size_t uploaded = 0;        ///< Pages copied into the cache texture.
+    size_t evicted = 0;         ///< Pages dropped to make room.
+    size_t residentPages = 0;   ///< Pages currently in the cache.
+    size_t cacheSlots = 0;      ///< Pages the cache texture holds.
+};
+
+/**
+ * @class VirtualTexture
+ * @brief Image of any size draped over the ground with bounded texture memory.
+ *
+ * An offline step cuts the image and its mip chain into square pages with a one-texel
+ * border and stores them in a page file. At run time the file is memory-mapped; the
+ * pages each part of the ground needs are estimated on the CPU from the camera
+ * distance, read on the thread pool and copied into a fixed-size physical cache
+ * texture whose slots are recycled least recently used first. An indirection texture
+ * with one texel per finest page tells the shader which slot and level to sample;
+ * where the wanted page is not resident yet it points at the closest coarser one. The
+ * coarsest level is loaded up front and never evicted, so every lookup hits.
+ */
+class VirtualTexture {
+public:
+    VirtualTexture();
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    /**
+     * @brief Cuts an image into a page file. The image is padded to a power-of-two
+     *        number of pages per side by repeating its edge texels.
+     * @param imageFile Source image (any format stb_image reads).
+     * @param pageFile Page file to write.
+     * @param pageSize Texels per page side, without the border.
+     * @return True if successful, false otherwise.
+     */
+    static bool buildPageFile(const std::string& imageFile, const std::string& pageFile, int pageSize = 128);
+
+    /**
+     * @brief Maps a page file, creates the cache and indirection textures and loads
+     *        the coarsest level. Requires a current OpenGL context.
+     * @param pageFile Page file written by buildPageFile.
+     * @param cacheSlots Pages the physical cache holds (rounded up to a square).
+     * @return True if successful, false otherwise.
+     */
+    bool open(const std::string& pageFile, int cacheSlots = 256);
+
+    /**
+     * @brief Sets the ground area the image covers. Image row 0 lies along minXZ.y.
+     * @param minXZ World (x, z) of the image's first texel corner.
+     * @param maxXZ World (x, z) of the opposite corner.
+     * @param groundHeight Typical ground height, for camera distances.
+     */
+    void setWorldRect(const glm::vec2& minXZ, const glm::vec2& maxXZ, float groundHeight);
+
+    /**
+     * @brief Picks the level each part of the ground needs, queues missing pages,
+     *        uploads finished ones and refreshes the indirection texture. Must be
+     *        called on the render thread, typically once per frame.
+     * @param cameraPosition Camera position in world space.
+     * @param pixelsPerRadian Screen pixels per radian of view, height / (2 tan(fov / 2)).
+     */
+    void update(const glm::vec3& cameraPosition, float pixelsPerRadian);
+
+    /**
+     * @brief Binds the indirection and cache textures and sets the shader's colorMap
+     *        uniforms.
+     * @param shader Shader to configure; must be in use.
+     * @param firstUnit Texture unit of the indirection texture; the cache uses the next.
+     */
+    void bind(Shader& shader, int firstUnit) const;
+
+    bool isOpen() const;
+    int getLevels() const;
+    VirtualTextureStats getStats() const;
+
+    /**
+     * @brief Waits for pending reads, deletes the textures and unmaps the page file.
+     */
+    void cleanup();
+
+private:
+    struct ResidentPage {
+        int slot;
+        uint64_t lastUsedFrame;
+        bool locked;                          ///< Coarsest level, never evicted.
+        std::list<uint64_t>::iterator lruEntry;
+    };
+
+    MappedFile pages;
+    int imageWidth, imageHeight;
+    int pageSize, border, slotSize;           ///< Slot = page plus border on both sides.
+    int pagesX, pagesY;                       ///< Finest-level pages per side.
+    int levels;
+    std::vector<size_t> levelStart;           ///< Index of each level's first page.
+    size_t headerBytes;
+
+    GLuint indirectionTexture;                ///< One RGBA8 texel per finest page: slot x, slot y, level.
+    GLuint cacheTexture;                      ///< Physical pages, slotsPerSide x slotsPerSide slots.
+    int slotsPerSide;
+    std::vector<int> freeSlots;
+
+    glm::vec2 worldMin, worldMax;
+    float groundHeight;
+    uint64_t frame;
+    std::vector<uint8_t> wantedLevels;        ///< Level each finest page asked for this frame.
+    std::vector<unsigned char> indirection;   ///< CPU copy of the indirection texture.
+    std::unordered_map<uint64_t, ResidentPage> resident;
+    std::list<uint64_t> lru;                  ///< Evictable pages, most recently used first.
+    std::unordered_map<uint64_t, std::future<std::vector<unsigned char>>> pending;
+    VirtualTextureStats stats;
+
+    static uint64_t pageKey(int level, int x, int y);
+
+    /// Bytes of one stored page, border included.
+    size_t pageBytes() const;
+
+    /// Copies a page out of the mapping. Runs on a worker thread.
+    std::vector<unsigned char> readPage(int level, int x, int y) const;
+
+    /// Marks a resident page as used this frame.
+    void touch(uint64_t key);
+
+    /**
+     * @brief Copies a page into a free or least recently used slot.
+     * @return False if every slot is in use this frame.
+     */
+    bool uploadPage(uint64_t key, const unsigned char* texels, bool locked);
+
+    /// Rebuilds the indirection from the wanted levels and uploads it if it changed.
+    void refreshIndirection();
+};
+
+#endif // VIRTUAL_TEXTURE_H